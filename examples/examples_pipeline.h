@@ -0,0 +1,152 @@
+#pragma once
+
+#include "examples_common.h"
+
+#include "../include/pipeline.h"
+#include "../include/util.h"
+#include "../include/worker_thread.h"
+
+namespace examples::pipeline {
+    //
+    //  example 1
+    //
+    inline int Example1()
+    {
+        std::cout << "Pipeline\n";
+
+        small::pipeline<std::string> p;
+        p.add_stage({.threads_count = 2, .bulk_count = 2}, [](std::vector<std::string>& items) {
+            // parse
+            for (auto& item : items) {
+                item = "parsed(" + item + ")";
+            }
+        });
+        p.add_stage({.fuse_with_previous = true}, [](std::vector<std::string>& items) {
+            // validate (on the same threads as parse)
+            std::erase_if(items, [](const auto& item) { return item.find("bad") != std::string::npos; });
+        });
+        p.add_stage({.threads_count = 1, .bulk_count = 4, .channel_size = 8}, [](std::vector<std::string>& items) {
+            // store
+            for (auto& item : items) {
+                std::cout << "thread " << std::this_thread::get_id() << " store " << item << "\n";
+            }
+        });
+        p.start_threads();
+
+        p.push_back("a");
+        p.push_back("bad");
+        p.push_back({"b", "c", "d"});
+
+        // exit is propagated from stage to stage
+        p.wait();
+
+        std::cout << "Pipeline finished\n\n";
+
+        return 0;
+    }
+
+    //
+    //  perf example 2 (4 stages pipeline vs chained worker threads)
+    //
+    inline int Example2_Perf()
+    {
+        std::cout << "Pipeline example 2\n";
+
+        const int  elements   = 1'000'000;
+        const int  bulk_count = 64;
+        const auto work       = [](int& i) {
+            for (int k = 0; k < 16; ++k) {
+                i = i * 31 + 7;
+            }
+        };
+
+        // chained worker threads (each callback pushes each item to the next worker)
+        {
+            auto timeStart = small::time_now();
+
+            std::atomic<long long>    sum{0};
+            small::worker_thread<int> w4({.threads_count = 1, .bulk_count = bulk_count}, [&](auto& /*w*/, const std::vector<int>& items) {
+                long long s = 0;
+                for (auto i : items) {
+                    work(i);
+                    s += i;
+                }
+                sum += s;
+            });
+            small::worker_thread<int> w3({.threads_count = 1, .bulk_count = bulk_count}, [&](auto& /*w*/, const std::vector<int>& items) {
+                for (auto i : items) {
+                    work(i);
+                    w4.push_back(i);
+                }
+            });
+            small::worker_thread<int> w2({.threads_count = 1, .bulk_count = bulk_count}, [&](auto& /*w*/, const std::vector<int>& items) {
+                for (auto i : items) {
+                    work(i);
+                    w3.push_back(i);
+                }
+            });
+            small::worker_thread<int> w1({.threads_count = 1, .bulk_count = bulk_count}, [&](auto& /*w*/, const std::vector<int>& items) {
+                for (auto i : items) {
+                    work(i);
+                    w2.push_back(i);
+                }
+            });
+
+            for (int i = 0; i < elements; ++i) {
+                w1.push_back(i);
+            }
+            w1.wait();
+            w2.wait();
+            w3.wait();
+            w4.wait();
+
+            auto elapsed = small::time_diff_ms(timeStart);
+            std::cout << "Chained worker threads with 4 stages " << elements << " elements"
+                      << " took " << elapsed << " ms"
+                      << ", at a rate of " << double(elements) / double(std::max<>(elapsed, 1LL)) << " elements/ms (sum " << sum << ")\n";
+        }
+
+        // pipeline (batches are handed to the next stage), and the same with all stages fused
+        for (bool fused : {false, true}) {
+            auto timeStart = small::time_now();
+
+            std::atomic<long long> sum{0};
+            small::pipeline<int>   p;
+            for (int stage = 0; stage < 3; ++stage) {
+                p.add_stage({.threads_count = 1, .bulk_count = bulk_count, .fuse_with_previous = fused}, [&](std::vector<int>& items) {
+                    for (auto& i : items) {
+                        work(i);
+                    }
+                });
+            }
+            p.add_stage({.threads_count = 1, .bulk_count = bulk_count, .fuse_with_previous = fused}, [&](std::vector<int>& items) {
+                long long s = 0;
+                for (auto& i : items) {
+                    work(i);
+                    s += i;
+                }
+                sum += s;
+            });
+            p.start_threads();
+
+            for (int i = 0; i < elements; ++i) {
+                p.push_back(i);
+            }
+            p.wait();
+
+            auto elapsed = small::time_diff_ms(timeStart);
+            std::cout << "Pipeline " << (fused ? "fused " : "") << "with 4 stages " << elements << " elements"
+                      << " took " << elapsed << " ms"
+                      << ", at a rate of " << double(elements) / double(std::max<>(elapsed, 1LL)) << " elements/ms (sum " << sum << ")\n";
+        }
+
+        // (on 1 cpu, the pipeline pays one lock for a batch instead of a lock and notify for each item for each stage)
+        // Chained worker threads with 4 stages 1000000 elements took 471 ms, at a rate of 2123.14 elements/ms (sum 12092368608)
+        // Pipeline with 4 stages 1000000 elements took 148 ms, at a rate of 6756.76 elements/ms (sum 12092368608)
+        // Pipeline fused with 4 stages 1000000 elements took 140 ms, at a rate of 7142.86 elements/ms (sum 12092368608)
+
+        std::cout << "Pipeline example 2 finish\n\n";
+
+        return 0;
+    }
+} // namespace examples::pipeline
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <ctime>
+
 #include "examples_common.h"
 
 #include "../include/worker_thread.h"
@@ -95,15 +97,156 @@ namespace examples::worker_thread {
     {
         std::cout << "Worker Thread example 3\n";
 
-        const auto bulks = {1, 2, 5, 10};
+        const auto bulks    = {1, 2, 5, 10};
+        const auto backends = {small::EnumWorkerThreadBackend::kSharedQueue, small::EnumWorkerThreadBackend::kWorkStealing};
+
+        for (auto backend : backends) {
+            for (auto bulk_count : bulks) {
+
+                for (int threads = 1; threads <= 4; ++threads) {
+                    auto timeStart = small::time_now();
+
+                    // create worker
+                    small::worker_thread<int> workers({.threads_count = threads, .bulk_count = bulk_count, .backend = backend}, [](auto& /*w*/ /*this*/, const std::vector<int>& elems) {
+                        // simulate some work
+                        int sum = 0;
+                        for (auto& elem : elems) {
+                            sum += elem;
+                        }
+                        std::ignore = sum;
+                    });
+
+                    // add many entries for worker
+                    const int elements = 100'000;
+                    for (int i = 0; i < elements; ++i) {
+                        workers.push_back(i);
+                    }
+
+                    // wait for processing
+                    workers.wait();
+
+                    // time elapsed
+                    auto elapsed = small::time_diff_ms(timeStart);
+                    std::cout << "Processing " << (backend == small::EnumWorkerThreadBackend::kWorkStealing ? "work stealing " : "")
+                              << "with " << threads << " threads " << elements << " elements and bulk " << bulk_count
+                              << " took " << elapsed << " ms"
+                              << ", at a rate of " << double(elements) / double(std::max<>(elapsed, 1LL)) << " elements/ms\n";
+                }
+                std::cout << "\n";
+            }
+        }
+
+        // Processing with 1 threads 100000 elements and bulk 1 took 8101 ms, at a rate of 12.3442 elements/ms
+        // Processing with 2 threads 100000 elements and bulk 1 took 4162 ms, at a rate of 24.0269 elements/ms
+        // Processing with 3 threads 100000 elements and bulk 1 took 2866 ms, at a rate of 34.8918 elements/ms
+        // Processing with 4 threads 100000 elements and bulk 1 took 2259 ms, at a rate of 44.2674 elements/ms
+
+        // Processing with 1 threads 100000 elements and bulk 2 took 4072 ms, at a rate of 24.558 elements/ms
+        // Processing with 2 threads 100000 elements and bulk 2 took 2166 ms, at a rate of 46.1681 elements/ms
+        // Processing with 3 threads 100000 elements and bulk 2 took 1417 ms, at a rate of 70.5716 elements/ms
+        // Processing with 4 threads 100000 elements and bulk 2 took 1065 ms, at a rate of 93.8967 elements/ms
+
+        // Processing with 1 threads 100000 elements and bulk 5 took 1718 ms, at a rate of 58.2072 elements/ms
+        // Processing with 2 threads 100000 elements and bulk 5 took 849 ms, at a rate of 117.786 elements/ms
+        // Processing with 3 threads 100000 elements and bulk 5 took 548 ms, at a rate of 182.482 elements/ms
+        // Processing with 4 threads 100000 elements and bulk 5 took 470 ms, at a rate of 212.766 elements/ms
+
+        // Processing with 1 threads 100000 elements and bulk 10 took 815 ms, at a rate of 122.699 elements/ms
+        // Processing with 2 threads 100000 elements and bulk 10 took 418 ms, at a rate of 239.234 elements/ms
+        // Processing with 3 threads 100000 elements and bulk 10 took 296 ms, at a rate of 337.838 elements/ms
+        // Processing with 4 threads 100000 elements and bulk 10 took 214 ms, at a rate of 467.29 elements/ms
+
+        // shared queue without the sleep after each batch (idle threads block on the queue)
+        // Processing with 1 threads 100000 elements and bulk 1 took 19 ms, at a rate of 5263.16 elements/ms
+        // Processing with 4 threads 100000 elements and bulk 1 took 33 ms, at a rate of 3030.3 elements/ms
+        // Processing with 1 threads 100000 elements and bulk 10 took 19 ms, at a rate of 5263.16 elements/ms
+        // Processing with 4 threads 100000 elements and bulk 10 took 30 ms, at a rate of 3333.33 elements/ms
+
+        // work stealing (shared queue taken in batches of 4 bulks)
+        // Processing work stealing with 1 threads 100000 elements and bulk 1 took 21 ms, at a rate of 4761.9 elements/ms
+        // Processing work stealing with 4 threads 100000 elements and bulk 1 took 20 ms, at a rate of 5000 elements/ms
+        // Processing work stealing with 1 threads 100000 elements and bulk 10 took 20 ms, at a rate of 5000 elements/ms
+        // Processing work stealing with 4 threads 100000 elements and bulk 10 took 25 ms, at a rate of 4000 elements/ms
+
+        std::cout << "Finished Worker Thread example 3\n\n";
+        // workers will be joined on destructor
+
+        return 0;
+    }
+
+    //
+    //  perf example 4 (keyed mode, items with same key in order and different keys in parallel)
+    //
+    inline int Example4_Perf()
+    {
+        std::cout << "Worker Thread example 4\n";
+
+        using qc = std::pair<int /*key*/, int /*seq*/>;
+
+        const int keys     = 16;
+        const int elements = 5'000;
+
+        for (int threads : {1, 4}) {
+            auto timeStart = small::time_now();
 
-        for (auto bulk_count : bulks) {
+            // create worker
+            small::worker_thread<qc> workers({.threads_count = threads}, [](auto& /*w*/ /*this*/, const std::vector<qc>& /*elems*/) {
+                // simulate some io work
+                small::sleep_micro(100);
+            });
+            if (threads > 1) {
+                workers.set_function_key([](const qc& item) -> std::size_t { return static_cast<std::size_t>(item.first); });
+            }
+
+            // add many entries for worker
+            for (int i = 0; i < elements; ++i) {
+                workers.push_back({i % keys, i});
+            }
+
+            // wait for processing
+            workers.wait();
+
+            // time elapsed
+            auto elapsed = small::time_diff_ms(timeStart);
+            std::cout << "Processing " << (threads > 1 ? "keyed" : "single thread") << " with " << threads << " threads " << elements << " elements"
+                      << " took " << elapsed << " ms"
+                      << ", at a rate of " << double(elements) / double(std::max<>(elapsed, 1LL)) << " elements/ms\n";
+        }
+
+        // Processing single thread with 1 threads 5000 elements took 1086 ms, at a rate of 4.60405 elements/ms
+        // Processing keyed with 4 threads 5000 elements took 201 ms, at a rate of 24.8756 elements/ms
+
+        std::cout << "Finished Worker Thread example 4\n\n";
+
+        return 0;
+    }
+
+    //
+    //  perf example 5
+    //
+    inline int Example5_Perf()
+    {
+        std::cout << "Worker Thread example 5\n";
+
+        struct IdleStrategy
+        {
+            const char* name;
+            int         spin_count;
+            int         yield_count;
+        };
+        const auto strategies = {IdleStrategy{"block", 0, 0}, IdleStrategy{"spin", 10'000, 0}, IdleStrategy{"yield", 0, 1'000}, IdleStrategy{"spin+yield", 1'000, 1'000}};
+
+        const int threads = 2;
+        for (const auto& strategy : strategies) {
+            // first all items at once (throughput) and then items that come one at a time (cpu usage while mostly idle)
+            for (int trickle = 0; trickle <= 1; ++trickle) {
+                const int elements = trickle ? 1'000 : 100'000;
 
-            for (int threads = 1; threads <= 4; ++threads) {
                 auto timeStart = small::time_now();
+                auto cpuStart  = std::clock();
 
                 // create worker
-                small::worker_thread<int> workers({.threads_count = threads, .bulk_count = bulk_count}, [](auto& /*w*/ /*this*/, const std::vector<int>& elems) {
+                small::worker_thread<int> workers({.threads_count = threads, .idle_spin_count = strategy.spin_count, .idle_yield_count = strategy.yield_count}, [](auto& /*w*/ /*this*/, const std::vector<int>& elems) {
                     // simulate some work
                     int sum = 0;
                     for (auto& elem : elems) {
@@ -112,46 +255,420 @@ namespace examples::worker_thread {
                     std::ignore = sum;
                 });
 
-                // add many entries for worker
-                const int elements = 100'000;
+                // add entries for worker
                 for (int i = 0; i < elements; ++i) {
                     workers.push_back(i);
+                    if (trickle) {
+                        small::sleep_micro(100);
+                    }
                 }
 
                 // wait for processing
                 workers.wait();
 
-                // time elapsed
+                // time elapsed and cpu used (by the whole process)
                 auto elapsed = small::time_diff_ms(timeStart);
-                std::cout << "Processing with " << threads << " threads " << elements << " elements and bulk " << bulk_count
+                auto cpu     = (std::clock() - cpuStart) * 1000 / CLOCKS_PER_SEC;
+                std::cout << "Processing " << (trickle ? "one at a time" : "all at once") << " with idle " << strategy.name << " " << threads << " threads " << elements << " elements"
                           << " took " << elapsed << " ms"
-                          << ", at a rate of " << double(elements) / double(std::max<>(elapsed, 1LL)) << " elements/ms\n";
+                          << ", at a rate of " << double(elements) / double(std::max<>(elapsed, 1LL)) << " elements/ms"
+                          << ", cpu " << cpu << " ms\n";
             }
-            std::cout << "\n";
         }
 
-        // Processing with 1 threads 100000 elements and bulk 1 took 8101 ms, at a rate of 12.3442 elements/ms
-        // Processing with 2 threads 100000 elements and bulk 1 took 4162 ms, at a rate of 24.0269 elements/ms
-        // Processing with 3 threads 100000 elements and bulk 1 took 2866 ms, at a rate of 34.8918 elements/ms
-        // Processing with 4 threads 100000 elements and bulk 1 took 2259 ms, at a rate of 44.2674 elements/ms
+        // (cpu is for the whole process, including the thread that pushes, on 1 cpu where a spinning thread competes with the producer)
+        // (the spin only reads the queue size, so an idle thread does not take the lock the producer needs)
+        // Processing all at once with idle block 2 threads 100000 elements took 30 ms, at a rate of 3333.33 elements/ms, cpu 29 ms
+        // Processing one at a time with idle block 2 threads 1000 elements took 180 ms, at a rate of 5.55556 elements/ms, cpu 17 ms
+        // Processing all at once with idle spin 2 threads 100000 elements took 35 ms, at a rate of 2857.14 elements/ms, cpu 33 ms
+        // Processing one at a time with idle spin 2 threads 1000 elements took 162 ms, at a rate of 6.17284 elements/ms, cpu 46 ms
+        // Processing all at once with idle yield 2 threads 100000 elements took 35 ms, at a rate of 2857.14 elements/ms, cpu 34 ms
+        // Processing one at a time with idle yield 2 threads 1000 elements took 160 ms, at a rate of 6.25 elements/ms, cpu 157 ms
+        // Processing all at once with idle spin+yield 2 threads 100000 elements took 35 ms, at a rate of 2857.14 elements/ms, cpu 34 ms
+        // Processing one at a time with idle spin+yield 2 threads 1000 elements took 161 ms, at a rate of 6.21118 elements/ms, cpu 157 ms
 
-        // Processing with 1 threads 100000 elements and bulk 2 took 4072 ms, at a rate of 24.558 elements/ms
-        // Processing with 2 threads 100000 elements and bulk 2 took 2166 ms, at a rate of 46.1681 elements/ms
-        // Processing with 3 threads 100000 elements and bulk 2 took 1417 ms, at a rate of 70.5716 elements/ms
-        // Processing with 4 threads 100000 elements and bulk 2 took 1065 ms, at a rate of 93.8967 elements/ms
+        std::cout << "Finished Worker Thread example 5\n\n";
 
-        // Processing with 1 threads 100000 elements and bulk 5 took 1718 ms, at a rate of 58.2072 elements/ms
-        // Processing with 2 threads 100000 elements and bulk 5 took 849 ms, at a rate of 117.786 elements/ms
-        // Processing with 3 threads 100000 elements and bulk 5 took 548 ms, at a rate of 182.482 elements/ms
-        // Processing with 4 threads 100000 elements and bulk 5 took 470 ms, at a rate of 212.766 elements/ms
+        return 0;
+    }
+    //
+    //  perf example 6 (micro batching with linger and run inline, under light load)
+    //
+    inline int Example6_Perf()
+    {
+        std::cout << "Worker Thread example 6\n";
 
-        // Processing with 1 threads 100000 elements and bulk 10 took 815 ms, at a rate of 122.699 elements/ms
-        // Processing with 2 threads 100000 elements and bulk 10 took 418 ms, at a rate of 239.234 elements/ms
-        // Processing with 3 threads 100000 elements and bulk 10 took 296 ms, at a rate of 337.838 elements/ms
-        // Processing with 4 threads 100000 elements and bulk 10 took 214 ms, at a rate of 467.29 elements/ms
+        using TimePoint = decltype(small::high_time_now());
 
-        std::cout << "Finished Worker Thread example 3\n\n";
-        // workers will be joined on destructor
+        const int elements = 2'000;
+        for (auto [linger, run_inline] : std::vector<std::pair<int, bool>>{{0, false}, {0, true}, {100, false}, {1'000, false}, {5'000, false}}) {
+            auto timeStart = small::time_now();
+
+            std::vector<long long> latencies;
+            int                    calls = 0;
+
+            // create worker
+            small::worker_thread<TimePoint> workers({.threads_count = 1, .bulk_count = 100, .max_batch_delay = std::chrono::microseconds(linger), .run_inline = run_inline}, [&](auto& /*w*/ /*this*/, const std::vector<TimePoint>& elems) {
+                // latency until processing starts
+                for (auto& time : elems) {
+                    latencies.push_back(small::high_time_diff_micro(time));
+                }
+                ++calls;
+                // simulate a downstream call (like a db write) that has a fixed cost
+                small::sleep_micro(100);
+            });
+
+            // add entries for worker slower than they can be processed
+            for (int i = 0; i < elements; ++i) {
+                workers.push_back(small::high_time_now());
+                small::sleep_micro(200);
+            }
+
+            // wait for processing
+            workers.wait();
+
+            // time elapsed
+            auto elapsed = small::time_diff_ms(timeStart);
+
+            std::sort(latencies.begin(), latencies.end());
+            auto percentile = [&latencies](double p) { return latencies.empty() ? 0LL : latencies[static_cast<std::size_t>(p * double(latencies.size() - 1))]; };
+            std::cout << "Processing with linger " << linger << " us" << (run_inline ? " inline " : " ") << elements << " elements"
+                      << " took " << elapsed << " ms"
+                      << ", at a rate of " << double(elements) / double(std::max<>(elapsed, 1LL)) << " elements/ms"
+                      << ", calls " << calls << " (avg batch " << double(elements) / double(std::max<>(calls, 1)) << ")"
+                      << ", latency p50 " << percentile(0.5) << " us"
+                      << ", p99 " << percentile(0.99) << " us\n";
+        }
+
+        // (the rate is limited by how fast items are added, the gain is in the number of downstream calls)
+        // (with run inline there is no enqueue and wake up so the latency is lower, but the processing time is paid by the pushing thread)
+        // Processing with linger 0 us 2000 elements took 524 ms, at a rate of 3.81679 elements/ms, calls 2000 (avg batch 1), latency p50 7 us, p99 14 us
+        // Processing with linger 0 us inline 2000 elements took 865 ms, at a rate of 2.31214 elements/ms, calls 2000 (avg batch 1), latency p50 0 us, p99 3 us
+        // Processing with linger 100 us 2000 elements took 499 ms, at a rate of 4.00802 elements/ms, calls 1672 (avg batch 1.19617), latency p50 264 us, p99 336 us
+        // Processing with linger 1000 us 2000 elements took 579 ms, at a rate of 3.45423 elements/ms, calls 453 (avg batch 4.41501), latency p50 710 us, p99 1641 us
+        // Processing with linger 5000 us 2000 elements took 637 ms, at a rate of 3.13972 elements/ms, calls 115 (avg batch 17.3913), latency p50 2852 us, p99 8735 us
+
+        std::cout << "Finished Worker Thread example 6\n\n";
+
+        return 0;
+    }
+    //
+    //  perf example 7 (fixed vs adaptive threads and bulk count)
+    //
+    inline int Example7_Perf()
+    {
+        std::cout << "Worker Thread example 7\n";
+
+        struct Setting
+        {
+            const char*                 name;
+            small::config_worker_thread config;
+        };
+        const auto settings = {Setting{"fixed 1 thread bulk 1", {.threads_count = 1, .bulk_count = 1}},
+                               Setting{"fixed 4 threads bulk 16", {.threads_count = 4, .bulk_count = 16}},
+                               Setting{"adaptive 1-4 threads bulk 1-64", {.threads_count = 1, .bulk_count = 1, .threads_max = 4, .bulk_count_max = 64, .target_batch_time = std::chrono::milliseconds(2)}}};
+
+        for (const auto& setting : settings) {
+            auto timeStart = small::time_now();
+
+            // create worker
+            small::worker_thread<int> workers(setting.config, [](auto& /*w*/ /*this*/, const std::vector<int>& elems) {
+                // simulate a downstream call with a fixed cost and a cost per item
+                small::sleep_micro(200 + static_cast<int>(elems.size()) * 10);
+            });
+
+            // a burst of items
+            const int elements = 10'000;
+            for (int i = 0; i < elements; ++i) {
+                workers.push_back(i);
+            }
+
+            // see the current settings while processing
+            small::sleep(100);
+            auto threads_active = workers.threads_active();
+            auto bulk_count     = workers.bulk_count_active();
+
+            // wait for processing
+            workers.wait();
+
+            // time elapsed
+            auto elapsed = small::time_diff_ms(timeStart);
+            std::cout << "Processing " << setting.name << " " << elements << " elements"
+                      << " took " << elapsed << " ms"
+                      << ", at a rate of " << double(elements) / double(std::max<>(elapsed, 1LL)) << " elements/ms"
+                      << " (after 100 ms threads " << threads_active << ", bulk " << bulk_count << ")\n";
+        }
+
+        // Processing fixed 1 thread bulk 1 10000 elements took 3371 ms, at a rate of 2.96648 elements/ms (after 100 ms threads 1, bulk 1)
+        // Processing fixed 4 threads bulk 16 10000 elements took 101 ms, at a rate of 99.0099 elements/ms (after 100 ms threads 4, bulk 16)
+        // Processing adaptive 1-4 threads bulk 1-64 10000 elements took 104 ms, at a rate of 96.1538 elements/ms (after 100 ms threads 4, bulk 64)
+
+        std::cout << "Finished Worker Thread example 7\n\n";
+
+        return 0;
+    }
+    //
+    //  perf example 8 (std::function processing vs callable type known at compile time)
+    //
+    inline int Example8_Perf()
+    {
+        std::cout << "Worker Thread example 8\n";
+
+        const int elements = 1'000'000;
+        for (auto bulk_count : {1, 100}) {
+            for (int direct = 0; direct <= 1; ++direct) {
+                std::atomic<long long> sum{0};
+
+                auto timeStart = small::high_time_now();
+                if (direct) {
+                    auto workers = small::make_worker_thread<int>({.threads_count = 1, .bulk_count = bulk_count}, [&sum](auto& /*w*/ /*this*/, std::vector<int>&& elems) {
+                        long long s = 0;
+                        for (auto& elem : elems) {
+                            s += elem;
+                        }
+                        sum += s;
+                    });
+                    for (int i = 0; i < elements; ++i) {
+                        workers.push_back(i);
+                    }
+                    workers.wait();
+                } else {
+                    small::worker_thread<int> workers({.threads_count = 1, .bulk_count = bulk_count}, [&sum](auto& /*w*/ /*this*/, const std::vector<int>& elems) {
+                        long long s = 0;
+                        for (auto& elem : elems) {
+                            s += elem;
+                        }
+                        sum += s;
+                    });
+                    for (int i = 0; i < elements; ++i) {
+                        workers.push_back(i);
+                    }
+                    workers.wait();
+                }
+
+                // time elapsed
+                auto elapsed = small::high_time_diff_nano(timeStart);
+                std::cout << "Processing " << (direct ? "direct call" : "std::function") << " with bulk " << bulk_count << " " << elements << " elements"
+                          << " took " << elapsed / 1'000'000 << " ms"
+                          << ", " << double(elapsed) / double(elements) << " ns/element\n";
+            }
+        }
+
+        // (the cost is dominated by the queue, the call itself is a small part of it)
+        // Processing std::function with bulk 1 1000000 elements took 260 ms, 260.003 ns/element
+        // Processing direct call with bulk 1 1000000 elements took 246 ms, 246.923 ns/element
+        // Processing std::function with bulk 100 1000000 elements took 154 ms, 154.969 ns/element
+        // Processing direct call with bulk 100 1000000 elements took 149 ms, 149.773 ns/element
+
+        std::cout << "Finished Worker Thread example 8\n\n";
+
+        return 0;
+    }
+    //
+    //  perf example 9 (threads pinned to cpus or free to migrate)
+    //  (to see the cache misses and migrations run it with 'perf stat -e cache-misses,cpu-migrations')
+    //
+    inline int Example9_Perf()
+    {
+        std::cout << "Worker Thread example 9\n";
+
+        const int threads  = std::max<>(static_cast<int>(std::thread::hardware_concurrency()), 1);
+        const int elements = 20'000;
+        for (int pinned = 0; pinned <= 1; ++pinned) {
+            auto timeStart = small::time_now();
+
+            small::config_worker_thread config{.threads_count = threads, .thread_name = "example9"};
+            if (pinned) {
+                config.cpus            = small::all_cpus();
+                config.pin_each_thread = true;
+            }
+
+            // create worker
+            small::worker_thread<int> workers(config, [](auto& /*w*/ /*this*/, const std::vector<int>& elems) {
+                // each thread works on its own data (256KB) that should stay in the cache of its cpu
+                static thread_local std::vector<int> data(64 * 1024);
+                for (auto& elem : elems) {
+                    for (std::size_t i = 0; i < data.size(); i += 16) {
+                        data[i] += elem;
+                    }
+                }
+            });
+
+            for (int i = 0; i < elements; ++i) {
+                workers.push_back(i);
+            }
+
+            // wait for processing
+            workers.wait();
+
+            // time elapsed
+            auto elapsed = small::time_diff_ms(timeStart);
+            std::cout << "Processing " << (pinned ? "pinned" : "not pinned") << " with " << threads << " threads " << elements << " elements"
+                      << " took " << elapsed << " ms"
+                      << ", at a rate of " << double(elements) / double(std::max<>(elapsed, 1LL)) << " elements/ms\n";
+        }
+
+        // (on a machine with only 1 cpu there is no difference, the gain is visible with many cpus and more on multiple numa nodes)
+        // Processing not pinned with 1 threads 20000 elements took 160 ms, at a rate of 125 elements/ms
+        // Processing pinned with 1 threads 20000 elements took 158 ms, at a rate of 126.582 elements/ms
+
+        std::cout << "Finished Worker Thread example 9\n\n";
+
+        return 0;
+    }
+
+    //
+    // example 10 (how long it takes to create the worker and start the threads)
+    //
+    inline int Example10_Perf()
+    {
+        std::cout << "Worker Thread example 10\n";
+
+        const int iterations = 50;
+        for (int threads : {1, 8, 32, 64}) {
+            long long create_micro = 0;
+            long long start_micro  = 0;
+            long long wait_micro   = 0;
+            for (int iteration = 0; iteration < iterations; ++iteration) {
+                auto timeStart = small::high_time_now();
+
+                // create worker (threads are manually started)
+                small::worker_thread<int> workers({.threads_count = 0}, [](auto& /*w*/ /*this*/, const std::vector<int>& /*elems*/) {});
+                create_micro += small::high_time_diff_micro(timeStart);
+
+                timeStart = small::high_time_now();
+                workers.start_threads(threads);
+                start_micro += small::high_time_diff_micro(timeStart);
+
+                timeStart = small::high_time_now();
+                workers.wait();
+                wait_micro += small::high_time_diff_micro(timeStart);
+            }
+
+            std::cout << "Worker with " << threads << " threads"
+                      << ", create took " << double(create_micro) / iterations << " us"
+                      << ", start_threads took " << double(start_micro) / iterations << " us"
+                      << ", wait took " << double(wait_micro) / iterations << " us\n";
+        }
+
+        // (threads are owned jthreads, with std::async starting took about the same but wait took more, 2384 us for 64 threads)
+        // Worker with 1 threads, create took 0.26 us, start_threads took 18.42 us, wait took 40.32 us
+        // Worker with 8 threads, create took 0.02 us, start_threads took 212.22 us, wait took 219.24 us
+        // Worker with 32 threads, create took 0.94 us, start_threads took 818.46 us, wait took 851.1 us
+        // Worker with 64 threads, create took 2.36 us, start_threads took 1967.72 us, wait took 1610.18 us
+
+        std::cout << "Finished Worker Thread example 10\n\n";
+
+        return 0;
+    }
+
+    //
+    // example 11 (round trip latency with small::future from submit vs std::promise inside the item)
+    //
+    inline int Example11_Perf()
+    {
+        std::cout << "Worker Thread example 11\n";
+
+        const int elements = 100'000;
+
+        // std::promise inside the item (the shared state is allocated for each item)
+        {
+            using Item   = std::pair<int, std::promise<int>>;
+            auto workers = small::make_worker_thread<Item>({.threads_count = 1}, [](auto& /*w*/ /*this*/, std::vector<Item>&& items) {
+                for (auto& [request, promise] : items) {
+                    promise.set_value(request * 2);
+                }
+            });
+
+            long long sum       = 0;
+            auto      timeStart = small::high_time_now();
+            for (int i = 0; i < elements; ++i) {
+                std::promise<int> promise;
+                auto              future = promise.get_future();
+                workers.push_back({i, std::move(promise)});
+                sum += future.get();
+            }
+            auto elapsed = small::high_time_diff_micro(timeStart);
+            std::cout << "Round trip with std::promise " << elements << " elements"
+                      << " took " << elapsed / 1000 << " ms"
+                      << ", " << double(elapsed) / elements << " us/element (sum " << sum << ")\n";
+
+            // push all then get all
+            std::vector<std::future<int>> futures;
+            futures.reserve(elements);
+            sum       = 0;
+            timeStart = small::high_time_now();
+            for (int i = 0; i < elements; ++i) {
+                std::promise<int> promise;
+                futures.push_back(promise.get_future());
+                workers.push_back({i, std::move(promise)});
+            }
+            for (auto& future : futures) {
+                sum += future.get();
+            }
+            elapsed = small::high_time_diff_micro(timeStart);
+            std::cout << "Push all then get with std::promise " << elements << " elements"
+                      << " took " << elapsed / 1000 << " ms"
+                      << ", " << double(elapsed) / elements << " us/element (sum " << sum << ")\n";
+        }
+
+        // submit with small::future (the shared state is taken from a pool)
+        {
+            using Item   = small::submit_item<int, int>;
+            auto workers = small::make_worker_thread<Item>({.threads_count = 1}, [](auto& /*w*/ /*this*/, std::vector<Item>&& items) {
+                for (auto& item : items) {
+                    item.m_promise.set_value(item.m_request * 2);
+                }
+            });
+
+            long long sum       = 0;
+            auto      timeStart = small::high_time_now();
+            for (int i = 0; i < elements; ++i) {
+                sum += workers.submit(i).get();
+            }
+            auto elapsed = small::high_time_diff_micro(timeStart);
+            std::cout << "Round trip with submit " << elements << " elements"
+                      << " took " << elapsed / 1000 << " ms"
+                      << ", " << double(elapsed) / elements << " us/element (sum " << sum << ")\n";
+
+            // submit all then get all
+            std::vector<small::future<int>> futures;
+            futures.reserve(elements);
+            sum       = 0;
+            timeStart = small::high_time_now();
+            for (int i = 0; i < elements; ++i) {
+                futures.push_back(workers.submit(i));
+            }
+            for (auto& future : futures) {
+                sum += future.get();
+            }
+            elapsed = small::high_time_diff_micro(timeStart);
+            std::cout << "Submit all then get " << elements << " elements"
+                      << " took " << elapsed / 1000 << " ms"
+                      << ", " << double(elapsed) / elements << " us/element (sum " << sum << ")\n";
+
+            // with continuations (run inline on the worker thread)
+            std::atomic<long long> sum_then{0};
+            timeStart = small::high_time_now();
+            for (int i = 0; i < elements; ++i) {
+                workers.submit(i).then([&sum_then](small::future<int>& ready) { sum_then += ready.get(); });
+            }
+            workers.wait();
+            elapsed = small::high_time_diff_micro(timeStart);
+            std::cout << "Submit with then " << elements << " elements"
+                      << " took " << elapsed / 1000 << " ms"
+                      << ", " << double(elapsed) / elements << " us/element (sum " << sum_then << ")\n";
+        }
+
+        // (on 1 cpu, a blocking round trip is slower than std::future which waits directly on a futex,
+        //  but when the futures are not waited one by one there is no allocation for each item and the continuations run inline)
+        // Round trip with std::promise 100000 elements took 523 ms, 5.23736 us/element (sum 9999900000)
+        // Push all then get with std::promise 100000 elements took 149 ms, 1.49617 us/element (sum 9999900000)
+        // Round trip with submit 100000 elements took 680 ms, 6.80937 us/element (sum 9999900000)
+        // Submit all then get 100000 elements took 53 ms, 0.53333 us/element (sum 9999900000)
+        // Submit with then 100000 elements took 45 ms, 0.45909 us/element (sum 9999900000)
+
+        std::cout << "Finished Worker Thread example 11\n\n";
 
         return 0;
     }
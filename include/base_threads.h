@@ -0,0 +1,216 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stop_token>
+#include <thread>
+
+#if defined(__linux__) || defined(__APPLE__)
+#include <pthread.h>
+#endif
+
+namespace small {
+    //
+    // threads configuration
+    //
+    struct config_threads
+    {
+        std::size_t              stack_size{0};          // stack size of the threads (0 means default, only on posix)
+        std::function<void(int)> function_thread_init{}; // called on each thread (with its index) before processing (for thread local setup, tracing, etc)
+        std::function<void(int)> function_thread_exit{}; // called on each thread (with its index) when it exits
+    };
+
+    //
+    // helper class that owns threads (parent caller must stop the threads function, when stop is requested it is used as signal)
+    // - the thread function is called with the stop token and if it throws it is called again (and the exception is counted)
+    // - waiting for the threads to finish can be done with timeout
+    //
+    // small::base_threads threads;
+    // threads.start(config, [](std::stop_token stop, int index) { ... });
+    // ...
+    // threads.wait_until(...);
+    // threads.join();
+    //
+    class base_threads
+    {
+    public:
+        //
+        // base_threads
+        //
+        base_threads() = default;
+
+        ~base_threads()
+        {
+            m_stop_source.request_stop();
+            join();
+        }
+
+        // clang-format off
+        // how many threads were started
+        inline std::size_t  size                () const { return m_threads.size(); }
+        // how many are still running
+        inline int          count_running       () const { return m_running.load(); }
+        // how many exceptions were thrown from the threads functions
+        inline std::size_t  count_exceptions    () const { return m_count_exceptions.load(); }
+        // the last exception thrown from the threads functions
+        inline std::exception_ptr last_exception()       { std::unique_lock l(m_lock); return m_last_exception; }
+        // stop token of the threads
+        inline std::stop_token  get_stop_token  () const { return m_stop_source.get_token(); }
+        // signal stop (the thread function must check the stop token or register a stop callback)
+        inline void         request_stop        ()       { m_stop_source.request_stop(); }
+        // clang-format on
+
+        //
+        // start a new thread (with index = size())
+        //
+        template <typename _Callable>
+        inline void start(const config_threads& config, _Callable function)
+        {
+            const int index = static_cast<int>(m_threads.size());
+            m_running.fetch_add(1);
+
+            auto thread_function = [this, config, index, function = std::move(function)]() mutable {
+                run(config, index, function);
+            };
+
+#if defined(__linux__) || defined(__APPLE__)
+            if (config.stack_size) {
+                m_threads.emplace_back().start_posix(config.stack_size, std::move(thread_function));
+                return;
+            }
+#endif
+            m_threads.emplace_back().m_jthread = std::jthread(std::move(thread_function));
+        }
+
+        //
+        // wait for the threads to finish (they must be signaled before)
+        //
+        inline void wait()
+        {
+            std::unique_lock l(m_lock);
+            m_condition.wait(l, [this]() { return m_running.load() == 0; });
+        }
+
+        // returns false on timeout
+        template <typename _Clock, typename _Duration>
+        inline bool wait_until(const std::chrono::time_point<_Clock, _Duration>& __atime)
+        {
+            std::unique_lock l(m_lock);
+            return m_condition.wait_until(l, __atime, [this]() { return m_running.load() == 0; });
+        }
+
+        //
+        // join all threads
+        //
+        inline void join()
+        {
+            for (auto& thread : m_threads) {
+                thread.join();
+            }
+        }
+
+    private:
+        // call the thread function (again if it throws)
+        template <typename _Callable>
+        inline void run(const config_threads& config, const int index, _Callable& function)
+        {
+            if (config.function_thread_init) {
+                config.function_thread_init(index);
+            }
+
+            auto stop_token = m_stop_source.get_token();
+            for (bool finished = false; !finished && !stop_token.stop_requested();) {
+                try {
+                    function(stop_token, index);
+                    finished = true;
+                } catch (...) {
+                    std::unique_lock l(m_lock);
+                    ++m_count_exceptions;
+                    m_last_exception = std::current_exception();
+                }
+            }
+
+            if (config.function_thread_exit) {
+                config.function_thread_exit(index);
+            }
+
+            std::unique_lock l(m_lock);
+            m_running.fetch_sub(1);
+            m_condition.notify_all();
+        }
+
+        // a std::jthread or a posix thread (when stack size is set)
+        struct Thread
+        {
+            std::jthread m_jthread;
+#if defined(__linux__) || defined(__APPLE__)
+            pthread_t m_pthread{};
+            bool      m_is_pthread{false};
+
+            template <typename _Callable>
+            inline void start_posix(const std::size_t stack_size, _Callable&& function)
+            {
+                using FunctionT = std::decay_t<_Callable>;
+
+                pthread_attr_t attr;
+                pthread_attr_init(&attr);
+                pthread_attr_setstacksize(&attr, stack_size);
+
+                auto* f = new FunctionT(std::forward<_Callable>(function));
+                if (pthread_create(&m_pthread, &attr, [](void* p) -> void* {
+                        std::unique_ptr<FunctionT> f_ptr(static_cast<FunctionT*>(p));
+                        (*f_ptr)();
+                        return nullptr;
+                    },
+                                   f) == 0) {
+                    m_is_pthread = true;
+                } else {
+                    // stack size not accepted, use the default
+                    m_jthread = std::jthread(std::move(*f));
+                    delete f;
+                }
+                pthread_attr_destroy(&attr);
+            }
+#endif
+
+            inline void join()
+            {
+#if defined(__linux__) || defined(__APPLE__)
+                if (m_is_pthread) {
+                    pthread_join(m_pthread, nullptr);
+                    m_is_pthread = false;
+                    return;
+                }
+#endif
+                if (m_jthread.joinable()) {
+                    m_jthread.join();
+                }
+            }
+        };
+
+    private:
+        // some prevention
+        base_threads(const base_threads&)            = delete;
+        base_threads(base_threads&&)                 = delete;
+        base_threads& operator=(const base_threads&) = delete;
+        base_threads& operator=(base_threads&& __t)  = delete;
+
+    private:
+        //
+        // members
+        //
+        std::deque<Thread>       m_threads;              // threads (deque because they are not movable while running)
+        std::stop_source         m_stop_source;          // to signal stop
+        std::atomic<int>         m_running{0};           // how many threads are running
+        std::atomic<std::size_t> m_count_exceptions{0};  // how many exceptions were thrown
+        std::exception_ptr       m_last_exception{};     // last exception thrown
+        std::mutex               m_lock;                 // for waiting
+        std::condition_variable  m_condition;            // signaled when a thread finishes
+    };
+} // namespace small
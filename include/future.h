@@ -0,0 +1,287 @@
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <future>
+#include <type_traits>
+
+#include "impl/future_state_impl.h"
+
+// a promise/future pair where the shared state is taken from a pool (no allocation for each pair)
+// and a continuation can be set to run inline on the thread that sets the value
+// (the continuation is kept in a std::function, which allocates when the callable is larger than its small buffer)
+// R can be void, then set_value() has no parameter and get() returns nothing
+//
+// small::promise<int> p;
+// small::future<int> f = p.get_future();
+// ...
+// // on some thread
+// p.set_value(5);
+// ...
+// int v = f.get();
+// // or
+// std::move(f).then([](small::future<int>& ready) { int v = ready.get(); ... });
+//
+// (for worker_thread see small::submit_item and worker_thread::submit)
+//
+namespace small {
+
+    template <typename R>
+    class future;
+
+    //
+    // promise
+    //
+    template <typename R>
+    class promise
+    {
+    public:
+        using State = typename small::futureimpl::future_state<R>;
+        using Pool  = typename small::futureimpl::future_state_pool<R>;
+
+        //
+        // promise
+        //
+        promise() : m_state(Pool::instance().acquire(2 /*promise and future*/)) {}
+        // without shared state (like a moved from promise)
+        explicit promise(std::nullptr_t) {}
+        promise(promise&& o) noexcept : m_state(std::exchange(o.m_state, nullptr)), m_future_taken(o.m_future_taken) {}
+        inline promise& operator=(promise&& o) noexcept
+        {
+            if (this != &o) {
+                reset();
+                m_state        = std::exchange(o.m_state, nullptr);
+                m_future_taken = o.m_future_taken;
+            }
+            return *this;
+        }
+
+        ~promise()
+        {
+            reset();
+        }
+
+        //
+        // the future can be taken only once
+        //
+        inline small::future<R> get_future()
+        {
+            return small::future<R>(std::exchange(m_future_taken, true) ? nullptr : m_state, false /*add ref*/);
+        }
+
+        //
+        // set value or exception (once), the continuation of the future is called on this thread
+        // (const because the promise is only a handle, so it can be set from inside a const item)
+        //
+        template <typename U = R>
+            requires(!std::is_void_v<U>)
+        inline void set_value(std::type_identity_t<U>&& value) const
+        {
+            set_ready_value(std::forward<U>(value));
+        }
+
+        template <typename U = R>
+            requires(!std::is_void_v<U>)
+        inline void set_value(const std::type_identity_t<U>& value) const
+        {
+            set_ready_value(value);
+        }
+
+        template <typename U = R>
+            requires std::is_void_v<U>
+        inline void set_value() const
+        {
+            set_ready_value();
+        }
+
+        inline void set_exception(std::exception_ptr exception) const
+        {
+            if (m_state && !m_state->is_ready()) {
+                m_state->m_exception = exception;
+                m_state->set_ready();
+            }
+        }
+
+    private:
+        template <typename... _Args>
+        inline void set_ready_value(_Args&&... __args) const
+        {
+            if (m_state && !m_state->is_ready()) {
+                m_state->m_value.emplace(std::forward<_Args>(__args)...);
+                m_state->set_ready();
+            }
+        }
+
+        // a promise destroyed without a value sets broken promise
+        inline void reset()
+        {
+            if (!m_state) {
+                return;
+            }
+            if (!m_state->is_ready()) {
+                set_exception(std::make_exception_ptr(std::future_error(std::future_errc::broken_promise)));
+            }
+            if (!m_future_taken) {
+                Pool::instance().release(m_state); // the ref of the future
+            }
+            Pool::instance().release(std::exchange(m_state, nullptr));
+        }
+
+    private:
+        // some prevention
+        promise(const promise&)            = delete;
+        promise& operator=(const promise&) = delete;
+
+    private:
+        //
+        // members
+        //
+        State* m_state{};             // shared state
+        bool   m_future_taken{false}; // the future was taken
+    };
+
+    //
+    // future
+    //
+    template <typename R>
+    class future
+    {
+    public:
+        using State = typename small::futureimpl::future_state<R>;
+        using Pool  = typename small::futureimpl::future_state_pool<R>;
+
+        //
+        // future
+        //
+        future() = default;
+        future(future&& o) noexcept : m_state(std::exchange(o.m_state, nullptr)) {}
+        inline future& operator=(future&& o) noexcept
+        {
+            if (this != &o) {
+                reset();
+                m_state = std::exchange(o.m_state, nullptr);
+            }
+            return *this;
+        }
+
+        ~future()
+        {
+            reset();
+        }
+
+        // clang-format off
+        // has a shared state
+        inline bool valid       () const { return m_state != nullptr; }
+        // value or exception is set
+        inline bool is_ready    () const { return m_state && m_state->is_ready(); }
+        // clang-format on
+
+        //
+        // wait
+        //
+        inline void wait()
+        {
+            if (m_state) {
+                m_state->wait();
+            }
+        }
+
+        template <typename _Rep, typename _Period>
+        inline std::future_status wait_for(const std::chrono::duration<_Rep, _Period>& __rtime)
+        {
+            return wait_until(std::chrono::steady_clock::now() + __rtime);
+        }
+
+        template <typename _Clock, typename _Duration>
+        inline std::future_status wait_until(const std::chrono::time_point<_Clock, _Duration>& __atime)
+        {
+            if (!m_state) {
+                return std::future_status::ready;
+            }
+            return m_state->wait_until(__atime) ? std::future_status::ready : std::future_status::timeout;
+        }
+
+        //
+        // get the value (once) or throw the exception
+        //
+        inline R get()
+        {
+            if (!m_state) {
+                throw std::future_error(std::future_errc::no_state);
+            }
+            m_state->wait();
+            if (m_state->m_exception) {
+                std::rethrow_exception(m_state->m_exception);
+            }
+            if constexpr (!std::is_void_v<R>) {
+                return std::move(*m_state->m_value);
+            }
+        }
+
+        //
+        // continuation called with the ready future (inline on the thread that sets the value, or on this thread if it is already set)
+        //
+        template <typename _Callable>
+        inline void then(_Callable function) &&
+        {
+            auto* state = std::exchange(m_state, nullptr);
+            if (!state) {
+                return;
+            }
+            state->set_then([function = std::move(function)](State* ready_state) mutable {
+                small::future<R> ready(ready_state, true /*add ref*/);
+                function(ready);
+            });
+            Pool::instance().release(state);
+        }
+
+    private:
+        friend class small::promise<R>;
+
+        explicit future(State* state, bool add_ref)
+            : m_state(state)
+        {
+            if (m_state && add_ref) {
+                m_state->m_refs.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+        inline void reset()
+        {
+            if (m_state) {
+                Pool::instance().release(std::exchange(m_state, nullptr));
+            }
+        }
+
+    private:
+        // some prevention
+        future(const future&)            = delete;
+        future& operator=(const future&) = delete;
+
+    private:
+        //
+        // members
+        //
+        State* m_state{}; // shared state
+    };
+
+    //
+    // item for a worker_thread with a request and a promise for the result (see worker_thread::submit)
+    //
+    template <typename RequestT, typename R>
+    struct submit_item
+    {
+        using RequestType = RequestT;
+        using ResultType  = R;
+
+        RequestT          m_request{};        // request
+        small::promise<R> m_promise{nullptr}; // where to set the result (the shared state is created by submit)
+    };
+
+    template <typename T>
+    inline constexpr bool is_submit_item_v = false;
+
+    template <typename RequestT, typename R>
+    inline constexpr bool is_submit_item_v<small::submit_item<RequestT, R>> = true;
+
+} // namespace small
@@ -0,0 +1,158 @@
+#pragma once
+
+#include "impl_common.h"
+
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <type_traits>
+#include <variant>
+
+namespace small::futureimpl {
+
+    //
+    // shared state between a promise and a future (allocated from a pool, see future_state_pool)
+    // (for R = void the value is an empty std::monostate)
+    //
+    template <typename R>
+    struct future_state
+    {
+        using ValueT = std::conditional_t<std::is_void_v<R>, std::monostate, R>;
+
+        static constexpr int kReady   = 1; // value or exception is set
+        static constexpr int kHasThen = 2; // a continuation is set
+        static constexpr int kWaiting = 4; // a thread is waiting for the value
+
+        std::atomic<int>                                m_status{0};      // kReady | kHasThen | kWaiting
+        std::atomic<int>                                m_refs{0};        // promise + future (+ continuation call)
+        std::optional<ValueT>                           m_value{};        // the value
+        std::exception_ptr                              m_exception{};    // or the exception
+        std::function<void(future_state<R>* /*state*/)> m_then{};         // continuation (allocates only if the callable is larger than the small buffer of std::function)
+        std::mutex                                      m_wait_lock;      // for waiting
+        std::condition_variable                         m_wait_condition; // signaled when ready (only if someone waits)
+        future_state<R>*                                m_next_free{};    // next in free list
+
+        inline bool is_ready() const { return m_status.load(std::memory_order_acquire) & kReady; }
+
+        // the one that comes last (the value or the continuation) calls the continuation
+        inline void set_ready()
+        {
+            auto status = m_status.fetch_or(kReady, std::memory_order_acq_rel);
+            if (status & kWaiting) {
+                // the lock makes sure the waiting thread is inside wait (notify after unlock so it does not block again on the lock)
+                // and only the owner of the future can wait
+                { std::unique_lock l(m_wait_lock); }
+                m_wait_condition.notify_one();
+            }
+            if (status & kHasThen) {
+                m_then(this);
+            }
+        }
+
+        inline void set_then(std::function<void(future_state<R>*)>&& function)
+        {
+            m_then      = std::move(function);
+            auto status = m_status.fetch_or(kHasThen, std::memory_order_acq_rel);
+            if (status & kReady) {
+                m_then(this);
+            }
+        }
+
+        inline void wait()
+        {
+            if (is_ready()) {
+                return;
+            }
+            std::unique_lock l(m_wait_lock);
+            m_status.fetch_or(kWaiting, std::memory_order_acq_rel);
+            m_wait_condition.wait(l, [this]() { return is_ready(); });
+        }
+
+        template <typename _Clock, typename _Duration>
+        inline bool wait_until(const std::chrono::time_point<_Clock, _Duration>& __atime)
+        {
+            if (is_ready()) {
+                return true;
+            }
+            std::unique_lock l(m_wait_lock);
+            m_status.fetch_or(kWaiting, std::memory_order_acq_rel);
+            return m_wait_condition.wait_until(l, __atime, [this]() { return is_ready(); });
+        }
+    };
+
+    //
+    // pool of future states, allocated in slabs and never returned to the heap
+    //
+    template <typename R>
+    class future_state_pool
+    {
+    public:
+        using State = future_state<R>;
+
+        static inline future_state_pool& instance()
+        {
+            static future_state_pool pool;
+            return pool;
+        }
+
+        //
+        // acquire a state with refs count set
+        //
+        inline State* acquire(const int refs)
+        {
+            State* state = nullptr;
+            {
+                std::unique_lock l(m_lock);
+                if (!m_free) {
+                    allocate_slab();
+                }
+                state  = m_free;
+                m_free = state->m_next_free;
+            }
+            state->m_next_free = nullptr;
+            state->m_refs.store(refs, std::memory_order_relaxed);
+            return state;
+        }
+
+        //
+        // release a reference, the last one puts the state back in the pool
+        //
+        inline void release(State* state)
+        {
+            if (state->m_refs.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+                return;
+            }
+
+            state->m_status.store(0, std::memory_order_relaxed);
+            state->m_value.reset();
+            state->m_exception = nullptr;
+            state->m_then      = nullptr;
+
+            std::unique_lock l(m_lock);
+            state->m_next_free = m_free;
+            m_free             = state;
+        }
+
+    private:
+        static constexpr std::size_t kSlabSize = 256;
+
+        inline void allocate_slab()
+        {
+            m_slabs.push_back(std::make_unique<State[]>(kSlabSize));
+            auto* slab = m_slabs.back().get();
+            for (std::size_t i = 0; i < kSlabSize; ++i) {
+                slab[i].m_next_free = m_free;
+                m_free              = &slab[i];
+            }
+        }
+
+    private:
+        //
+        // members
+        //
+        std::mutex                            m_lock;   // lock for free list
+        State*                                m_free{}; // free states
+        std::vector<std::unique_ptr<State[]>> m_slabs;  // all states
+    };
+} // namespace small::futureimpl
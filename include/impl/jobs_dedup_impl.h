@@ -0,0 +1,141 @@
+#pragma once
+
+#include "impl_common.h"
+
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+#include "../lru_cache.h"
+
+namespace small::jobsimpl {
+
+    // how a started job was deduplicated
+    enum class EnumJobsDedup : unsigned int
+    {
+        kNew = 0,    // no job with the same key is in progress, the job is processed
+        kInProgress, // a job with the same key is in progress, the job gets its response when that one is completed
+        kCached,     // the response of a job with the same key is in the cache
+    };
+
+    //
+    // deduplication of the jobs of a type by the key of their request (single flight)
+    // the first started job with a key is processed and the jobs with the same key that are started while it is in progress
+    // wait for it and get its response (optionally the finished responses are kept in a lru cache for a while)
+    // without an equality function the key must be unique for a request (different requests with the same key share the response),
+    // with it the requests with the same key are compared too and a different request is processed on its own
+    //
+    template <typename JobsID, typename JobsRequestT, typename JobsResponseT>
+    class jobs_dedup
+    {
+    public:
+        using FunctionEqual = std::function<bool(const JobsRequestT& /*request*/, const JobsRequestT& /*other_request*/)>;
+
+        jobs_dedup(const small::lru_cache_config& config = {.capacity = 0}, FunctionEqual function_equal = {})
+            : m_cache(config), m_has_cache(config.capacity > 0), m_function_equal(std::move(function_equal)) {}
+
+        //
+        // when a job is started, returns how it is deduplicated (for kCached the response is set)
+        //
+        inline EnumJobsDedup add(const std::size_t key, const JobsID& jobs_id, const JobsRequestT& request, JobsResponseT& response)
+        {
+            std::unique_lock l(m_lock);
+            if (auto* cached = m_cache.get(key); cached && is_same_request(cached->m_request, request)) {
+                response = cached->m_response;
+                return EnumJobsDedup::kCached;
+            }
+
+            auto [it, inserted] = m_in_progress.try_emplace(key);
+            if (inserted || it->second.m_jobs_id == jobs_id) {
+                it->second.m_jobs_id = jobs_id;
+                it->second.m_request = keep_request(request);
+                return EnumJobsDedup::kNew;
+            }
+
+            // another request with the same key is processed on its own (it is not the job in progress for the key)
+            if (!is_same_request(it->second.m_request, request)) {
+                return EnumJobsDedup::kNew;
+            }
+
+            it->second.m_duplicates.push_back(jobs_id);
+            return EnumJobsDedup::kInProgress;
+        }
+
+        //
+        // when a job is completed (or erased) take its duplicates, returns false if it is not the job in progress for the key
+        // (after this the jobs with the same key are processed again or take the cached response)
+        //
+        inline bool completed(const std::size_t key, const JobsID& jobs_id, std::vector<JobsID>& duplicates)
+        {
+            std::unique_lock l(m_lock);
+            auto             it = m_in_progress.find(key);
+            if (it == m_in_progress.end() || it->second.m_jobs_id != jobs_id) {
+                return false;
+            }
+
+            duplicates.insert(duplicates.end(), it->second.m_duplicates.begin(), it->second.m_duplicates.end());
+            m_in_progress.erase(it);
+            return true;
+        }
+
+        //
+        // keep the response of a finished job
+        //
+        inline void cache(const std::size_t key, const JobsRequestT& request, const JobsResponseT& response)
+        {
+            std::unique_lock l(m_lock);
+            m_cache.set(key, CachedResponse{keep_request(request), response});
+        }
+
+        // clang-format off
+        // the finished responses are kept
+        inline bool         has_cache           () const { return m_has_cache; }
+        // how many keys are in progress
+        inline std::size_t  size_in_progress    () const { std::unique_lock l(m_lock); return m_in_progress.size(); }
+        // clang-format on
+
+    private:
+        struct InProgress
+        {
+            JobsID                      m_jobs_id{};    // the job that is processed
+            std::optional<JobsRequestT> m_request{};    // its request (only with an equality function)
+            std::vector<JobsID>         m_duplicates{}; // the jobs with the same key that wait for it
+        };
+
+        struct CachedResponse
+        {
+            std::optional<JobsRequestT> m_request{};  // the request of the finished job (only with an equality function)
+            JobsResponseT               m_response{}; // its response
+        };
+
+        // the request is kept only when it is compared
+        inline std::optional<JobsRequestT> keep_request(const JobsRequestT& request) const
+        {
+            return m_function_equal ? std::optional<JobsRequestT>(request) : std::nullopt;
+        }
+
+        inline bool is_same_request(const std::optional<JobsRequestT>& kept_request, const JobsRequestT& request) const
+        {
+            return !m_function_equal || (kept_request && m_function_equal(*kept_request, request));
+        }
+
+    private:
+        // some prevention
+        jobs_dedup(const jobs_dedup&)            = delete;
+        jobs_dedup(jobs_dedup&&)                 = delete;
+        jobs_dedup& operator=(const jobs_dedup&) = delete;
+        jobs_dedup& operator=(jobs_dedup&& __t)  = delete;
+
+    private:
+        //
+        // members
+        //
+        mutable std::mutex                                   m_lock;             // lock for the jobs in progress and the cache (held while they allocate)
+        std::unordered_map<std::size_t, InProgress>          m_in_progress{};    // the jobs in progress by key
+        small::lru_cache_unsafe<std::size_t, CachedResponse> m_cache;            // the finished responses by key
+        bool                                                 m_has_cache{};      // the cache has a capacity
+        FunctionEqual                                        m_function_equal{}; // (optional) compares the requests with the same key
+    };
+} // namespace small::jobsimpl
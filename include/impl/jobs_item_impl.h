@@ -2,7 +2,12 @@
 
 #include "impl_common.h"
 
+#include <optional>
+
 #include "../base_lock.h"
+#include "../spinlock.h"
+
+#include "jobs_pool_impl.h"
 
 namespace small::jobsimpl {
     // a job can be in the following states (order is important because it may progress only to higher states)
@@ -17,11 +22,21 @@ namespace small::jobsimpl {
         kCancelled,
     };
 
+    // the changes of a child that are added to the aggregates of its parents
+    struct jobs_child_delta
+    {
+        int m_progress{};  // progress (a completed child has 100)
+        int m_completed{}; // 1 when the child is completed
+        int m_failed{};    // 1 when the child is completed but not finished
+    };
+
     // a job item
     template <typename JobsTypeT, typename JobsRequestT, typename JobsResponseT>
     struct jobs_item
     {
-        using JobsID = unsigned long long;
+        using JobsID      = unsigned long long;
+        using JobsIDsList = small::jobsimpl::jobs_ids_list<JobsID>; // copies of the ids taken under the lock (internal, no allocation for a few ids)
+        using TimePoint   = std::chrono::time_point<std::chrono::system_clock>;
 
         JobsID                     m_id{};                        // job unique id
         JobsTypeT                  m_type{};                      // job type
@@ -33,6 +48,18 @@ namespace small::jobsimpl {
         std::vector<JobsID>        m_childrenIDs{};               // for dependencies relationships parent-child
         JobsRequestT               m_request{};                   // request needed for processing function
         JobsResponseT              m_response{};                  // where the results are saved (for the finished callback if exists)
+        mutable small::spinlock    m_lock{};                      // for the parent-child relationships and the response
+        std::atomic<std::size_t>   m_children_count{};            // how many children (aggregates of the children for a parent)
+        std::atomic<std::size_t>   m_children_completed{};        // how many children are completed
+        std::atomic<std::size_t>   m_children_failed{};           // how many children are completed but not finished (failed/timeout/cancelled)
+        std::atomic<long long>     m_children_progress{};         // sum of the children progress (a completed child counts as 100)
+        jobs_child_delta           m_reported{};                  // what this job has added to the aggregates of its parents (under m_lock)
+        std::atomic<std::size_t>   m_parents_left{};              // how many parents are not erased yet (a child is erased with the last one)
+        bool                       m_start_after_children{};      // the job is started when its children are finished (jobs with dependencies)
+        std::atomic<int>           m_start_priority{-1};          // the index of the priority to start with (in the priorities of its group, taken once)
+        std::atomic_bool           m_rate_admitted{};             // the job has a token of the rate limit of its type (it waited for it in the delayed queue)
+        std::optional<TimePoint>   m_deadline{};                  // deadline in the queue of its group (for EnumPrioScheduling::kDeadline, otherwise the default one)
+        std::optional<std::size_t> m_flow{};                      // flow in the queue of its group (ex: a tenant, the flows of a priority are served round robin)
 
         explicit jobs_item() = default;
 
@@ -60,6 +87,9 @@ namespace small::jobsimpl {
             m_childrenIDs  = other.m_childrenIDs;
             m_request      = other.m_request;
             m_response     = other.m_response;
+            m_deadline     = other.m_deadline;
+            m_flow         = other.m_flow;
+            copy_dependencies(other);
             return *this;
         }
         jobs_item& operator=(jobs_item&& other) noexcept
@@ -74,6 +104,9 @@ namespace small::jobsimpl {
             m_childrenIDs  = std::move(other.m_childrenIDs);
             m_request      = std::move(other.m_request);
             m_response     = std::move(other.m_response);
+            m_deadline     = other.m_deadline;
+            m_flow         = other.m_flow;
+            copy_dependencies(other);
             return *this;
         }
 
@@ -143,10 +176,23 @@ namespace small::jobsimpl {
         //
         inline void add_child(const JobsID& child_jobs_id)
         {
-            m_childrenIDs.push_back(child_jobs_id); // this should be set under locked area
+            m_childrenIDs.push_back(child_jobs_id); // this should be set under m_lock
+            ++m_children_count;
             m_has_children = true;
         }
 
+        inline std::vector<JobsID> get_children() const
+        {
+            std::unique_lock l(m_lock);
+            return m_childrenIDs;
+        }
+
+        inline JobsIDsList get_children_list() const
+        {
+            std::unique_lock l(m_lock);
+            return JobsIDsList(m_childrenIDs);
+        }
+
         inline bool has_children() const
         {
             return m_has_children.load();
@@ -157,14 +203,106 @@ namespace small::jobsimpl {
         //
         inline void add_parent(const JobsID& parent_jobs_id)
         {
-            m_parentIDs.push_back(parent_jobs_id); // this should be set under locked area
+            m_parentIDs.push_back(parent_jobs_id); // this should be set under m_lock
             m_has_parents = true;
         }
 
+        inline std::vector<JobsID> get_parents() const
+        {
+            std::unique_lock l(m_lock);
+            return m_parentIDs;
+        }
+
         inline bool has_parents() const
         {
             return m_has_parents.load();
         }
+
+        //
+        // the changes of this job (as a child) that were not yet added to the aggregates of its parents, and the parents
+        // (taken under the lock, so a parent linked meanwhile gets them from get_reported)
+        //
+        inline JobsIDsList take_child_delta(jobs_child_delta& delta)
+        {
+            std::unique_lock l(m_lock);
+
+            const auto state    = get_state();
+            const bool complete = is_state_complete(state);
+            const int  progress = complete ? 100 : std::min<>(get_progress(), 100);
+
+            delta = {};
+            if (progress > m_reported.m_progress) {
+                delta.m_progress      = progress - m_reported.m_progress;
+                m_reported.m_progress = progress;
+            }
+            if (complete && !m_reported.m_completed) {
+                delta.m_completed = m_reported.m_completed = 1;
+            }
+            if (complete && state != EnumJobsState::kFinished && !m_reported.m_failed) {
+                delta.m_failed = m_reported.m_failed = 1;
+            }
+            return JobsIDsList(m_parentIDs);
+        }
+
+        // what was already added to the aggregates of the parents (should be called under m_lock)
+        inline const jobs_child_delta& get_reported() const
+        {
+            return m_reported;
+        }
+
+        //
+        // add the changes of a child to the aggregates
+        //
+        inline void add_child_delta(const jobs_child_delta& delta)
+        {
+            if (delta.m_progress) {
+                m_children_progress += delta.m_progress;
+            }
+            if (delta.m_completed) {
+                m_children_completed += static_cast<std::size_t>(delta.m_completed);
+            }
+            if (delta.m_failed) {
+                m_children_failed += static_cast<std::size_t>(delta.m_failed);
+            }
+        }
+
+        //
+        // start when the children are finished (for jobs with dependencies)
+        // the priority is taken only once, by the last child that is finished (or the first one that failed)
+        //
+        inline void set_start_after_children(const int priority_index)
+        {
+            m_start_after_children = true;
+            m_start_priority       = priority_index;
+        }
+
+        // clang-format off
+        inline bool is_start_after_children () const { return m_start_after_children; }
+        inline int  take_start_priority     () { return m_start_priority.exchange(-1); }
+        // clang-format on
+
+        //
+        // the job waits for its token of the rate limit (taken once when it is started after the wait)
+        //
+        // clang-format off
+        inline void set_rate_admitted       () { m_rate_admitted = true; }
+        inline bool take_rate_admitted      () { return m_rate_admitted.exchange(false); }
+        // clang-format on
+
+    private:
+        inline void copy_dependencies(const jobs_item& other)
+        {
+            m_children_count     = other.m_children_count.load();
+            m_children_completed = other.m_children_completed.load();
+            m_children_failed    = other.m_children_failed.load();
+            m_children_progress  = other.m_children_progress.load();
+            m_reported           = other.m_reported;
+
+            m_parents_left         = other.m_parents_left.load();
+            m_start_after_children = other.m_start_after_children;
+            m_start_priority       = other.m_start_priority.load();
+            m_rate_admitted        = other.m_rate_admitted.load();
+        }
     };
 
 } // namespace small::jobsimpl
@@ -0,0 +1,316 @@
+#pragma once
+
+#include "impl_common.h"
+
+#include <algorithm>
+#include <array>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace small::jobsimpl {
+
+    //
+    // pool of blocks of the same size (allocated in slabs and never returned to the heap)
+    // each thread keeps a cache of free blocks and exchanges them with the shared list in batches
+    // (the jobs are usually created on one thread and released on another)
+    //
+    template <std::size_t BlockSize, std::size_t BlockAlign>
+    class jobs_block_pool
+    {
+    public:
+        static inline jobs_block_pool& instance()
+        {
+            // never destroyed, the items can be released by other static objects at exit
+            static jobs_block_pool* pool = new jobs_block_pool();
+            return *pool;
+        }
+
+        inline void* allocate()
+        {
+            if (cache_destroyed()) {
+                return allocate_shared_list();
+            }
+            auto& cache = thread_cache();
+            if (!cache.m_free) {
+                take_batch(cache);
+            }
+            auto* block   = cache.m_free;
+            cache.m_free  = block->m_next;
+            --cache.m_count;
+            return block;
+        }
+
+        inline void deallocate(void* p)
+        {
+            if (cache_destroyed()) {
+                deallocate_shared_list(p);
+                return;
+            }
+            auto& cache   = thread_cache();
+            auto* block   = static_cast<Block*>(p);
+            block->m_next = cache.m_free;
+            cache.m_free  = block;
+            if (++cache.m_count >= 2 * kBatchSize) {
+                give_batch(cache, kBatchSize);
+            }
+        }
+
+    private:
+        static constexpr std::size_t kBatchSize = 64;  // blocks moved at once between a thread cache and the shared list
+        static constexpr std::size_t kSlabSize  = 256; // blocks allocated at once
+
+        union Block
+        {
+            Block*                            m_next;            // next free block
+            alignas(BlockAlign) unsigned char m_data[BlockSize]; // the object
+        };
+
+        struct ThreadCache
+        {
+            ~ThreadCache()
+            {
+                // give back all blocks when the thread exits
+                // (static objects destroyed after the thread locals of the main thread use the shared list)
+                jobs_block_pool::instance().give_batch(*this, m_count);
+                cache_destroyed() = true;
+            }
+
+            Block*      m_free{};  // free blocks of this thread
+            std::size_t m_count{}; // how many
+        };
+
+        // clang-format off
+        static inline ThreadCache&  thread_cache    () { static thread_local ThreadCache cache; return cache; }
+        static inline bool&         cache_destroyed () { static thread_local bool destroyed{false}; return destroyed; }
+        // clang-format on
+
+        inline void* allocate_shared_list()
+        {
+            std::unique_lock l(m_lock);
+            if (!m_free) {
+                allocate_slab();
+            }
+            auto* block = m_free;
+            m_free      = block->m_next;
+            return block;
+        }
+
+        inline void deallocate_shared_list(void* p)
+        {
+            std::unique_lock l(m_lock);
+            auto* block   = static_cast<Block*>(p);
+            block->m_next = m_free;
+            m_free        = block;
+        }
+
+        inline void take_batch(ThreadCache& cache)
+        {
+            std::unique_lock l(m_lock);
+            if (!m_free) {
+                allocate_slab();
+            }
+            for (std::size_t i = 0; i < kBatchSize && m_free; ++i) {
+                auto* block   = m_free;
+                m_free        = block->m_next;
+                block->m_next = cache.m_free;
+                cache.m_free  = block;
+                ++cache.m_count;
+            }
+        }
+
+        inline void give_batch(ThreadCache& cache, const std::size_t count)
+        {
+            std::unique_lock l(m_lock);
+            for (std::size_t i = 0; i < count && cache.m_free; ++i) {
+                auto* block   = cache.m_free;
+                cache.m_free  = block->m_next;
+                block->m_next = m_free;
+                m_free        = block;
+                --cache.m_count;
+            }
+        }
+
+        inline void allocate_slab()
+        {
+            m_slabs.push_back(std::make_unique<Block[]>(kSlabSize));
+            auto* slab = m_slabs.back().get();
+            for (std::size_t i = 0; i < kSlabSize; ++i) {
+                slab[i].m_next = m_free;
+                m_free         = &slab[i];
+            }
+        }
+
+    private:
+        //
+        // members
+        //
+        std::mutex                            m_lock;   // lock for the shared list
+        Block*                                m_free{}; // free blocks
+        std::vector<std::unique_ptr<Block[]>> m_slabs;  // all blocks
+    };
+
+    //
+    // allocator that takes single objects from the pool (for std::allocate_shared)
+    //
+    template <typename T>
+    struct jobs_pool_allocator
+    {
+        using value_type = T;
+        using Pool       = jobs_block_pool<sizeof(T), alignof(T)>;
+
+        jobs_pool_allocator() = default;
+        template <typename U>
+        jobs_pool_allocator(const jobs_pool_allocator<U>&) noexcept {}
+
+        inline T* allocate(const std::size_t n)
+        {
+            // arrays are taken from the heap
+            return n == 1 ? static_cast<T*>(Pool::instance().allocate()) : std::allocator<T>().allocate(n);
+        }
+
+        inline void deallocate(T* p, const std::size_t n) noexcept
+        {
+            if (n == 1) {
+                Pool::instance().deallocate(p);
+            } else {
+                std::allocator<T>().deallocate(p, n);
+            }
+        }
+
+        template <typename U>
+        inline bool operator==(const jobs_pool_allocator<U>&) const noexcept { return true; }
+        template <typename U>
+        inline bool operator!=(const jobs_pool_allocator<U>&) const noexcept { return false; }
+    };
+
+    //
+    // list of jobs ids with inline storage for the first ones (no allocation for a few parents or children)
+    //
+    template <typename JobsID, std::size_t InlineCount = 4>
+    class jobs_ids_list
+    {
+    public:
+        jobs_ids_list() = default;
+        explicit jobs_ids_list(const std::vector<JobsID>& jobs_ids)
+            : m_size(jobs_ids.size())
+        {
+            if (m_size <= InlineCount) {
+                std::copy(jobs_ids.begin(), jobs_ids.end(), m_inline.begin());
+            } else {
+                m_heap = jobs_ids;
+            }
+        }
+
+        // clang-format off
+        inline std::size_t      size        () const { return m_size; }
+        inline bool             empty       () const { return m_size == 0; }
+        inline const JobsID*    data        () const { return m_size <= InlineCount ? m_inline.data() : m_heap.data(); }
+        inline const JobsID*    begin       () const { return data(); }
+        inline const JobsID*    end         () const { return data() + m_size; }
+        inline const JobsID&    operator[]  (const std::size_t index) const { return data()[index]; }
+        inline void             clear       () { m_size = 0; m_heap.clear(); }
+        // clang-format on
+
+        inline void push_back(const JobsID& jobs_id)
+        {
+            if (m_size < InlineCount) {
+                m_inline[m_size++] = jobs_id;
+                return;
+            }
+            if (m_size == InlineCount) {
+                m_heap.assign(m_inline.begin(), m_inline.end());
+            }
+            m_heap.push_back(jobs_id);
+            ++m_size;
+        }
+
+    private:
+        //
+        // members
+        //
+        std::array<JobsID, InlineCount> m_inline{}; // the first ids
+        std::vector<JobsID>             m_heap{};   // all the ids when there are more than the inline count
+        std::size_t                     m_size{};   // how many ids
+    };
+
+    //
+    // vector reused by the same thread (the vectors are taken in nested order, so the callbacks called while one is used take their own)
+    // it is cleared when released but it keeps the capacity, so there are no allocations once they are warm
+    //
+    template <typename T>
+    class jobs_scratch_vector
+    {
+    public:
+        jobs_scratch_vector()
+            : m_vector(acquire())
+        {
+            if (!m_vector) {
+                m_vector = &m_own;
+            }
+        }
+
+        ~jobs_scratch_vector()
+        {
+            if (m_vector == &m_own) {
+                return;
+            }
+            m_vector->clear();
+            if (m_vector->capacity() > kMaxKeepCapacity) {
+                std::vector<T>().swap(*m_vector);
+            }
+            --thread_vectors().m_depth;
+        }
+
+        // clang-format off
+        inline std::vector<T>&  operator*   () { return *m_vector; }
+        inline std::vector<T>*  operator->  () { return m_vector; }
+        // clang-format on
+
+    private:
+        static constexpr std::size_t kMaxKeepCapacity = 4096; // do not keep the memory of very large batches
+
+        struct ThreadVectors
+        {
+            ~ThreadVectors()
+            {
+                // static objects destroyed after the thread locals of the main thread use their own vector
+                destroyed() = true;
+            }
+
+            std::vector<std::unique_ptr<std::vector<T>>> m_vectors; // vectors of this thread
+            std::size_t                                  m_depth{}; // how many are in use
+        };
+
+        // clang-format off
+        static inline ThreadVectors&    thread_vectors  () { static thread_local ThreadVectors vectors; return vectors; }
+        static inline bool&             destroyed       () { static thread_local bool destroyed{false}; return destroyed; }
+        // clang-format on
+
+        static inline std::vector<T>* acquire()
+        {
+            if (destroyed()) {
+                return nullptr;
+            }
+            auto& vectors = thread_vectors();
+            if (vectors.m_depth == vectors.m_vectors.size()) {
+                vectors.m_vectors.push_back(std::make_unique<std::vector<T>>());
+            }
+            return vectors.m_vectors[vectors.m_depth++].get();
+        }
+
+    private:
+        // some prevention
+        jobs_scratch_vector(const jobs_scratch_vector&)            = delete;
+        jobs_scratch_vector(jobs_scratch_vector&&)                 = delete;
+        jobs_scratch_vector& operator=(const jobs_scratch_vector&) = delete;
+        jobs_scratch_vector& operator=(jobs_scratch_vector&& __t)  = delete;
+
+    private:
+        //
+        // members
+        //
+        std::vector<T>  m_own;       // used when the thread vectors are no longer available
+        std::vector<T>* m_vector{};  // the vector of this thread at this depth
+    };
+} // namespace small::jobsimpl
@@ -6,10 +6,16 @@
 #include "../time_queue_thread.h"
 
 #include "jobs_item_impl.h"
+#include "jobs_slots_impl.h"
 
 namespace small::jobsimpl {
     //
     // small queue helper class for jobs (parent caller must implement 'jobs_add', 'jobs_schedule', 'jobs_finished', 'jobs_cancelled')
+    // the jobs are kept in a slot map (the id has the slot index and its generation) so getting a job is an array index
+    // and adding, getting and erasing jobs from many threads do not wait on one lock
+    // (the global lock is only for the user transactions and for waiting)
+    // the jobs items are taken from a pool and the slots are reused, so adding jobs does not allocate once they are warm
+    // a vector of jobs is added with one call to the parent and started with one push and one schedule for each group
     //
     template <typename JobsTypeT, typename JobsRequestT, typename JobsResponseT, typename JobsGroupT, typename JobsPrioT, typename ParentCallerT>
     class jobs_queue
@@ -19,6 +25,9 @@ namespace small::jobsimpl {
         using JobsID    = typename JobsItem::JobsID;
         using JobsQueue = small::prio_queue<JobsID, JobsPrioT>;
 
+        using JobsScratchIDs   = small::jobsimpl::jobs_scratch_vector<JobsID>;
+        using JobsScratchItems = small::jobsimpl::jobs_scratch_vector<std::shared_ptr<JobsItem>>;
+
         using ThisJobsQueue = jobs_queue<JobsTypeT, JobsRequestT, JobsResponseT, JobsGroupT, JobsPrioT, ParentCallerT>;
 
         using JobDelayedItems  = std::pair<JobsPrioT, JobsID>;
@@ -37,11 +46,7 @@ namespace small::jobsimpl {
             : m_parent_caller(parent_caller) {}
 
         // size of active items
-        inline size_t size()
-        {
-            std::unique_lock l(m_lock);
-            return m_jobs.size();
-        }
+        inline size_t size() { return m_jobs.size(); }
         // empty
         inline bool empty() { return size() == 0; }
         // clear
@@ -110,6 +115,15 @@ namespace small::jobsimpl {
         // only this part is public
         //
     public:
+        //
+        // create a jobs item (from the pool)
+        //
+        template <typename... Args>
+        static inline std::shared_ptr<JobsItem> jobs_item_create(Args&&... args)
+        {
+            return std::allocate_shared<JobsItem>(small::jobsimpl::jobs_pool_allocator<JobsItem>{}, std::forward<Args>(args)...);
+        }
+
         //
         // add items to be processed
         // push_back only add the jobs item but does not start it
@@ -117,10 +131,10 @@ namespace small::jobsimpl {
         inline std::size_t push_back(const JobsTypeT& jobs_type, const JobsRequestT& job_req, JobsID* jobs_id)
         {
             // this job should be manually started by calling jobs_start
-            return push_back(std::make_shared<JobsItem>(jobs_type, job_req), jobs_id);
+            return push_back(jobs_item_create(jobs_type, job_req), jobs_id);
         }
 
-        inline std::size_t push_back(std::shared_ptr<JobsItem> jobs_item, JobsID* jobs_id)
+        inline std::size_t push_back(const std::shared_ptr<JobsItem>& jobs_item, JobsID* jobs_id)
         {
             // this job should be manually started by calling jobs_start
             return jobs_add(jobs_item, jobs_id);
@@ -133,31 +147,15 @@ namespace small::jobsimpl {
             }
 
             // this jobs should be manually started by calling jobs_start
-            std::unique_lock l(m_lock);
-
-            std::size_t count = 0;
-            if (jobs_ids) {
-                jobs_ids->reserve(jobs_items.size());
-                jobs_ids->clear();
-            }
-            JobsID jobs_id{};
-            for (auto& jobs_item : jobs_items) {
-                auto ret = push_back(jobs_item, &jobs_id);
-                if (ret) {
-                    if (jobs_ids) {
-                        jobs_ids->push_back(jobs_id);
-                    }
-                }
-                count += ret;
-            }
-            return count;
+            JobsScratchItems added_jobs_items;
+            return jobs_add(jobs_items, *added_jobs_items, jobs_ids);
         }
 
         // push_back move semantics
         inline std::size_t push_back(const JobsTypeT& jobs_type, JobsRequestT&& jobs_req, JobsID* jobs_id)
         {
             // this job should be manually started by calling jobs_start
-            return push_back(std::make_shared<JobsItem>(jobs_type, std::forward<JobsRequestT>(jobs_req)), jobs_id);
+            return push_back(jobs_item_create(jobs_type, std::forward<JobsRequestT>(jobs_req)), jobs_id);
         }
 
         //
@@ -165,26 +163,17 @@ namespace small::jobsimpl {
         //
         inline std::size_t push_back_and_start(const JobsPrioT& priority, const JobsTypeT& jobs_type, const JobsRequestT& job_req, JobsID* jobs_id = nullptr)
         {
-            return push_back_and_start(priority, std::make_shared<JobsItem>(jobs_type, job_req), jobs_id);
+            return push_back_and_start(priority, jobs_item_create(jobs_type, job_req), jobs_id);
         }
 
-        inline std::size_t push_back_and_start(const JobsPrioT& priority, std::shared_ptr<JobsItem> jobs_item, JobsID* jobs_id = nullptr)
+        inline std::size_t push_back_and_start(const JobsPrioT& priority, const std::shared_ptr<JobsItem>& jobs_item, JobsID* jobs_id = nullptr)
         {
-            {
-                std::unique_lock l(m_lock);
-
-                JobsID id{};
-                auto   ret = push_back(jobs_item, &id);
-                if (!ret) {
-                    return ret;
-                }
-
-                if (jobs_id) {
-                    *jobs_id = id;
-                }
-            } // end lock
+            auto ret = push_back(jobs_item, jobs_id);
+            if (!ret) {
+                return ret;
+            }
 
-            // start the job (must be under no lock)
+            // start the job
             return jobs_start(priority, jobs_item);
         }
 
@@ -194,29 +183,20 @@ namespace small::jobsimpl {
                 return 0;
             }
 
-            {
-                std::unique_lock l(m_lock);
-
-                std::vector<JobsID> ids;
-
-                auto ret = push_back(jobs_items, &ids);
-                if (!ret) {
-                    return ret;
-                }
-
-                if (jobs_ids) {
-                    *jobs_ids = std::move(ids);
-                }
-            } // end lock
+            JobsScratchItems added_jobs_items;
+            auto             ret = jobs_add(jobs_items, *added_jobs_items, jobs_ids);
+            if (!ret) {
+                return ret;
+            }
 
-            // start the jobs (must be under no lock)
-            return jobs_start(priority, jobs_items);
+            // start only the added jobs
+            return jobs_start(priority, *added_jobs_items);
         }
 
         // push_back move semantics
         inline std::size_t push_back_and_start(const JobsPrioT& priority, const JobsTypeT& jobs_type, JobsRequestT&& jobs_req, JobsID* jobs_id = nullptr)
         {
-            return push_back_and_start(priority, std::make_shared<JobsItem>(jobs_type, std::forward<JobsRequestT>(jobs_req)), jobs_id);
+            return push_back_and_start(priority, jobs_item_create(jobs_type, std::forward<JobsRequestT>(jobs_req)), jobs_id);
         }
 
         //
@@ -225,17 +205,15 @@ namespace small::jobsimpl {
         inline std::size_t push_back_child(const JobsID& parent_jobs_id, const JobsTypeT& child_jobs_type, const JobsRequestT& child_job_req, JobsID* child_jobs_id)
         {
             // this job should be manually started by calling jobs_start
-            return push_back_child(parent_jobs_id, std::make_shared<JobsItem>(child_jobs_type, child_job_req), child_jobs_id);
+            return push_back_child(parent_jobs_id, jobs_item_create(child_jobs_type, child_job_req), child_jobs_id);
         }
 
-        inline std::size_t push_back_child(const JobsID& parent_jobs_id, std::shared_ptr<JobsItem> child_jobs_item, JobsID* child_jobs_id)
+        inline std::size_t push_back_child(const JobsID& parent_jobs_id, const std::shared_ptr<JobsItem>& child_jobs_item, JobsID* child_jobs_id)
         {
             if (is_exit()) {
                 return 0;
             }
 
-            std::unique_lock l(m_lock);
-
             auto parent_jobs_item = jobs_get(parent_jobs_id);
             if (!parent_jobs_item) {
                 return 0;
@@ -248,11 +226,15 @@ namespace small::jobsimpl {
                 return ret;
             }
 
+            // the parent may have been erased meanwhile
+            if (!jobs_parent_child(parent_jobs_item, child_jobs_item)) {
+                jobs_erase(id);
+                return 0;
+            }
+
             if (child_jobs_id) {
                 *child_jobs_id = id;
             }
-
-            jobs_parent_child(parent_jobs_item, child_jobs_item);
             return 1;
         }
 
@@ -263,31 +245,15 @@ namespace small::jobsimpl {
             }
 
             // this job should be manually started by calling jobs_start
-            std::unique_lock l(m_lock);
-
-            std::size_t count = 0;
-            if (children_jobs_ids) {
-                children_jobs_ids->reserve(children_jobs_items.size());
-                children_jobs_ids->clear();
-            }
-            JobsID child_jobs_id{};
-            for (auto& child_jobs_item : children_jobs_items) {
-                auto ret = push_back_child(parent_jobs_id, child_jobs_item, &child_jobs_id);
-                if (ret) {
-                    if (children_jobs_ids) {
-                        children_jobs_ids->push_back(child_jobs_id);
-                    }
-                }
-                count += ret;
-            }
-            return count;
+            JobsScratchItems added_jobs_items;
+            return jobs_add_children(parent_jobs_id, children_jobs_items, *added_jobs_items, children_jobs_ids);
         }
 
         // push_back_child move semantics
         inline std::size_t push_back_child(const JobsID& parent_jobs_id, const JobsTypeT& child_jobs_type, JobsRequestT&& child_jobs_req, JobsID* child_jobs_id)
         {
             // this job should be manually started by calling jobs_start
-            return push_back_child(parent_jobs_id, std::make_shared<JobsItem>(child_jobs_type, std::forward<JobsRequestT>(child_jobs_req)), child_jobs_id);
+            return push_back_child(parent_jobs_id, jobs_item_create(child_jobs_type, std::forward<JobsRequestT>(child_jobs_req)), child_jobs_id);
         }
 
         //
@@ -295,30 +261,21 @@ namespace small::jobsimpl {
         //
         inline std::size_t push_back_and_start_child(const JobsID& parent_jobs_id, const JobsPrioT& child_priority, const JobsTypeT& child_jobs_type, const JobsRequestT& child_job_req, JobsID* child_jobs_id = nullptr)
         {
-            return push_back_and_start_child(parent_jobs_id, child_priority, std::make_shared<JobsItem>(child_jobs_type, child_job_req), child_jobs_id);
+            return push_back_and_start_child(parent_jobs_id, child_priority, jobs_item_create(child_jobs_type, child_job_req), child_jobs_id);
         }
 
-        inline std::size_t push_back_and_start_child(const JobsID& parent_jobs_id, const JobsPrioT& child_priority, std::shared_ptr<JobsItem> child_jobs_item, JobsID* child_jobs_id = nullptr)
+        inline std::size_t push_back_and_start_child(const JobsID& parent_jobs_id, const JobsPrioT& child_priority, const std::shared_ptr<JobsItem>& child_jobs_item, JobsID* child_jobs_id = nullptr)
         {
             if (is_exit()) {
                 return 0;
             }
 
-            {
-                std::unique_lock l(m_lock);
-
-                JobsID id{};
-                auto   ret = push_back_child(parent_jobs_id, child_jobs_item, &id);
-                if (!ret) {
-                    return ret;
-                }
-
-                if (child_jobs_id) {
-                    *child_jobs_id = id;
-                }
-            } // end lock
+            auto ret = push_back_child(parent_jobs_id, child_jobs_item, child_jobs_id);
+            if (!ret) {
+                return ret;
+            }
 
-            // start the job (must be under no lock)
+            // start the job
             return jobs_start(child_priority, child_jobs_item);
         }
 
@@ -328,29 +285,20 @@ namespace small::jobsimpl {
                 return 0;
             }
 
-            {
-                std::unique_lock l(m_lock);
-
-                std::vector<JobsID> ids;
-
-                auto ret = push_back_child(parent_jobs_id, children_jobs_items, &ids);
-                if (!ret) {
-                    return ret;
-                }
-
-                if (children_jobs_ids) {
-                    *children_jobs_ids = std::move(ids);
-                }
-            } // end lock
+            JobsScratchItems added_jobs_items;
+            auto             ret = jobs_add_children(parent_jobs_id, children_jobs_items, *added_jobs_items, children_jobs_ids);
+            if (!ret) {
+                return ret;
+            }
 
-            // start the jobs
-            return jobs_start(children_priority, children_jobs_items);
+            // start only the added and linked jobs
+            return jobs_start(children_priority, *added_jobs_items);
         }
 
         // push_back move semantics
         inline std::size_t push_back_and_start_child(const JobsID& parent_jobs_id, const JobsPrioT& child_priority, const JobsTypeT& child_jobs_type, JobsRequestT&& child_jobs_req, JobsID* child_jobs_id = nullptr)
         {
-            return push_back_and_start_child(parent_jobs_id, child_priority, std::make_shared<JobsItem>(child_jobs_type, std::forward<JobsRequestT>(child_jobs_req)), child_jobs_id);
+            return push_back_and_start_child(parent_jobs_id, child_priority, jobs_item_create(child_jobs_type, std::forward<JobsRequestT>(child_jobs_req)), child_jobs_id);
         }
 
         // no emplace_back do to returning the jobs_id
@@ -361,11 +309,11 @@ namespace small::jobsimpl {
         template <typename _Rep, typename _Period>
         inline std::size_t push_back_and_start_delay_for(const std::chrono::duration<_Rep, _Period>& __rtime, const JobsPrioT& priority, const JobsTypeT& jobs_type, const JobsRequestT& jobs_req, JobsID* jobs_id = nullptr)
         {
-            return push_back_and_start_delay_for(__rtime, priority, std::make_shared<JobsItem>(jobs_type, jobs_req), jobs_id);
+            return push_back_and_start_delay_for(__rtime, priority, jobs_item_create(jobs_type, jobs_req), jobs_id);
         }
 
         template <typename _Rep, typename _Period>
-        inline std::size_t push_back_and_start_delay_for(const std::chrono::duration<_Rep, _Period>& __rtime, const JobsPrioT& priority, std::shared_ptr<JobsItem> jobs_item, JobsID* jobs_id = nullptr)
+        inline std::size_t push_back_and_start_delay_for(const std::chrono::duration<_Rep, _Period>& __rtime, const JobsPrioT& priority, const std::shared_ptr<JobsItem>& jobs_item, JobsID* jobs_id = nullptr)
         {
             JobsID id{};
             auto   ret = jobs_add(jobs_item, &id);
@@ -382,16 +330,16 @@ namespace small::jobsimpl {
         template <typename _Rep, typename _Period>
         inline std::size_t push_back_and_start_delay_for(const std::chrono::duration<_Rep, _Period>& __rtime, const JobsPrioT& priority, const JobsTypeT& jobs_type, JobsRequestT&& jobs_req, JobsID* jobs_id = nullptr)
         {
-            return push_back_and_start_delay_for(__rtime, priority, std::make_shared<JobsItem>(jobs_type, std::forward<JobsRequestT>(jobs_req)), jobs_id);
+            return push_back_and_start_delay_for(__rtime, priority, jobs_item_create(jobs_type, std::forward<JobsRequestT>(jobs_req)), jobs_id);
         }
 
         // avoid time_casting from one clock to another // template <typename _Clock, typename _Duration> //
         inline std::size_t push_back_and_start_delay_until(const std::chrono::time_point<TimeClock, TimeDuration>& __atime, const JobsPrioT& priority, const JobsTypeT& jobs_type, const JobsRequestT& jobs_req, JobsID* jobs_id = nullptr)
         {
-            return push_back_and_start_delay_until(__atime, priority, std::make_shared<JobsItem>(jobs_type, jobs_req), jobs_id);
+            return push_back_and_start_delay_until(__atime, priority, jobs_item_create(jobs_type, jobs_req), jobs_id);
         }
 
-        inline std::size_t push_back_and_start_delay_until(const std::chrono::time_point<TimeClock, TimeDuration>& __atime, const JobsPrioT& priority, std::shared_ptr<JobsItem> jobs_item, JobsID* jobs_id = nullptr)
+        inline std::size_t push_back_and_start_delay_until(const std::chrono::time_point<TimeClock, TimeDuration>& __atime, const JobsPrioT& priority, const std::shared_ptr<JobsItem>& jobs_item, JobsID* jobs_id = nullptr)
         {
             JobsID id{};
             auto   ret = jobs_add(jobs_item, &id);
@@ -407,7 +355,80 @@ namespace small::jobsimpl {
 
         inline std::size_t push_back_and_start_delay_until(const std::chrono::time_point<TimeClock, TimeDuration>& __atime, const JobsPrioT& priority, const JobsTypeT& jobs_type, JobsRequestT&& jobs_req, JobsID* jobs_id = nullptr)
         {
-            return push_back_and_start_delay_until(__atime, priority, std::make_shared<JobsItem>(jobs_type, std::forward<JobsRequestT>(jobs_req)), jobs_id);
+            return push_back_and_start_delay_until(__atime, priority, jobs_item_create(jobs_type, std::forward<JobsRequestT>(jobs_req)), jobs_id);
+        }
+
+        //
+        // push_back for a flow in the queue of the group (ex: a tenant), inside the same priority the flows are served round robin
+        //
+        inline std::size_t push_back_and_start_flow(const JobsPrioT& priority, const std::size_t flow, const JobsTypeT& jobs_type, const JobsRequestT& jobs_req, JobsID* jobs_id = nullptr)
+        {
+            return push_back_and_start_flow(priority, flow, jobs_item_create(jobs_type, jobs_req), jobs_id);
+        }
+
+        inline std::size_t push_back_and_start_flow(const JobsPrioT& priority, const std::size_t flow, const std::shared_ptr<JobsItem>& jobs_item, JobsID* jobs_id = nullptr)
+        {
+            // the flow is kept with the job (it is used also when the job is started later)
+            jobs_item->m_flow = flow;
+            return push_back_and_start(priority, jobs_item, jobs_id);
+        }
+
+        inline std::size_t push_back_and_start_flow(const JobsPrioT& priority, const std::size_t flow, const std::vector<std::shared_ptr<JobsItem>>& jobs_items, std::vector<JobsID>* jobs_ids = nullptr)
+        {
+            for (auto& jobs_item : jobs_items) {
+                jobs_item->m_flow = flow;
+            }
+            return push_back_and_start(priority, jobs_items, jobs_ids);
+        }
+
+        // push_back move semantics
+        inline std::size_t push_back_and_start_flow(const JobsPrioT& priority, const std::size_t flow, const JobsTypeT& jobs_type, JobsRequestT&& jobs_req, JobsID* jobs_id = nullptr)
+        {
+            return push_back_and_start_flow(priority, flow, jobs_item_create(jobs_type, std::forward<JobsRequestT>(jobs_req)), jobs_id);
+        }
+
+        //
+        // push_back with a deadline in the queue of the group (for EnumPrioScheduling::kDeadline, otherwise is like push_back_and_start)
+        //
+        template <typename _Rep, typename _Period>
+        inline std::size_t push_back_and_start_deadline_for(const std::chrono::duration<_Rep, _Period>& __rtime, const JobsPrioT& priority, const JobsTypeT& jobs_type, const JobsRequestT& jobs_req, JobsID* jobs_id = nullptr)
+        {
+            return push_back_and_start_deadline_for(__rtime, priority, jobs_item_create(jobs_type, jobs_req), jobs_id);
+        }
+
+        template <typename _Rep, typename _Period>
+        inline std::size_t push_back_and_start_deadline_for(const std::chrono::duration<_Rep, _Period>& __rtime, const JobsPrioT& priority, const std::shared_ptr<JobsItem>& jobs_item, JobsID* jobs_id = nullptr)
+        {
+            using __dur    = TimeDuration;
+            auto __reltime = std::chrono::duration_cast<__dur>(__rtime);
+            if (__reltime < __rtime) {
+                ++__reltime;
+            }
+            return push_back_and_start_deadline_until(TimeClock::now() + __reltime, priority, jobs_item, jobs_id);
+        }
+
+        template <typename _Rep, typename _Period>
+        inline std::size_t push_back_and_start_deadline_for(const std::chrono::duration<_Rep, _Period>& __rtime, const JobsPrioT& priority, const JobsTypeT& jobs_type, JobsRequestT&& jobs_req, JobsID* jobs_id = nullptr)
+        {
+            return push_back_and_start_deadline_for(__rtime, priority, jobs_item_create(jobs_type, std::forward<JobsRequestT>(jobs_req)), jobs_id);
+        }
+
+        // avoid time_casting from one clock to another // template <typename _Clock, typename _Duration> //
+        inline std::size_t push_back_and_start_deadline_until(const std::chrono::time_point<TimeClock, TimeDuration>& __atime, const JobsPrioT& priority, const JobsTypeT& jobs_type, const JobsRequestT& jobs_req, JobsID* jobs_id = nullptr)
+        {
+            return push_back_and_start_deadline_until(__atime, priority, jobs_item_create(jobs_type, jobs_req), jobs_id);
+        }
+
+        inline std::size_t push_back_and_start_deadline_until(const std::chrono::time_point<TimeClock, TimeDuration>& __atime, const JobsPrioT& priority, const std::shared_ptr<JobsItem>& jobs_item, JobsID* jobs_id = nullptr)
+        {
+            // the deadline is kept with the job (it is used also when the job is started later)
+            jobs_item->m_deadline = __atime;
+            return push_back_and_start(priority, jobs_item, jobs_id);
+        }
+
+        inline std::size_t push_back_and_start_deadline_until(const std::chrono::time_point<TimeClock, TimeDuration>& __atime, const JobsPrioT& priority, const JobsTypeT& jobs_type, JobsRequestT&& jobs_req, JobsID* jobs_id = nullptr)
+        {
+            return push_back_and_start_deadline_until(__atime, priority, jobs_item_create(jobs_type, std::forward<JobsRequestT>(jobs_req)), jobs_id);
         }
 
         //
@@ -471,7 +492,9 @@ namespace small::jobsimpl {
             // wait for jobs to finish (because jobs may create children)
             {
                 std::unique_lock l(m_lock);
+                ++m_jobs_waiting;
                 m_lock.wait(l, [&]() { return m_jobs.empty(); });
+                --m_jobs_waiting;
                 m_lock.signal_exit_when_done();
             }
 
@@ -510,7 +533,9 @@ namespace small::jobsimpl {
             {
                 std::unique_lock l(m_lock);
 
+                ++m_jobs_waiting;
                 auto delayed_status = m_lock.wait_until(l, __atime, [&]() { return m_jobs.empty(); });
+                --m_jobs_waiting;
                 if (delayed_status == small::EnumLock::kTimeout) {
                     return small::EnumLock::kTimeout;
                 }
@@ -564,54 +589,52 @@ namespace small::jobsimpl {
         //
         inline std::shared_ptr<JobsItem> jobs_get(const JobsID& jobs_id)
         {
-            std::unique_lock l(m_lock);
-
-            auto it_j = m_jobs.find(jobs_id);
-            if (it_j == m_jobs.end()) {
-                return nullptr;
-            }
-            return it_j->second;
+            return m_jobs.get(jobs_id);
         }
 
         inline std::vector<std::shared_ptr<JobsItem>> jobs_get(const std::vector<JobsID>& jobs_ids)
+        {
+            return jobs_get_items(jobs_ids);
+        }
+
+        template <typename JobsIDsT>
+        inline std::vector<std::shared_ptr<JobsItem>> jobs_get_items(const JobsIDsT& jobs_ids)
         {
             std::vector<std::shared_ptr<JobsItem>> jobs_items;
-            jobs_items.reserve(jobs_ids.size());
+            jobs_get_items(jobs_ids, jobs_items);
+            return jobs_items; // will be moved
+        }
 
-            std::unique_lock l(m_lock);
+        // append to a given vector (to reuse its memory)
+        template <typename JobsIDsT>
+        inline void jobs_get_items(const JobsIDsT& jobs_ids, std::vector<std::shared_ptr<JobsItem>>& jobs_items)
+        {
+            jobs_items.reserve(jobs_items.size() + jobs_ids.size());
 
             for (auto& jobs_id : jobs_ids) {
                 auto jobs_item = jobs_get(jobs_id);
                 if (jobs_item) {
-                    jobs_items.push_back(jobs_item);
+                    jobs_items.push_back(std::move(jobs_item));
                 }
             }
-
-            return jobs_items; // will be moved
         }
 
         //
         // add jobs item
         //
-        inline JobsID jobs_add(std::shared_ptr<JobsItem> jobs_item, JobsID* jobs_id)
+        inline JobsID jobs_add(const std::shared_ptr<JobsItem>& jobs_item, JobsID* jobs_id)
         {
-            if (is_exit()) {
+            // exit when done is set only after all the jobs are done
+            if (m_lock.is_exit()) {
                 return 0;
             }
 
-            std::unique_lock l(m_lock);
-
-            // check under lock
-            if (m_lock.is_exit()) {
+            // (the id is known only by this thread until it is returned)
+            JobsID id = m_jobs.add(jobs_item);
+            if (!id) {
                 return 0;
             }
-
-            ++m_jobs_seq_id;
-
-            JobsID id       = m_jobs_seq_id;
             jobs_item->m_id = id;
-            m_jobs.emplace(id, jobs_item);
-            m_lock.notify_all();
 
             if (jobs_id) {
                 *jobs_id = id;
@@ -623,19 +646,110 @@ namespace small::jobsimpl {
             return 1;
         }
 
+        // add many jobs items and call the parent once for all of them
+        // (the added items are set in added_jobs_items and their ids in jobs_ids, in the same order)
+        inline std::size_t jobs_add(const std::vector<std::shared_ptr<JobsItem>>& jobs_items, std::vector<std::shared_ptr<JobsItem>>& added_jobs_items, std::vector<JobsID>* jobs_ids)
+        {
+            added_jobs_items.clear();
+            if (jobs_ids) {
+                jobs_ids->clear();
+            }
+
+            // exit when done is set only after all the jobs are done
+            if (m_lock.is_exit()) {
+                return 0;
+            }
+
+            added_jobs_items.reserve(jobs_items.size());
+            if (jobs_ids) {
+                jobs_ids->reserve(jobs_items.size());
+            }
+
+            // (the ids are known only by this thread until they are returned)
+            JobsScratchIDs ids;
+            m_jobs.add(jobs_items, *ids);
+            for (std::size_t i = 0; i < jobs_items.size(); ++i) {
+                const auto id = (*ids)[i];
+                if (!id) {
+                    continue;
+                }
+                jobs_items[i]->m_id = id;
+
+                added_jobs_items.push_back(jobs_items[i]);
+                if (jobs_ids) {
+                    jobs_ids->push_back(id);
+                }
+            }
+
+            if (!added_jobs_items.empty()) {
+                // call parent for extra processing
+                m_parent_caller.jobs_add(added_jobs_items);
+            }
+            return added_jobs_items.size();
+        }
+
+        // add many children and link them with the parent (the parent is taken once)
+        // the children that cannot be linked (the parent was erased meanwhile) are erased
+        inline std::size_t jobs_add_children(const JobsID& parent_jobs_id, const std::vector<std::shared_ptr<JobsItem>>& children_jobs_items, std::vector<std::shared_ptr<JobsItem>>& added_jobs_items, std::vector<JobsID>* children_jobs_ids)
+        {
+            if (children_jobs_ids) {
+                children_jobs_ids->clear();
+            }
+
+            auto parent_jobs_item = jobs_get(parent_jobs_id);
+            if (!parent_jobs_item) {
+                return 0;
+            }
+
+            if (!jobs_add(children_jobs_items, added_jobs_items, children_jobs_ids)) {
+                return 0;
+            }
+
+            // keep only the linked children
+            std::size_t count = 0;
+            for (std::size_t i = 0; i < added_jobs_items.size(); ++i) {
+                auto& child_jobs_item = added_jobs_items[i];
+                if (!jobs_parent_child(parent_jobs_item, child_jobs_item)) {
+                    jobs_erase(child_jobs_item->m_id);
+                    continue;
+                }
+                if (i != count) {
+                    added_jobs_items[count] = std::move(child_jobs_item);
+                }
+                if (children_jobs_ids) {
+                    (*children_jobs_ids)[count] = added_jobs_items[count]->m_id;
+                }
+                ++count;
+            }
+            added_jobs_items.resize(count);
+            if (children_jobs_ids) {
+                children_jobs_ids->resize(count);
+            }
+            return count;
+        }
+
         //
         // start the jobs
         //
-        inline std::size_t jobs_start(const JobsPrioT& priority, std::shared_ptr<JobsItem> jobs_item)
+        inline std::size_t jobs_start(const JobsPrioT& priority, const std::shared_ptr<JobsItem>& jobs_item)
         {
             std::size_t ret = 0;
             if (!jobs_item || !jobs_item->m_id) {
                 return ret;
             }
 
+            // a job with the same request in progress (or cached) gives the response without processing
+            // and a job over the rate limit of its type is started later
+            if (m_parent_caller.jobs_deduplicated(jobs_item)) {
+                return 1;
+            }
+            if (m_parent_caller.jobs_rate_limited(priority, jobs_item, ret)) {
+                return ret;
+            }
+
             auto* q = get_jobs_type_queue(jobs_item->m_type);
             if (q) {
-                ret = q->push_back(priority, jobs_item->m_id);
+                ret = jobs_push(*q, priority, jobs_item);
             }
 
             if (ret) {
@@ -649,44 +763,146 @@ namespace small::jobsimpl {
 
         inline std::size_t jobs_start(const JobsPrioT& priority, const std::vector<JobsID>& jobs_ids)
         {
-            return jobs_start(priority, jobs_get(jobs_ids));
+            JobsScratchItems jobs_items;
+            jobs_get_items(jobs_ids, *jobs_items);
+            return jobs_start(priority, *jobs_items);
         }
 
+        // the jobs are pushed into the queue of their group at once and each group is scheduled once
+        // (the groups are taken in the order of their first job)
         inline std::size_t jobs_start(const JobsPrioT& priority, const std::vector<std::shared_ptr<JobsItem>>& jobs_items)
         {
-            std::size_t count = 0;
+            const auto jobs_count = jobs_items.size();
+
+            // the queue of each job (nullptr when it was already pushed or it is not valid or it does not need processing or it is started later)
+            std::size_t                                      count = 0;
+            small::jobsimpl::jobs_scratch_vector<JobsQueue*> jobs_queues;
+            jobs_queues->reserve(jobs_count);
             for (auto& jobs_item : jobs_items) {
-                auto ret = jobs_start(priority, jobs_item);
-                if (ret) {
+                JobsQueue*  q       = nullptr;
+                std::size_t started = 0;
+                if (jobs_item && jobs_item->m_id && m_parent_caller.jobs_deduplicated(jobs_item)) {
                     ++count;
+                } else if (jobs_item && jobs_item->m_id && m_parent_caller.jobs_rate_limited(priority, jobs_item, started)) {
+                    count += started;
+                } else if (jobs_item && jobs_item->m_id) {
+                    q = get_jobs_type_queue(jobs_item->m_type);
+                    if (!q) {
+                        // call parent for extra processing and erasing
+                        m_parent_caller.jobs_cancelled(jobs_item);
+                    }
                 }
+                jobs_queues->push_back(q);
+            }
+
+            JobsScratchIDs                                    group_jobs_ids;
+            small::jobsimpl::jobs_scratch_vector<std::size_t> group_jobs_indexes;
+            for (std::size_t i = 0; i < jobs_count; ++i) {
+                auto* q = (*jobs_queues)[i];
+                if (!q) {
+                    continue;
+                }
+
+                // all the jobs of this group (the jobs with their own flow or deadline are pushed one by one)
+                std::size_t ret = 0;
+                group_jobs_ids->clear();
+                group_jobs_indexes->clear();
+                for (std::size_t j = i; j < jobs_count; ++j) {
+                    if ((*jobs_queues)[j] != q) {
+                        continue;
+                    }
+                    (*jobs_queues)[j] = nullptr;
+                    if (!is_jobs_push_bulk(jobs_items[j])) {
+                        if (jobs_push(*q, priority, jobs_items[j])) {
+                            ++ret;
+                        } else {
+                            // call parent for extra processing and erasing
+                            m_parent_caller.jobs_cancelled(jobs_items[j]);
+                        }
+                        continue;
+                    }
+                    group_jobs_ids->push_back(jobs_items[j]->m_id);
+                    group_jobs_indexes->push_back(j);
+                }
+
+                auto ret_bulk = group_jobs_ids->empty() ? 0 : q->push_back(priority, *group_jobs_ids);
+
+                // the jobs that did not fit (the queue is exiting)
+                for (std::size_t k = ret_bulk; k < group_jobs_indexes->size(); ++k) {
+                    // call parent for extra processing and erasing
+                    m_parent_caller.jobs_cancelled(jobs_items[(*group_jobs_indexes)[k]]);
+                }
+
+                ret += ret_bulk;
+                if (ret) {
+                    m_parent_caller.jobs_schedule(jobs_items[i], ret);
+                }
+                count += ret;
             }
             return count;
         }
 
+        //
+        // push the job into the queue of its group (with its flow and its deadline if it has them)
+        //
+        inline std::size_t jobs_push(JobsQueue& q, const JobsPrioT& priority, const std::shared_ptr<JobsItem>& jobs_item)
+        {
+            if (jobs_item->m_flow && jobs_item->m_deadline) {
+                return q.push_back_flow_deadline_until(*jobs_item->m_deadline, priority, *jobs_item->m_flow, jobs_item->m_id);
+            }
+            if (jobs_item->m_flow) {
+                return q.push_back_flow(priority, *jobs_item->m_flow, jobs_item->m_id);
+            }
+            if (jobs_item->m_deadline) {
+                return q.push_back_deadline_until(*jobs_item->m_deadline, priority, jobs_item->m_id);
+            }
+            return q.push_back(priority, jobs_item->m_id);
+        }
+
+        // the job can be pushed with the other jobs of its group at once
+        static inline bool is_jobs_push_bulk(const std::shared_ptr<JobsItem>& jobs_item)
+        {
+            return !jobs_item->m_flow && !jobs_item->m_deadline;
+        }
+
         //
         // erase jobs item
         //
         inline void jobs_erase(const JobsID& jobs_id)
         {
-            std::unique_lock l(m_lock);
+            // the children are erased in a loop and not recursively (the jobs with dependencies can be very deep)
+            JobsScratchIDs erase_jobs_ids;
+            erase_jobs_ids->push_back(jobs_id);
+            while (!erase_jobs_ids->empty()) {
+                const auto id = erase_jobs_ids->back();
+                erase_jobs_ids->pop_back();
+
+                auto jobs_item = m_jobs.erase(id);
+                if (!jobs_item) {
+                    // already deleted
+                    continue;
+                }
 
-            auto jobs_item = jobs_get(jobs_id);
-            if (!jobs_item) {
-                // already deleted
-                return;
-            }
-            // if not a final state, set it to cancelled (in case it is executing at this point)
-            if (!JobsItem::is_state_complete(jobs_item->get_state())) {
-                jobs_item->set_state_cancelled();
-            }
+                // if not a final state, set it to cancelled (in case it is executing at this point)
+                if (!JobsItem::is_state_complete(jobs_item->get_state())) {
+                    jobs_item->set_state_cancelled();
+                    m_parent_caller.jobs_erased(jobs_item);
+                }
 
-            m_jobs.erase(jobs_id);
-            m_lock.notify_all();
+                // delete all children, a child with more parents is deleted with the last one
+                // (taken after the job is not found anymore, so no other child can be linked to it, see jobs_parent_child)
+                for (auto& child_jobs_id : jobs_item->get_children_list()) {
+                    auto child_jobs_item = jobs_get(child_jobs_id);
+                    if (child_jobs_item && --child_jobs_item->m_parents_left == 0) {
+                        erase_jobs_ids->push_back(child_jobs_id);
+                    }
+                }
+            }
 
-            // recursive delete all children
-            for (auto& child_jobs_id : jobs_item->m_childrenIDs) {
-                jobs_erase(child_jobs_id);
+            // wake up wait (under lock so the notification is not lost, and only if someone waits because the lock can be held by a user transaction)
+            if (m_jobs.empty() && m_jobs_waiting.load() > 0) {
+                std::unique_lock l(m_lock);
+                m_lock.notify_all();
             }
         }
 
@@ -695,8 +911,6 @@ namespace small::jobsimpl {
         //
         inline std::size_t jobs_parent_child(const JobsID& parent_jobs_id, const JobsID& child_jobs_id)
         {
-            std::unique_lock l(m_lock);
-
             auto parent_jobs_item = jobs_get(parent_jobs_id);
             if (!parent_jobs_item) {
                 return 0;
@@ -706,15 +920,28 @@ namespace small::jobsimpl {
                 return 0;
             }
 
-            jobs_parent_child(parent_jobs_item, child_jobs_item);
-            return 1;
+            return jobs_parent_child(parent_jobs_item, child_jobs_item) ? 1 : 0;
         }
 
-        inline void jobs_parent_child(std::shared_ptr<JobsItem> parent_jobs_item, std::shared_ptr<JobsItem> child_jobs_item)
+        // returns false if the parent was erased (checked under the lock of the parent, because jobs_erase takes the children after erasing)
+        inline bool jobs_parent_child(const std::shared_ptr<JobsItem>& parent_jobs_item, const std::shared_ptr<JobsItem>& child_jobs_item)
         {
-            std::unique_lock l(m_lock);
-            parent_jobs_item->add_child(child_jobs_item->m_id);
-            child_jobs_item->add_parent(parent_jobs_item->m_id);
+            {
+                std::unique_lock l(parent_jobs_item->m_lock);
+                if (!jobs_get(parent_jobs_item->m_id)) {
+                    return false;
+                }
+                parent_jobs_item->add_child(child_jobs_item->m_id);
+                // (counted under the lock of the parent, so the erase of the parent finds the child only after it is counted)
+                ++child_jobs_item->m_parents_left;
+            }
+            {
+                // the new parent gets what the child has already added to the aggregates of its other parents
+                std::unique_lock l(child_jobs_item->m_lock);
+                child_jobs_item->add_parent(parent_jobs_item->m_id);
+                parent_jobs_item->add_child_delta(child_jobs_item->get_reported());
+            }
+            return true;
         }
 
     private:
@@ -731,6 +958,11 @@ namespace small::jobsimpl {
         //
         friend JobQueueDelayedT;
 
+        inline void delayed_thread_started()
+        {
+            m_parent_caller.set_thread_name("delay");
+        }
+
         inline std::size_t push_back(std::vector<JobDelayedItems>&& items)
         {
             std::size_t count = 0;
@@ -744,11 +976,11 @@ namespace small::jobsimpl {
         //
         // members
         //
-        mutable small::base_lock                              m_lock;          // global locker
-        std::atomic<JobsID>                                   m_jobs_seq_id{}; // to get the next jobs id
-        std::unordered_map<JobsID, std::shared_ptr<JobsItem>> m_jobs;          // current jobs
-        std::unordered_map<JobsGroupT, JobsQueue>             m_groups_queues; // map of queues by group
-        std::unordered_map<JobsTypeT, JobsQueue*>             m_types_queues;  // optimize to have queues by type (which reference queues by group)
+        mutable small::base_lock                         m_lock;           // global locker (for user transactions and waiting)
+        small::jobsimpl::jobs_slot_map<JobsItem, JobsID> m_jobs;           // current jobs
+        std::atomic<int>                                 m_jobs_waiting{}; // how many threads wait for the jobs to finish
+        std::unordered_map<JobsGroupT, JobsQueue>        m_groups_queues;  // map of queues by group
+        std::unordered_map<JobsTypeT, JobsQueue*>        m_types_queues;   // optimize to have queues by type (which reference queues by group)
 
         JobQueueDelayedT m_delayed_items{*this}; // queue of delayed items
 
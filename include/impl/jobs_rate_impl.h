@@ -0,0 +1,94 @@
+#pragma once
+
+#include "impl_common.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace small::jobsimpl {
+
+    //
+    // token bucket for a rate limit (rate tokens per second and at most burst tokens at once)
+    // it keeps only the time when the bucket will be full again (generic cell rate algorithm), so the tokens are refilled
+    // by the time that passed when they are taken (with a compare exchange, without a lock and without a thread)
+    //
+    class jobs_token_bucket
+    {
+    public:
+        jobs_token_bucket(const double rate, const std::size_t burst)
+            : m_interval(static_cast<std::int64_t>(1'000'000'000.0 / std::max<>(rate, 1e-9))),
+              m_burst_interval(m_interval * static_cast<std::int64_t>(std::max<std::size_t>(burst, 1))) {}
+
+        //
+        // take up to count tokens now, returns how many were taken
+        // (if none then wait is set to the time until the next token)
+        //
+        inline std::size_t try_take(const std::size_t count, std::chrono::nanoseconds* wait = nullptr)
+        {
+            const auto now  = now_ns();
+            auto       full = m_full.load(std::memory_order_relaxed);
+            while (true) {
+                // the tokens are the time until the bucket is full again
+                const auto start     = std::max<>(full, now);
+                const auto available = (now + m_burst_interval - start) / m_interval;
+                if (available <= 0) {
+                    if (wait) {
+                        *wait = std::chrono::nanoseconds(start + m_interval - m_burst_interval - now);
+                    }
+                    return 0;
+                }
+
+                const auto take = std::min<>(available, static_cast<std::int64_t>(count));
+                if (m_full.compare_exchange_weak(full, start + take * m_interval, std::memory_order_acq_rel, std::memory_order_relaxed)) {
+                    return static_cast<std::size_t>(take);
+                }
+            }
+        }
+
+        //
+        // give back the tokens that were taken but not used
+        //
+        inline void give_back(const std::size_t count)
+        {
+            if (count) {
+                m_full.fetch_sub(static_cast<std::int64_t>(count) * m_interval, std::memory_order_acq_rel);
+            }
+        }
+
+        //
+        // reserve a token (always), returns how long to wait until it is available (0 if it is available now)
+        //
+        inline std::chrono::nanoseconds reserve()
+        {
+            const auto now  = now_ns();
+            auto       full = m_full.load(std::memory_order_relaxed);
+            while (!m_full.compare_exchange_weak(full, std::max<>(full, now) + m_interval, std::memory_order_acq_rel, std::memory_order_relaxed)) {
+            }
+            const auto wait = std::max<>(full, now) + m_interval - m_burst_interval - now;
+            return std::chrono::nanoseconds(std::max<std::int64_t>(wait, 0));
+        }
+
+    private:
+        static inline std::int64_t now_ns()
+        {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
+    private:
+        // some prevention
+        jobs_token_bucket(const jobs_token_bucket&)            = delete;
+        jobs_token_bucket(jobs_token_bucket&&)                 = delete;
+        jobs_token_bucket& operator=(const jobs_token_bucket&) = delete;
+        jobs_token_bucket& operator=(jobs_token_bucket&& __t)  = delete;
+
+    private:
+        //
+        // members
+        //
+        std::int64_t              m_interval{};       // time for one token (ns)
+        std::int64_t              m_burst_interval{}; // time for a full bucket (ns)
+        std::atomic<std::int64_t> m_full{};           // when the bucket is full again (steady clock ns), a token is taken by moving it forward
+    };
+} // namespace small::jobsimpl
@@ -0,0 +1,332 @@
+#pragma once
+
+#include "impl_common.h"
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "../spinlock.h"
+
+namespace small::jobsimpl {
+
+    //
+    // generational slot map for the jobs items
+    // the id packs the index of the slot (low 32 bits) and the generation of the slot (high 32 bits),
+    // so getting a job is an array index and a generation check (a stale id is detected without hashing)
+    // and the slots are reused for the next jobs (the erased slot gets a new generation)
+    // the slots are allocated in segments of growing size that are never moved, so they can be read without a global lock
+    // (each slot has its own lock for the item, the free slots are kept in a lock free list)
+    //
+    template <typename JobsItemT, typename JobsID = unsigned long long>
+    class jobs_slot_map
+    {
+    public:
+        jobs_slot_map() = default;
+        ~jobs_slot_map()
+        {
+            for (auto& segment : m_segments) {
+                delete[] segment.load(std::memory_order_relaxed);
+            }
+        }
+
+        // clang-format off
+        // how many items
+        inline std::size_t  size    () const { return m_size.load(); }
+        // empty
+        inline bool         empty   () const { return size() == 0; }
+        // clang-format on
+
+        //
+        // add the item in a free slot and return its id (0 if there are no more slots)
+        //
+        inline JobsID add(const std::shared_ptr<JobsItemT>& item)
+        {
+            auto index = pop_free();
+            if (index == kNoIndex) {
+                return 0;
+            }
+
+            ++m_size;
+            return set_item(index, item);
+        }
+
+        //
+        // add many items, the free slots are reused and the new slots are reserved at once
+        // (ids has the id for each item, 0 for a null item or if there are no more slots)
+        //
+        inline std::size_t add(const std::vector<std::shared_ptr<JobsItemT>>& items, std::vector<JobsID>& ids)
+        {
+            ids.assign(items.size(), 0);
+
+            std::size_t count = 0;
+            for (auto& item : items) {
+                count += item ? 1 : 0;
+            }
+            // counted before the items are set, so the map is not seen empty while they are added
+            m_size += count;
+
+            std::size_t added = 0;
+            std::size_t i     = 0;
+            for (; i < items.size() && added < count; ++i) {
+                if (!items[i]) {
+                    continue;
+                }
+                auto index = pop_free_list();
+                if (index == kNoIndex) {
+                    break;
+                }
+                ids[i] = set_item(index, items[i]);
+                ++added;
+            }
+
+            auto index = new_slots(static_cast<std::uint32_t>(count - added));
+            if (index != kNoIndex) {
+                for (; i < items.size(); ++i) {
+                    if (items[i]) {
+                        ids[i] = set_item(index++, items[i]);
+                        ++added;
+                    }
+                }
+            }
+
+            m_size -= count - added;
+            return added;
+        }
+
+        //
+        // get the item (nullptr if the id is stale)
+        //
+        inline std::shared_ptr<JobsItemT> get(const JobsID& id) const
+        {
+            auto* slot = find_slot(id);
+            if (!slot) {
+                return nullptr;
+            }
+
+            std::unique_lock l(slot->m_lock);
+            if (slot->m_generation.load(std::memory_order_relaxed) != id_generation(id)) {
+                return nullptr;
+            }
+            return slot->m_item;
+        }
+
+        //
+        // erase the item and return it (nullptr if already erased), the slot gets a new generation and is reused
+        //
+        inline std::shared_ptr<JobsItemT> erase(const JobsID& id)
+        {
+            auto* slot = find_slot(id);
+            if (!slot) {
+                return nullptr;
+            }
+
+            std::shared_ptr<JobsItemT> item;
+            {
+                std::unique_lock l(slot->m_lock);
+                if (slot->m_generation.load(std::memory_order_relaxed) != id_generation(id) || !slot->m_item) {
+                    return nullptr;
+                }
+                item = std::move(slot->m_item);
+                slot->m_item.reset();
+                next_generation(*slot);
+            }
+
+            push_free(id_index(id));
+            --m_size;
+            return item;
+        }
+
+        //
+        // erase all items, returns how many were erased
+        //
+        inline std::size_t clear()
+        {
+            std::size_t count = 0;
+
+            const auto slots_count = m_slots_next.load();
+            for (std::uint32_t index = 0; index < slots_count; ++index) {
+                auto* slot = segment_slot(index);
+                if (!slot) {
+                    continue;
+                }
+
+                std::shared_ptr<JobsItemT> item;
+                {
+                    std::unique_lock l(slot->m_lock);
+                    if (!slot->m_item) {
+                        continue;
+                    }
+                    item = std::move(slot->m_item);
+                    slot->m_item.reset();
+                    next_generation(*slot);
+                }
+                push_free(index);
+                --m_size;
+                ++count;
+            }
+            return count;
+        }
+
+    private:
+        //
+        // slots are in segments, segment k has kFirstSegmentSize << k slots
+        //
+        static constexpr std::uint32_t kNoIndex          = 0xFFFF'FFFF;
+        static constexpr std::uint32_t kFirstSegmentSize = 1024;
+        static constexpr std::size_t   kSegmentsCount    = 22; // 4 billions slots
+
+        struct Slot
+        {
+            std::atomic<std::uint32_t> m_generation{1};       // generation of the current item (never 0, so the ids are never 0)
+            mutable small::spinlock    m_lock;                // lock for the item
+            std::shared_ptr<JobsItemT> m_item;                // the item
+            std::atomic<std::uint32_t> m_next_free{kNoIndex}; // next free slot
+        };
+
+        // clang-format off
+        static inline JobsID        make_id         (const std::uint32_t index, const std::uint32_t generation) { return (static_cast<JobsID>(generation) << 32) | index; }
+        static inline std::uint32_t id_index        (const JobsID& id) { return static_cast<std::uint32_t>(id & 0xFFFF'FFFF); }
+        static inline std::uint32_t id_generation   (const JobsID& id) { return static_cast<std::uint32_t>(id >> 32); }
+        // clang-format on
+
+        static inline void next_generation(Slot& slot)
+        {
+            auto generation = slot.m_generation.load(std::memory_order_relaxed) + 1;
+            slot.m_generation.store(generation ? generation : 1, std::memory_order_release);
+        }
+
+        //
+        // segment and offset for an index
+        //
+        static inline std::pair<std::size_t, std::uint32_t> segment_position(const std::uint32_t index)
+        {
+            const auto segment = static_cast<std::size_t>(std::bit_width(index / kFirstSegmentSize + 1) - 1);
+            const auto offset  = index - kFirstSegmentSize * ((1u << segment) - 1);
+            return {segment, offset};
+        }
+
+        inline Slot* segment_slot(const std::uint32_t index) const
+        {
+            auto [segment, offset] = segment_position(index);
+            if (segment >= kSegmentsCount) {
+                return nullptr;
+            }
+            auto* slots = m_segments[segment].load(std::memory_order_acquire);
+            return slots ? &slots[offset] : nullptr;
+        }
+
+        // the slot is known to exist
+        inline Slot& get_slot(const std::uint32_t index)
+        {
+            return *segment_slot(index);
+        }
+
+        // the slot for an id if it exists and has the same generation (without lock)
+        // (the slots of an allocated segment that are not used yet have no item)
+        inline Slot* find_slot(const JobsID& id) const
+        {
+            auto* slot = segment_slot(id_index(id));
+            if (!slot || slot->m_generation.load(std::memory_order_acquire) != id_generation(id)) {
+                return nullptr;
+            }
+            return slot;
+        }
+
+        //
+        // free list of slots (the head has a tag that is changed on every update, against ABA)
+        //
+        // clang-format off
+        static inline std::uint64_t make_head   (const std::uint32_t index, const std::uint32_t tag) { return (static_cast<std::uint64_t>(tag) << 32) | index; }
+        static inline std::uint32_t head_index  (const std::uint64_t head) { return static_cast<std::uint32_t>(head & 0xFFFF'FFFF); }
+        static inline std::uint32_t head_tag    (const std::uint64_t head) { return static_cast<std::uint32_t>(head >> 32); }
+        // clang-format on
+
+        inline std::uint32_t pop_free()
+        {
+            auto index = pop_free_list();
+            if (index != kNoIndex) {
+                return index;
+            }
+
+            // no free slot, take a new one
+            return new_slots(1);
+        }
+
+        inline std::uint32_t pop_free_list()
+        {
+            auto head = m_free_head.load(std::memory_order_acquire);
+            while (head_index(head) != kNoIndex) {
+                auto& slot = get_slot(head_index(head));
+                auto  next = make_head(slot.m_next_free.load(std::memory_order_relaxed), head_tag(head) + 1);
+                if (m_free_head.compare_exchange_weak(head, next, std::memory_order_acq_rel, std::memory_order_acquire)) {
+                    return head_index(head);
+                }
+            }
+            return kNoIndex;
+        }
+
+        inline void push_free(const std::uint32_t index)
+        {
+            auto& slot = get_slot(index);
+            auto  head = m_free_head.load(std::memory_order_relaxed);
+            do {
+                slot.m_next_free.store(head_index(head), std::memory_order_relaxed);
+            } while (!m_free_head.compare_exchange_weak(head, make_head(index, head_tag(head) + 1), std::memory_order_release, std::memory_order_relaxed));
+        }
+
+        // reserve count new slots with consecutive indexes (returns the first one)
+        inline std::uint32_t new_slots(const std::uint32_t count)
+        {
+            if (count == 0) {
+                return kNoIndex;
+            }
+
+            const auto index = m_slots_next.fetch_add(count);
+            if (index >= kNoIndex - count) {
+                return kNoIndex;
+            }
+
+            const auto first_segment = segment_position(index).first;
+            const auto last_segment  = segment_position(index + count - 1).first;
+            for (auto segment = first_segment; segment <= last_segment; ++segment) {
+                if (!m_segments[segment].load(std::memory_order_acquire)) {
+                    std::unique_lock l(m_segments_lock);
+                    if (!m_segments[segment].load(std::memory_order_relaxed)) {
+                        m_segments[segment].store(new Slot[kFirstSegmentSize << segment], std::memory_order_release);
+                    }
+                }
+            }
+            return index;
+        }
+
+        inline JobsID set_item(const std::uint32_t index, const std::shared_ptr<JobsItemT>& item)
+        {
+            auto&            slot = get_slot(index);
+            std::unique_lock l(slot.m_lock);
+            slot.m_item = item;
+            return make_id(index, slot.m_generation.load(std::memory_order_relaxed));
+        }
+
+    private:
+        // some prevention
+        jobs_slot_map(const jobs_slot_map&)            = delete;
+        jobs_slot_map(jobs_slot_map&&)                 = delete;
+        jobs_slot_map& operator=(const jobs_slot_map&) = delete;
+        jobs_slot_map& operator=(jobs_slot_map&& __t)  = delete;
+
+    private:
+        //
+        // members
+        //
+        std::array<std::atomic<Slot*>, kSegmentsCount> m_segments{};                         // segments of slots
+        std::mutex                                     m_segments_lock;                      // for allocating a segment
+        std::atomic<std::uint32_t>                     m_slots_next{};                       // next new slot
+        std::atomic<std::uint64_t>                     m_free_head{make_head(kNoIndex, 0)}; // free slots
+        std::atomic<std::size_t>                       m_size{};                             // how many items
+    };
+} // namespace small::jobsimpl
@@ -7,14 +7,17 @@
 namespace small::jobsimpl {
 
     //
-    // helper class for jobs_engine for job item state (parent caller must implement 'jobs_get', 'jobs_completed')
+    // helper class for jobs_engine for job item state (parent caller must implement 'jobs_get', 'jobs_get_items', 'jobs_completed')
     //
     template <typename JobsTypeT, typename JobsRequestT, typename JobsResponseT, typename ParentCallerT>
     class jobs_state_impl
     {
     public:
-        using JobsItem = typename small::jobsimpl::jobs_item<JobsTypeT, JobsRequestT, JobsResponseT>;
-        using JobsID   = typename JobsItem::JobsID;
+        using JobsItem    = typename small::jobsimpl::jobs_item<JobsTypeT, JobsRequestT, JobsResponseT>;
+        using JobsID      = typename JobsItem::JobsID;
+        using JobsIDsList = typename JobsItem::JobsIDsList;
+
+        using JobsScratchItems = small::jobsimpl::jobs_scratch_vector<std::shared_ptr<JobsItem>>;
 
         //
         // jobs_state_impl
@@ -41,7 +44,7 @@ namespace small::jobsimpl {
             return jobs_progress(jobs_get(jobs_id), progress, update_parent);
         }
 
-        inline bool jobs_progress(std::shared_ptr<JobsItem> jobs_item, const int& progress, const bool update_parent = true)
+        inline bool jobs_progress(const std::shared_ptr<JobsItem>& jobs_item, const int& progress, const bool update_parent = true)
         {
             if (!jobs_item) {
                 return false;
@@ -54,16 +57,9 @@ namespace small::jobsimpl {
             } else {
                 // recursively update parents
                 if (update_parent && jobs_item->has_parents()) {
-                    std::vector<std::shared_ptr<JobsItem>> jobs_parents;
-                    {
-                        std::unique_lock l(*this);
-                        jobs_parents = jobs_get(jobs_item->m_parentIDs);
-                    }
-                    for (auto& jobs_parent : jobs_parents) {
-                        if (!jobs_parent) {
-                            continue;
-                        }
-
+                    JobsScratchItems jobs_parents;
+                    jobs_update_parents(jobs_item, *jobs_parents);
+                    for (auto& jobs_parent : *jobs_parents) {
                         int                            jobs_parent_progress = 0;
                         small::jobsimpl::EnumJobsState jobs_parent_state    = small::jobsimpl::EnumJobsState::kInProgress;
 
@@ -81,32 +77,30 @@ namespace small::jobsimpl {
         //
         inline bool jobs_response(const JobsID& jobs_id, const JobsResponseT& jobs_response)
         {
-            std::unique_lock l(*this);
             return jobs_response(jobs_get(jobs_id), jobs_response);
         }
 
         inline bool jobs_response(const JobsID& jobs_id, JobsResponseT&& jobs_response)
         {
-            std::unique_lock l(*this);
             return jobs_response(jobs_get(jobs_id), std::forward<JobsResponseT>(jobs_response));
         }
 
-        inline bool jobs_response(std::shared_ptr<JobsItem> jobs_item, const JobsResponseT& jobs_response)
+        inline bool jobs_response(const std::shared_ptr<JobsItem>& jobs_item, const JobsResponseT& jobs_response)
         {
             if (!jobs_item) {
                 return false;
             }
-            std::unique_lock l(*this);
+            std::unique_lock l(jobs_item->m_lock);
             jobs_item->m_response = jobs_response;
             return true;
         }
 
-        inline bool jobs_response(std::shared_ptr<JobsItem> jobs_item, JobsResponseT&& jobs_response)
+        inline bool jobs_response(const std::shared_ptr<JobsItem>& jobs_item, JobsResponseT&& jobs_response)
         {
             if (!jobs_item) {
                 return false;
             }
-            std::unique_lock l(*this);
+            std::unique_lock l(jobs_item->m_lock);
             jobs_item->m_response = std::move(jobs_response);
             return true;
         }
@@ -229,7 +223,7 @@ namespace small::jobsimpl {
         // apply state
         // return true if the state was changed
         //
-        inline bool jobs_state(std::shared_ptr<JobsItem> jobs_item, const small::jobsimpl::EnumJobsState& state)
+        inline bool jobs_state(const std::shared_ptr<JobsItem>& jobs_item, const small::jobsimpl::EnumJobsState& state)
         {
             if (!jobs_item) {
                 return false;
@@ -243,12 +237,12 @@ namespace small::jobsimpl {
             return ret;
         }
 
-        inline bool jobs_state(std::shared_ptr<JobsItem> jobs_item, const small::jobsimpl::EnumJobsState& state, const JobsResponseT& response)
+        inline bool jobs_state(const std::shared_ptr<JobsItem>& jobs_item, const small::jobsimpl::EnumJobsState& state, const JobsResponseT& response)
         {
             jobs_response(jobs_item, response);
             return jobs_state(jobs_item, state);
         }
-        inline bool jobs_state(std::shared_ptr<JobsItem> jobs_item, const small::jobsimpl::EnumJobsState& state, JobsResponseT&& response)
+        inline bool jobs_state(const std::shared_ptr<JobsItem>& jobs_item, const small::jobsimpl::EnumJobsState& state, JobsResponseT&& response)
         {
             jobs_response(jobs_item, std::forward<JobsResponseT>(response));
             return jobs_state(jobs_item, state);
@@ -256,9 +250,8 @@ namespace small::jobsimpl {
 
         inline std::size_t jobs_state(const std::vector<std::shared_ptr<JobsItem>>& jobs_items, const small::jobsimpl::EnumJobsState& jobs_state)
         {
-            small::jobsimpl::EnumJobsState         set_state = jobs_state;
-            std::vector<std::shared_ptr<JobsItem>> completed_items;
-            completed_items.reserve(jobs_items.size());
+            small::jobsimpl::EnumJobsState set_state = jobs_state;
+            JobsScratchItems               completed_items;
 
             std::size_t changed_count{};
             for (auto& jobs_item : jobs_items) {
@@ -266,50 +259,42 @@ namespace small::jobsimpl {
                 if (ret) {
                     ++changed_count;
                     if (JobsItem::is_state_complete(set_state)) {
-                        completed_items.push_back(jobs_item);
+                        completed_items->push_back(jobs_item);
                     }
                 }
             }
 
-            jobs_completed(completed_items);
+            jobs_completed(*completed_items);
             return changed_count;
         }
 
+        //
+        // add the changes of a child (progress, completed, failed) to the aggregates of its parents and get the parents
+        //
+        inline void jobs_update_parents(const std::shared_ptr<JobsItem>& jobs_item, std::vector<std::shared_ptr<JobsItem>>& jobs_parents)
+        {
+            small::jobsimpl::jobs_child_delta delta;
+            auto                              parents_ids = jobs_item->take_child_delta(delta);
+
+            jobs_get(parents_ids, jobs_parents);
+            for (auto& jobs_parent : jobs_parents) {
+                jobs_parent->add_child_delta(delta);
+            }
+        }
+
         //
         // get children states
-        // compute state and progress based on children
+        // compute state and progress based on the aggregates of the children (updated by jobs_update_parents)
         //      if at least one child has failed/timeout/cancelled then parent is set to failed
         //      else if all children are finished then the parent is finished
         //      else parent is set to wait for children (at least one child is in progress)
         //
-        inline void get_children_states(std::shared_ptr<JobsItem> jobs_parent, small::jobsimpl::EnumJobsState* jobs_state, int* jobs_progress)
+        inline void get_children_states(const std::shared_ptr<JobsItem>& jobs_parent, small::jobsimpl::EnumJobsState* jobs_state, int* jobs_progress)
         {
-            // get all children
-            std::vector<std::shared_ptr<JobsItem>> all_children;
-            {
-                std::unique_lock l(*this);
-                all_children = jobs_get(jobs_parent->m_childrenIDs);
-            }
-
-            // compute state & progress
-            std::size_t count_progress           = 0;
-            std::size_t count_failed_children    = 0;
-            std::size_t count_completed_children = 0;
-            std::size_t count_total_children     = all_children.size();
-
-            for (auto& child_jobs_item : all_children) {
-                if (!child_jobs_item->is_complete()) {
-                    // is in progress
-                    count_progress += child_jobs_item->get_progress();
-                    continue;
-                }
-
-                count_progress += 100;
-                ++count_completed_children;
-                if (!child_jobs_item->is_state_finished()) {
-                    ++count_failed_children;
-                }
-            }
+            const std::size_t count_total_children     = jobs_parent->m_children_count.load();
+            const std::size_t count_completed_children = jobs_parent->m_children_completed.load();
+            const std::size_t count_failed_children    = jobs_parent->m_children_failed.load();
+            const long long   count_progress           = jobs_parent->m_children_progress.load();
 
             // if at least one child has failed/timeout/cancelled then parent is set to failed
             if (count_failed_children) {
@@ -323,7 +308,7 @@ namespace small::jobsimpl {
             }
 
             // if all children are finished then the parent is finished
-            if (count_total_children == count_completed_children) {
+            if (count_completed_children >= count_total_children) {
                 if (jobs_state) {
                     *jobs_state = small::jobsimpl::EnumJobsState::kFinished;
                 }
@@ -338,7 +323,7 @@ namespace small::jobsimpl {
                 *jobs_state = small::jobsimpl::EnumJobsState::kWaitChildren;
             }
             if (jobs_progress) {
-                *jobs_progress = static_cast<int>(count_progress / count_total_children); // will not be zero due to count_total_children == count_completed_children
+                *jobs_progress = static_cast<int>(count_progress / static_cast<long long>(count_total_children)); // will not be zero due to count_total_children > count_completed_children
             }
         }
 
@@ -346,13 +331,18 @@ namespace small::jobsimpl {
         //
         // apply current state
         //
-        inline bool jobs_apply_state(std::shared_ptr<JobsItem> jobs_item, const small::jobsimpl::EnumJobsState& jobs_state, small::jobsimpl::EnumJobsState* jobs_set_state) const
+        inline bool jobs_apply_state(const std::shared_ptr<JobsItem>& jobs_item, const small::jobsimpl::EnumJobsState& jobs_state, small::jobsimpl::EnumJobsState* jobs_set_state)
         {
             *jobs_set_state = jobs_state;
 
             // set the jobs as waitforchildren only if there are children otherwise advance to finish
-            if (*jobs_set_state == small::jobsimpl::EnumJobsState::kWaitChildren && !jobs_item->has_children()) {
-                *jobs_set_state = small::jobsimpl::EnumJobsState::kFinished;
+            // (or to the state of the children if they are already completed, like for the jobs started after their children)
+            if (*jobs_set_state == small::jobsimpl::EnumJobsState::kWaitChildren) {
+                if (!jobs_item->has_children()) {
+                    *jobs_set_state = small::jobsimpl::EnumJobsState::kFinished;
+                } else if (jobs_item->m_children_completed.load() >= jobs_item->m_children_count.load()) {
+                    get_children_states(jobs_item, jobs_set_state, nullptr);
+                }
             }
 
             // set the jobs as timeout only if it is not finished until now
@@ -376,7 +366,12 @@ namespace small::jobsimpl {
             return m_parent_caller.jobs_get(jobs_ids);
         }
 
-        inline void jobs_completed(std::shared_ptr<JobsItem> jobs_item)
+        inline void jobs_get(const JobsIDsList& jobs_ids, std::vector<std::shared_ptr<JobsItem>>& jobs_items)
+        {
+            m_parent_caller.jobs_get_items(jobs_ids, jobs_items);
+        }
+
+        inline void jobs_completed(const std::shared_ptr<JobsItem>& jobs_item)
         {
             return m_parent_caller.jobs_completed(jobs_item);
         }
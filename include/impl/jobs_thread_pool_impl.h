@@ -16,8 +16,13 @@ namespace small::jobsimpl {
         //
         // jobs_thread_pool
         //
-        explicit jobs_thread_pool(ParentCallerT& parent_caller)
-            : m_parent_caller(parent_caller)
+        explicit jobs_thread_pool(ParentCallerT& parent_caller, const small::config_threads& config_threads = {})
+            : m_workers({.threads_count        = 0,
+                         .stack_size           = config_threads.stack_size,
+                         .function_thread_init = config_threads.function_thread_init,
+                         .function_thread_exit = config_threads.function_thread_exit},
+                        JobWorkerThreadFunction(), this),
+              m_parent_caller(parent_caller)
         {
         }
 
@@ -31,6 +36,8 @@ namespace small::jobsimpl {
         inline size_t   size        () { return m_workers.size(); }
         // empty
         inline bool     empty       () { return size() == 0; }
+        // exceptions thrown from processing
+        inline std::size_t count_exceptions() const { return m_workers.count_exceptions(); }
         // clear
         inline void     clear       () { m_workers.clear(); }
         // clang-format on
@@ -47,23 +54,37 @@ namespace small::jobsimpl {
         //
         inline void start_threads(const int threads_count /* = 1 */)
         {
+            {
+                std::unique_lock l(*this);
+                m_threads_total = threads_count;
+            }
             m_workers.start_threads(threads_count);
         }
 
         //
         // config processing by job group type
         // this should be done in the initial setup phase once
+        // (a group with threads max over its threads count can borrow the idle threads of the pool)
         //
-        inline void config_jobs_group(const JobGroupT& job_group, const int& threads_count)
+        inline void config_jobs_group(const JobGroupT& job_group, const int& threads_count, const std::vector<int>& cpus = {}, const int threads_max = 0)
         {
             m_scheduler[job_group].m_threads_count = threads_count;
+            m_scheduler[job_group].m_threads_max   = std::max<>(threads_max, threads_count);
+            m_scheduler[job_group].m_cpus          = cpus;
+            m_has_borrow                           = m_has_borrow || threads_max > threads_count;
+
+            // sorted like the cpus of a thread, so the same cpus are not set again
+            auto& group_cpus = m_scheduler[job_group].m_cpus;
+            std::sort(group_cpus.begin(), group_cpus.end());
+            group_cpus.erase(std::unique(group_cpus.begin(), group_cpus.end()), group_cpus.end());
         }
 
         //
         // when items are added to be processed in parent class the start scheduler should be called
         // to trigger action (if needed for the new job group)
+        // when many jobs are started at once a runner is started for each of them (no more than the threads of the group)
         //
-        inline void jobs_schedule(const JobGroupT& job_group)
+        inline void jobs_schedule(const JobGroupT& job_group, const std::size_t jobs_count = 1)
         {
             auto it = m_scheduler.find(job_group); // map is not changed, so can be access without locking
             if (it == m_scheduler.end()) {
@@ -73,7 +94,19 @@ namespace small::jobsimpl {
             // even if here it is considered that there are items and something will be scheduled,
             // the actual check if work will still exists will be done in do_action of parent
             auto& stats = it->second;
-            jobs_action_start(job_group, true /*has items*/, std::chrono::milliseconds(0) /*delay*/, stats);
+            std::unique_lock l(*this);
+            if (!can_start(stats)) {
+                // all runners are busy, but one of them may have already found the queue empty
+                // so make sure that the group is scheduled again when a runner ends
+                stats.m_pending = true;
+            }
+            for (std::size_t i = 0; i < jobs_count && can_start(stats); ++i) {
+                jobs_action_start(job_group, true /*has items*/, std::chrono::microseconds(0) /*delay*/, stats);
+            }
+            if (stats.m_running == 0) {
+                // the group has no threads of its own and there are no idle threads to borrow now
+                stats.m_waiting = true;
+            }
         }
 
         // clang-format off
@@ -122,14 +155,27 @@ namespace small::jobsimpl {
     private:
         struct JobGroupStats
         {
-            int m_threads_count{};
-            int m_running{}; // how many requests are currently running
+            int              m_threads_count{}; // how many runners the group can always have
+            int              m_threads_max{};   // how many runners the group can have with the idle threads of the pool
+            int              m_running{};       // how many requests are currently running
+            bool             m_pending{false};  // items were added while all runners were busy
+            bool             m_waiting{false};  // items were added but there was no runner and no idle thread to borrow
+            std::vector<int> m_cpus{};          // where the threads processing this group should run (empty means anywhere)
         };
 
+        //
+        // a runner can be started for the group in its own threads or in the idle threads of the pool (up to its max)
+        // (a borrowed thread is given back when its runner ends, so a group that gets items takes its threads back after one batch)
+        //
+        inline bool can_start(const JobGroupStats& stats) const
+        {
+            return stats.m_running < stats.m_threads_count || (stats.m_running < stats.m_threads_max && m_running_total < m_threads_total);
+        }
+
         //
         // to trigger action (if needed for the new job group)
         //
-        inline void jobs_action_start(const JobGroupT& job_group, const bool has_items, const std::chrono::milliseconds& delay_next_request, JobGroupStats& stats)
+        inline void jobs_action_start(const JobGroupT& job_group, const bool has_items, const std::chrono::microseconds& delay_next_request, JobGroupStats& stats)
         {
             if (!has_items) {
                 return;
@@ -138,9 +184,10 @@ namespace small::jobsimpl {
             std::unique_lock l(*this);
 
             // move from queue to action
-            bool needs_runners = stats.m_running < stats.m_threads_count;
+            bool needs_runners = can_start(stats);
             if (needs_runners) {
                 ++stats.m_running;
+                ++m_running_total;
                 if (delay_next_request.count() > 0) {
                     m_workers.push_back_delay_for(delay_next_request, job_group);
                 } else {
@@ -152,7 +199,7 @@ namespace small::jobsimpl {
         //
         // job action ended
         //
-        inline void jobs_action_end(const JobGroupT& job_group, const bool has_items, const std::chrono::milliseconds& delay_next_request)
+        inline void jobs_action_end(const JobGroupT& job_group, const bool has_items, const std::chrono::microseconds& delay_next_request)
         {
             auto it = m_scheduler.find(job_group); // map is not changed, so can be access without locking
             if (it == m_scheduler.end()) {
@@ -163,8 +210,33 @@ namespace small::jobsimpl {
 
             auto& stats = it->second;
             --stats.m_running;
+            --m_running_total;
+
+            // if items were added meanwhile schedule again (even if this run found no items)
+            const bool pending = std::exchange(stats.m_pending, false);
+
+            jobs_action_start(job_group, has_items || pending, delay_next_request, stats);
+            if (!m_has_borrow) {
+                return;
+            }
+
+            // a borrowed thread that was not started again goes first to the groups that wait for one
+            if ((has_items || pending) && stats.m_running == 0) {
+                stats.m_waiting = true;
+            }
+            for (auto& [waiting_job_group, waiting_stats] : m_scheduler) {
+                if (waiting_stats.m_waiting && can_start(waiting_stats)) {
+                    waiting_stats.m_waiting = false;
+                    jobs_action_start(waiting_job_group, true /*has items*/, std::chrono::microseconds(0) /*delay*/, waiting_stats);
+                }
+            }
 
-            jobs_action_start(job_group, has_items, delay_next_request, stats);
+            // then a group that still has items takes the idle threads (up to its max)
+            if ((has_items || pending) && delay_next_request.count() == 0) {
+                while (stats.m_running < stats.m_threads_max && can_start(stats)) {
+                    jobs_action_start(job_group, true /*has items*/, std::chrono::microseconds(0) /*delay*/, stats);
+                }
+            }
         }
 
         //
@@ -173,8 +245,9 @@ namespace small::jobsimpl {
         inline void thread_function(const std::vector<JobGroupT>& items)
         {
             for (auto job_group : items) {
+                place_thread(job_group);
 
-                std::chrono::milliseconds delay_next_request{};
+                std::chrono::microseconds delay_next_request{}; // (the rate limit of a group needs less than a millisecond)
 
                 auto ret       = m_parent_caller.do_action(job_group, delay_next_request);
                 bool has_items = ret == small::EnumLock::kElement;
@@ -192,6 +265,39 @@ namespace small::jobsimpl {
             }
         }
 
+        //
+        // name the thread at first use and move it to the cpus of the group (only when they are different from the current ones)
+        //
+        inline void place_thread(const JobGroupT& job_group)
+        {
+            // the cpus the thread had at first use (restored for a group without cpus) and the current ones
+            struct ThreadCpus
+            {
+                const jobs_thread_pool* m_pool{};
+                std::vector<int>        m_original{};
+                std::vector<int>        m_current{};
+            };
+            static thread_local ThreadCpus thread_cpus{};
+            if (thread_cpus.m_pool != this) {
+                auto original = small::get_thread_affinity();
+                thread_cpus   = {this, original, original};
+                m_parent_caller.set_thread_name(std::to_string(m_threads_named++));
+            }
+
+            auto it = m_scheduler.find(job_group); // map is not changed, so can be access without locking
+            if (it == m_scheduler.end()) {
+                return;
+            }
+
+            // a thread that was pinned for another group goes back to its original cpus for a group without cpus
+            auto& cpus = it->second.m_cpus.empty() ? thread_cpus.m_original : it->second.m_cpus;
+            if (cpus.empty() || cpus == thread_cpus.m_current) {
+                return;
+            }
+            small::set_thread_affinity(cpus);
+            thread_cpus.m_current = cpus;
+        }
+
     private:
         //
         // members
@@ -209,7 +315,11 @@ namespace small::jobsimpl {
         };
 
         std::unordered_map<JobGroupT, JobGroupStats> m_scheduler;
-        small::worker_thread<JobGroupT>              m_workers{{.threads_count = 0}, JobWorkerThreadFunction(), this};
-        ParentCallerT&                               m_parent_caller; // parent jobs engine
+        int                                          m_threads_total{};  // how many threads (the idle ones can be borrowed)
+        int                                          m_running_total{};  // how many runners of all groups
+        bool                                         m_has_borrow{};     // a group can borrow threads
+        std::atomic<int>                             m_threads_named{0}; // to name the threads
+        small::worker_thread<JobGroupT>              m_workers;          // threads that process the groups
+        ParentCallerT&                               m_parent_caller;    // parent jobs engine
     };
 } // namespace small::jobsimpl
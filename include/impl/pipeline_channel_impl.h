@@ -0,0 +1,159 @@
+#pragma once
+
+#include "impl_common.h"
+
+#include <condition_variable>
+#include <iterator>
+#include <mutex>
+
+#include "../base_lock.h"
+
+namespace small::pipelineimpl {
+
+    //
+    // bounded channel between pipeline stages (multiple producers, multiple consumers)
+    // - push blocks while the channel is full (backpressure)
+    // - items are pushed and popped in batches (one lock for a batch)
+    // - the waiting threads are notified only if there are any
+    //
+    template <typename T>
+    class pipeline_channel
+    {
+    public:
+        //
+        // pipeline_channel
+        //
+        explicit pipeline_channel(const std::size_t capacity)
+            : m_capacity(std::max<>(capacity, std::size_t(1)))
+        {
+        }
+
+        //
+        // size
+        //
+        inline std::size_t size()
+        {
+            std::unique_lock l(m_lock);
+            return m_queue.size();
+        }
+
+        inline bool empty() { return size() == 0; }
+
+        //
+        // push (blocks while the channel is full), returns how many were pushed (less if exit was signaled)
+        //
+        inline std::size_t push_back(T&& elem)
+        {
+            std::unique_lock l(m_lock);
+            if (!wait_not_full(l)) {
+                return 0;
+            }
+            m_queue.push_back(std::forward<T>(elem));
+            notify_pop(1);
+            return 1;
+        }
+
+        inline std::size_t push_back(std::vector<T>&& elems)
+        {
+            std::unique_lock l(m_lock);
+
+            std::size_t count = 0;
+            while (count < elems.size()) {
+                if (!wait_not_full(l)) {
+                    break;
+                }
+                auto n = std::min<>(elems.size() - count, m_capacity - m_queue.size());
+                std::move(elems.begin() + static_cast<std::ptrdiff_t>(count), elems.begin() + static_cast<std::ptrdiff_t>(count + n), std::back_inserter(m_queue));
+                count += n;
+                notify_pop(n);
+            }
+            return count;
+        }
+
+        //
+        // wait for items (at most max_count), returns kExit when the channel is closed and empty
+        //
+        inline EnumLock wait_pop_front(std::vector<T>& vec_elems, const int max_count = 1)
+        {
+            vec_elems.clear();
+
+            std::unique_lock l(m_lock);
+            if (m_queue.empty() && !m_exit_force && !m_exit_when_done) {
+                ++m_waiting_pop;
+                m_condition_pop.wait(l, [this]() { return !m_queue.empty() || m_exit_force || m_exit_when_done; });
+                --m_waiting_pop;
+            }
+
+            if (m_exit_force || m_queue.empty()) {
+                return EnumLock::kExit;
+            }
+
+            auto n = std::min<>(m_queue.size(), static_cast<std::size_t>(std::max<>(max_count, 1)));
+            vec_elems.reserve(n);
+            std::move(m_queue.begin(), m_queue.begin() + static_cast<std::ptrdiff_t>(n), std::back_inserter(vec_elems));
+            m_queue.erase(m_queue.begin(), m_queue.begin() + static_cast<std::ptrdiff_t>(n));
+
+            if (m_waiting_push) {
+                m_condition_push.notify_all();
+            }
+            return EnumLock::kElement;
+        }
+
+        // clang-format off
+        //
+        // exit
+        //
+        inline void signal_exit_force   ()  { std::unique_lock l(m_lock); m_exit_force = true; notify_exit(); }
+        inline bool is_exit_force       ()  { std::unique_lock l(m_lock); return m_exit_force; }
+
+        inline void signal_exit_when_done() { std::unique_lock l(m_lock); m_exit_when_done = true; notify_exit(); }
+        inline bool is_exit_when_done   ()  { std::unique_lock l(m_lock); return m_exit_when_done; }
+        // clang-format on
+
+    private:
+        // returns false if exit was signaled
+        inline bool wait_not_full(std::unique_lock<std::mutex>& l)
+        {
+            if (m_queue.size() >= m_capacity && !m_exit_force && !m_exit_when_done) {
+                ++m_waiting_push;
+                m_condition_push.wait(l, [this]() { return m_queue.size() < m_capacity || m_exit_force || m_exit_when_done; });
+                --m_waiting_push;
+            }
+            return !m_exit_force && !m_exit_when_done;
+        }
+
+        inline void notify_pop(const std::size_t count)
+        {
+            if (m_waiting_pop) {
+                count > 1 ? m_condition_pop.notify_all() : m_condition_pop.notify_one();
+            }
+        }
+
+        inline void notify_exit()
+        {
+            m_condition_pop.notify_all();
+            m_condition_push.notify_all();
+        }
+
+    private:
+        // some prevention
+        pipeline_channel(const pipeline_channel&)            = delete;
+        pipeline_channel(pipeline_channel&&)                 = delete;
+        pipeline_channel& operator=(const pipeline_channel&) = delete;
+        pipeline_channel& operator=(pipeline_channel&& __t)  = delete;
+
+    private:
+        //
+        // members
+        //
+        std::size_t             m_capacity{1};           // max items in channel
+        std::deque<T>           m_queue;                 // items
+        std::mutex              m_lock;                  // lock
+        std::condition_variable m_condition_pop;         // signaled when items are pushed
+        std::condition_variable m_condition_push;        // signaled when items are popped
+        int                     m_waiting_pop{0};        // how many threads wait to pop
+        int                     m_waiting_push{0};       // how many threads wait to push
+        bool                    m_exit_force{false};     // exit now
+        bool                    m_exit_when_done{false}; // exit when empty (no more pushes)
+    };
+} // namespace small::pipelineimpl
@@ -1,9 +1,13 @@
 #pragma once
 
 #include <optional>
+#include <string>
 #include <unordered_map>
+#include <vector>
 
+#include "base_threads.h"
 #include "prio_queue.h"
+#include "util_thread.h"
 
 #include "impl/jobs_item_impl.h"
 
@@ -24,14 +28,31 @@ namespace small {
         {
             int                                 m_threads_count{8}; // how many total threads for processing
             small::config_prio_queue<JobsPrioT> m_config_prio{};
+            std::string                         m_thread_name{};    // name of the threads (name-index, name-delay, name-timeout), for debugging and profiling
+            std::vector<int>                    m_cpus{};           // pin the processing threads to these cpus
+            int                                 m_numa_node{-1};    // if cpus are not set, pin the processing threads to the cpus of this numa node
+            small::config_threads               m_config_threads{}; // stack size and init/exit functions for the processing threads
+        };
+
+        // rate limit with a token bucket
+        struct ConfigRateLimit
+        {
+            double      m_rate{};   // how many jobs per second
+            std::size_t m_burst{1}; // how many jobs can be dispatched at once when the rate was not used for a while
         };
 
         // config for the job group (where job types can be grouped)
         struct ConfigJobsGroup
         {
-            int                                      m_threads_count{1};     // how many threads for processing (out of the global threads)
-            int                                      m_bulk_count{1};        // how many objects are processed at once
-            std::optional<std::chrono::milliseconds> m_delay_next_request{}; // if need to delay the next request processing to have some throtelling
+            int                                                m_threads_count{1};     // how many threads for processing (out of the global threads, the group can always use them)
+            std::optional<int>                                 m_threads_max{};        // if more than the threads count, the idle threads of the engine can be borrowed up to this count
+            int                                                m_bulk_count{1};        // how many objects are processed at once
+            std::optional<std::chrono::microseconds>           m_max_batch_delay{};    // if the bulk is not full wait for more items, but no more than this
+            std::optional<std::chrono::milliseconds>           m_delay_next_request{}; // if need to delay the next request processing to have some throtelling
+            std::optional<small::config_prio_queue<JobsPrioT>> m_config_prio{};        // priorities and scheduling for this group (if not set the engine config is used)
+            std::vector<int>                                   m_cpus{};               // a thread processing this group is moved to these cpus (if not set the engine config is used)
+            std::optional<int>                                 m_numa_node{};          // or to the cpus of this numa node (to keep the group close to its memory)
+            std::optional<ConfigRateLimit>                     m_rate_limit{};         // how many jobs of the group are taken from the queue per second (a thread is not kept waiting for it)
         };
 
         // to be passed to processing function
@@ -47,6 +68,10 @@ namespace small {
 
         using FunctionFinished = std::function<void(const std::vector<std::shared_ptr<JobsItem>>& /*jobs_items*/)>;
 
+        using FunctionDedupKey = std::function<std::size_t(const JobsRequestT& /*jobs_request*/)>;
+
+        using FunctionDedupEqual = std::function<bool(const JobsRequestT& /*jobs_request*/, const JobsRequestT& /*other_jobs_request*/)>;
+
         // config for an individual job type
         struct ConfigJobsType
         {
@@ -58,6 +83,11 @@ namespace small {
             FunctionProcessing                       m_function_processing{};                 // processing Function for jobs items
             FunctionOnChildrenFinished               m_function_children_finished{};          // function called for a parent when a child is finished
             FunctionFinished                         m_function_finished{};                   // function called when jobs items are finished
+            FunctionDedupKey                         m_function_dedup_key{};                  // (optional) key of the request, a job started while a job with the same key is in progress gets its response
+            FunctionDedupEqual                       m_function_dedup_equal{};                // (optional) compares the requests with the same key (otherwise the key must be unique for a request)
+            std::size_t                              m_dedup_cache_capacity{0};               // how many finished responses are kept by key (0 means none, needs the dedup key)
+            std::chrono::milliseconds                m_dedup_cache_ttl{0};                    // how long a finished response is kept (0 means until it is evicted)
+            std::optional<ConfigRateLimit>           m_rate_limit{};                          // how many jobs of the type are started per second (the others wait in the delayed queue for their turn)
         };
 
         ConfigJobsEngine                                m_engine{};                             // config for entire engine (threads, priorities, etc)
@@ -4,8 +4,10 @@
 #include <unordered_map>
 #include <unordered_set>
 
+#include "impl/jobs_dedup_impl.h"
 #include "impl/jobs_item_impl.h"
 #include "impl/jobs_queue_impl.h"
+#include "impl/jobs_rate_impl.h"
 #include "impl/jobs_state_impl.h"
 #include "impl/jobs_thread_pool_impl.h"
 #include "jobs_config.h"
@@ -83,6 +85,11 @@ namespace small {
         using FunctionProcessing         = typename JobsConfig::FunctionProcessing;
         using FunctionOnChildrenFinished = typename JobsConfig::FunctionOnChildrenFinished;
         using FunctionFinished           = typename JobsConfig::FunctionFinished;
+        using ConfigJobsType             = typename JobsConfig::ConfigJobsType;
+        using JobsScratchIDs             = typename small::jobsimpl::jobs_scratch_vector<JobsID>;
+        using JobsScratchItems           = typename small::jobsimpl::jobs_scratch_vector<std::shared_ptr<JobsItem>>;
+        using JobsDedup                  = typename small::jobsimpl::jobs_dedup<JobsID, JobsRequestT, JobsResponseT>;
+        using JobsTokenBucket            = typename small::jobsimpl::jobs_token_bucket;
 
     public:
         //
@@ -124,6 +131,8 @@ namespace small {
         inline bool     empty_processing() { return size_processing() == 0; }
         // clear
         inline void     clear_processing() { m_thread_pool.clear(); }
+        // exceptions thrown from processing functions (the processing thread continues after an exception)
+        inline std::size_t count_exceptions() const { return m_thread_pool.count_exceptions(); }
 
         // size of delayed items
         inline size_t   size_delayed() { return queue().size_delayed();  }
@@ -254,9 +263,61 @@ namespace small {
         inline std::vector<std::shared_ptr<JobsItem>> jobs_get(const std::vector<JobsID>& jobs_ids)     { return queue().jobs_get(jobs_ids); }
 
         inline std::size_t jobs_parent_child(const JobsID& parent_jobs_id, const JobsID& child_jobs_id) { return queue().jobs_parent_child(parent_jobs_id, child_jobs_id); }
-        inline std::size_t jobs_parent_child(std::shared_ptr<JobsItem> parent_jobs_item, std::shared_ptr<JobsItem> child_jobs_item) { return queue().jobs_parent_child(parent_jobs_item, child_jobs_item); }
+        inline std::size_t jobs_parent_child(const std::shared_ptr<JobsItem>& parent_jobs_item, const std::shared_ptr<JobsItem>& child_jobs_item) { return queue().jobs_parent_child(parent_jobs_item, child_jobs_item); }
         // clang-format on
 
+        //
+        // add and start jobs with dependencies (a graph without cycles)
+        // an edge {from, to} (indexes in jobs_items) means that the job 'to' starts after the job 'from' is finished
+        // ('to' becomes the parent of 'from') and a job is started when the count of its finished children reaches the count of its children
+        // (if one of them fails then the job fails too, and the custom children finished functions are not called for these jobs)
+        // all the jobs are added or none (if an edge is not valid or there is a cycle or the priority is not one of the priorities of the group of a job)
+        //
+        inline std::size_t push_back_and_start_graph(const JobsPrioT& priority, const std::vector<std::shared_ptr<JobsItem>>& jobs_items, const std::vector<std::pair<std::size_t, std::size_t>>& edges, std::vector<JobsID>* jobs_ids = nullptr)
+        {
+            if (jobs_ids) {
+                jobs_ids->clear();
+            }
+
+            if (!is_graph(jobs_items, edges)) {
+                return 0;
+            }
+            for (auto& jobs_item : jobs_items) {
+                if (get_priority_index(jobs_item->m_type, priority) < 0) {
+                    return 0;
+                }
+            }
+
+            JobsScratchItems added_jobs_items;
+            if (m_queue.jobs_add(jobs_items, *added_jobs_items, jobs_ids) != jobs_items.size()) {
+                for (auto& jobs_item : *added_jobs_items) {
+                    m_queue.jobs_erase(jobs_item->m_id);
+                }
+                if (jobs_ids) {
+                    jobs_ids->clear();
+                }
+                return 0;
+            }
+
+            // the jobs with dependencies wait for their children and the others are started now
+            for (auto& [from, to] : edges) {
+                jobs_items[to]->set_start_after_children(get_priority_index(jobs_items[to]->m_type, priority));
+            }
+            for (auto& [from, to] : edges) {
+                m_queue.jobs_parent_child(jobs_items[to], jobs_items[from]);
+            }
+
+            JobsScratchItems start_jobs_items;
+            for (auto& jobs_item : jobs_items) {
+                if (!jobs_item->is_start_after_children()) {
+                    start_jobs_items->push_back(jobs_item);
+                }
+            }
+            m_queue.jobs_start(priority, *start_jobs_items);
+
+            return jobs_items.size();
+        }
+
         //
         // set states for jobs items
         //
@@ -344,9 +405,17 @@ namespace small {
         inline void apply_config()
         {
             // setup jobs groups
+            m_groups_rate.clear();
             for (auto& [jobs_group, jobs_group_config] : m_config.m_groups) {
-                m_queue.config_jobs_group(jobs_group, m_config.m_engine.m_config_prio);
-                m_thread_pool.config_jobs_group(jobs_group, jobs_group_config.m_threads_count);
+                m_queue.config_jobs_group(jobs_group, jobs_group_config.m_config_prio.value_or(m_config.m_engine.m_config_prio));
+                auto cpus = small::thread_cpus(jobs_group_config.m_cpus, jobs_group_config.m_numa_node.value_or(-1));
+                if (cpus.empty() && !jobs_group_config.m_numa_node) {
+                    cpus = small::thread_cpus(m_config.m_engine.m_cpus, m_config.m_engine.m_numa_node);
+                }
+                m_thread_pool.config_jobs_group(jobs_group, jobs_group_config.m_threads_count, cpus, jobs_group_config.m_threads_max.value_or(0));
+                if (jobs_group_config.m_rate_limit) {
+                    m_groups_rate.emplace_back(jobs_group, std::make_unique<JobsTokenBucket>(jobs_group_config.m_rate_limit->m_rate, jobs_group_config.m_rate_limit->m_burst));
+                }
             }
 
             // setup jobs types
@@ -361,8 +430,18 @@ namespace small {
             m_config.apply_default_function_children_finished();
             m_config.apply_default_function_finished();
 
+            m_types_table.clear();
+            m_types_dedup.clear();
+            m_types_rate.clear();
             for (auto& [jobs_type, jobs_type_config] : m_config.m_types) {
                 m_queue.config_jobs_type(jobs_type, jobs_type_config.m_group);
+                m_types_table.emplace_back(jobs_type, &jobs_type_config);
+                if (jobs_type_config.m_function_dedup_key) {
+                    m_types_dedup.emplace_back(jobs_type, std::make_unique<JobsDedup>(small::lru_cache_config{.capacity = jobs_type_config.m_dedup_cache_capacity, .ttl = jobs_type_config.m_dedup_cache_ttl}, jobs_type_config.m_function_dedup_equal));
+                }
+                if (jobs_type_config.m_rate_limit) {
+                    m_types_rate.emplace_back(jobs_type, std::make_unique<JobsTokenBucket>(jobs_type_config.m_rate_limit->m_rate, jobs_type_config.m_rate_limit->m_burst));
+                }
             }
 
             // auto start threads if count > 0 otherwise threads should be manually started
@@ -374,7 +453,7 @@ namespace small {
         //
         // get jobs to execute based on the group
         //
-        inline EnumLock get_group_jobs(const JobsGroupT& jobs_group, std::vector<JobsID>& vec_ids, typename JobsConfig::ConfigProcessing& group_config)
+        inline EnumLock get_group_jobs(const JobsGroupT& jobs_group, std::vector<JobsID>& vec_ids, typename JobsConfig::ConfigProcessing& group_config, std::chrono::microseconds& delay_rate_limit)
         {
             // get bulk_count property
             auto it_cfg_grp = m_config.m_groups.find(jobs_group);
@@ -393,7 +472,54 @@ namespace small {
                 return small::EnumLock::kExit;
             }
 
-            auto ret = q->wait_pop_front_for(std::chrono::nanoseconds(0), vec_ids, bulk_count);
+            // with a rate limit take only the jobs that have tokens (if there are none, the group is scheduled again when the next one is available)
+            auto* group_rate = m_groups_rate.empty() ? nullptr : get_group_rate(jobs_group);
+            if (group_rate) {
+                if (q->size_approx() == 0) {
+                    return small::EnumLock::kTimeout;
+                }
+                std::chrono::nanoseconds wait{};
+                auto                     tokens = group_rate->try_take(static_cast<std::size_t>(bulk_count), &wait);
+                if (tokens == 0) {
+                    delay_rate_limit = std::max<>(std::chrono::ceil<std::chrono::microseconds>(wait), std::chrono::microseconds(1));
+                    return small::EnumLock::kElement;
+                }
+                bulk_count = static_cast<int>(tokens);
+            }
+
+            auto ret = pop_group_jobs(*q, vec_ids, bulk_count, it_cfg_grp->second.m_max_batch_delay);
+            if (group_rate) {
+                group_rate->give_back(static_cast<std::size_t>(bulk_count) - vec_ids.size());
+            }
+            return ret;
+        }
+
+        //
+        // take the jobs from the queue of the group
+        //
+        inline EnumLock pop_group_jobs(typename JobsQueue::JobsQueue& q, std::vector<JobsID>& vec_ids, const int bulk_count, const std::optional<std::chrono::microseconds>& max_batch_delay)
+        {
+            // the lock is taken only when there are jobs or on exit (an idle runner does not slow down the producers)
+            if (q.size_approx() == 0 && !q.is_exit()) {
+                return small::EnumLock::kTimeout;
+            }
+
+            auto ret = q.wait_pop_front_for(std::chrono::nanoseconds(0), vec_ids, bulk_count);
+            if (ret != small::EnumLock::kElement || !max_batch_delay) {
+                return ret;
+            }
+
+            // when the bulk is not full wait for more items, but no more than the max batch delay
+            const auto     time_until = std::chrono::system_clock::now() + *max_batch_delay;
+            JobsScratchIDs vec_more;
+            while (static_cast<int>(vec_ids.size()) < bulk_count) {
+                auto ret_more = q.wait_pop_front_until(time_until, *vec_more, bulk_count - static_cast<int>(vec_ids.size()));
+                if (ret_more != small::EnumLock::kElement) {
+                    break;
+                }
+                vec_ids.insert(vec_ids.end(), vec_more->begin(), vec_more->end());
+                vec_more->clear();
+            }
             return ret;
         }
 
@@ -403,57 +529,63 @@ namespace small {
         //
         friend small::jobsimpl::jobs_thread_pool<JobsGroupT, ThisJobsEngine>;
 
-        inline EnumLock do_action(const JobsGroupT& jobs_group, std::chrono::milliseconds& delay_next_request)
+        // name the engine threads (for debugging and profiling)
+        inline void set_thread_name(const std::string& suffix)
         {
-            // get jobs for the group
-            typename JobsConfig::ConfigProcessing group_config{}; // for delay request
-            std::vector<JobsID>                   vec_ids;
+            if (!m_config.m_engine.m_thread_name.empty()) {
+                small::set_thread_name(m_config.m_engine.m_thread_name + "-" + suffix);
+            }
+        }
 
-            auto ret = get_group_jobs(jobs_group, vec_ids, group_config);
-            if (ret != small::EnumLock::kElement) {
+        inline EnumLock do_action(const JobsGroupT& jobs_group, std::chrono::microseconds& delay_next_request)
+        {
+            // get jobs for the group
+            // (the vectors are reused by this thread, so there are no allocations once they are warm)
+            typename JobsConfig::ConfigProcessing group_config{};   // for delay request
+            std::chrono::microseconds             delay_rate_limit{}; // when the rate limit of the group has no tokens
+            JobsScratchIDs                        vec_ids;
+
+            auto ret = get_group_jobs(jobs_group, *vec_ids, group_config, delay_rate_limit);
+            if (ret != small::EnumLock::kElement || delay_rate_limit.count() > 0) {
+                delay_next_request = delay_rate_limit;
                 return ret;
             }
 
-            // split by type
-            std::unordered_map<JobsTypeT, std::vector<std::shared_ptr<JobsItem>>> jobs_in_progress_by_type;
-            {
-                // get jobs
-                std::vector<std::shared_ptr<JobsItem>> jobs_items = jobs_get(vec_ids);
-                for (auto& jobs_item : jobs_items) {
-                    jobs_in_progress_by_type[jobs_item->m_type].reserve(jobs_items.size());
+            // get jobs
+            JobsScratchItems jobs_items;
+            jobs_get_items(*vec_ids, *jobs_items);
 
-                    // mark the item as in progress and execute
-                    // (may be moved to higher states due to external factors like cancel, timeout, finish early due to other job, etc)
-                    if (jobs_item->set_state_inprogress()) {
-                        jobs_in_progress_by_type[jobs_item->m_type].push_back(jobs_item);
-                    }
+            // mark the items as in progress and keep only those
+            // (may be moved to higher states due to external factors like cancel, timeout, finish early due to other job, etc)
+            std::size_t count = 0;
+            for (auto& jobs_item : *jobs_items) {
+                if (jobs_item->set_state_inprogress()) {
+                    std::swap((*jobs_items)[count++], jobs_item);
                 }
             }
-
-            // process specific job by type
-            for (auto& [jobs_type, jobs_items] : jobs_in_progress_by_type) {
-                auto it_cfg_type = m_config.m_types.find(jobs_type);
-                if (it_cfg_type == m_config.m_types.end()) {
-                    continue;
+            jobs_items->resize(count);
+
+            // split by type (in the order of the first job of each type)
+            JobsScratchItems jobs_items_type;
+            while (!jobs_items->empty()) {
+                const auto jobs_type = jobs_items->front()->m_type;
+
+                std::size_t remaining = 0;
+                for (auto& jobs_item : *jobs_items) {
+                    if (jobs_item->m_type == jobs_type) {
+                        jobs_items_type->push_back(std::move(jobs_item));
+                    } else {
+                        std::swap((*jobs_items)[remaining++], jobs_item);
+                    }
                 }
+                jobs_items->resize(remaining);
 
                 // process specific jobs by type
-                typename JobsConfig::ConfigProcessing type_config{};
-                it_cfg_type->second.m_function_processing(jobs_items, type_config);
-
-                // get the max for config
-                if (!group_config.m_delay_next_request) {
-                    group_config.m_delay_next_request = type_config.m_delay_next_request;
-                } else {
-                    if (type_config.m_delay_next_request) {
-                        group_config.m_delay_next_request = std::max<>(group_config.m_delay_next_request, type_config.m_delay_next_request);
-                    }
+                auto* type_config = get_type_config(jobs_type);
+                if (type_config) {
+                    process_jobs_type(*type_config, *jobs_items_type, group_config);
                 }
-
-                // mark the item as in wait for children or finished
-                // if in callback the state is set to failed, cancelled or timeout
-                // setting to finish wont succeed because is less value than those
-                state().jobs_waitforchildren(jobs_items);
+                jobs_items_type->clear();
             }
 
             // delay request
@@ -462,35 +594,256 @@ namespace small {
             return ret;
         }
 
+        //
+        // process jobs of the same type
+        //
+        inline void process_jobs_type(ConfigJobsType& type_config, const std::vector<std::shared_ptr<JobsItem>>& jobs_items, typename JobsConfig::ConfigProcessing& group_config)
+        {
+            typename JobsConfig::ConfigProcessing processing_config{};
+            type_config.m_function_processing(jobs_items, processing_config);
+
+            // get the max for config
+            if (!group_config.m_delay_next_request) {
+                group_config.m_delay_next_request = processing_config.m_delay_next_request;
+            } else {
+                if (processing_config.m_delay_next_request) {
+                    group_config.m_delay_next_request = std::max<>(group_config.m_delay_next_request, processing_config.m_delay_next_request);
+                }
+            }
+
+            // mark the item as in wait for children or finished
+            // if in callback the state is set to failed, cancelled or timeout
+            // setting to finish wont succeed because is less value than those
+            state().jobs_waitforchildren(jobs_items);
+        }
+
+        //
+        // get jobs items into a given vector (to reuse its memory)
+        //
+        template <typename JobsIDsT>
+        inline void jobs_get_items(const JobsIDsT& jobs_ids, std::vector<std::shared_ptr<JobsItem>>& jobs_items)
+        {
+            m_queue.jobs_get_items(jobs_ids, jobs_items);
+        }
+
+        //
+        // config of a jobs type
+        // (there are only a few types, so searching the flat table is faster than hashing)
+        //
+        inline ConfigJobsType* get_type_config(const JobsTypeT& jobs_type)
+        {
+            for (auto& [type, type_config] : m_types_table) {
+                if (type == jobs_type) {
+                    return type_config;
+                }
+            }
+            return nullptr;
+        }
+
+        //
+        // deduplication of a jobs type (nullptr if the type has no dedup key)
+        //
+        inline JobsDedup* get_type_dedup(const JobsTypeT& jobs_type)
+        {
+            for (auto& [type, type_dedup] : m_types_dedup) {
+                if (type == jobs_type) {
+                    return type_dedup.get();
+                }
+            }
+            return nullptr;
+        }
+
+        //
+        // rate limit of a jobs group or type (nullptr if not set)
+        //
+        inline JobsTokenBucket* get_group_rate(const JobsGroupT& jobs_group)
+        {
+            for (auto& [group, group_rate] : m_groups_rate) {
+                if (group == jobs_group) {
+                    return group_rate.get();
+                }
+            }
+            return nullptr;
+        }
+
+        inline JobsTokenBucket* get_type_rate(const JobsTypeT& jobs_type)
+        {
+            for (auto& [type, type_rate] : m_types_rate) {
+                if (type == jobs_type) {
+                    return type_rate.get();
+                }
+            }
+            return nullptr;
+        }
+
+        //
+        // the priorities of the group of the jobs type (like the queue of the group where the jobs are started)
+        //
+        inline const std::vector<std::pair<JobsPrioT, unsigned int>>& get_type_priorities(const JobsTypeT& jobs_type)
+        {
+            auto* type_config = get_type_config(jobs_type);
+            if (type_config) {
+                auto it_cfg_grp = m_config.m_groups.find(type_config->m_group);
+                if (it_cfg_grp != m_config.m_groups.end() && it_cfg_grp->second.m_config_prio) {
+                    return it_cfg_grp->second.m_config_prio->priorities;
+                }
+            }
+            return m_config.m_engine.m_config_prio.priorities;
+        }
+
+        //
+        // index of a priority in the priorities of the group of the jobs type (-1 if not found)
+        //
+        inline int get_priority_index(const JobsTypeT& jobs_type, const JobsPrioT& priority)
+        {
+            const auto& priorities = get_type_priorities(jobs_type);
+            for (std::size_t i = 0; i < priorities.size(); ++i) {
+                if (priorities[i].first == priority) {
+                    return static_cast<int>(i);
+                }
+            }
+            return -1;
+        }
+
+        //
+        // the jobs and the edges are valid and there are no cycles (all the jobs are visited in topological order)
+        //
+        inline bool is_graph(const std::vector<std::shared_ptr<JobsItem>>& jobs_items, const std::vector<std::pair<std::size_t, std::size_t>>& edges)
+        {
+            const auto count = jobs_items.size();
+            for (auto& jobs_item : jobs_items) {
+                if (!jobs_item) {
+                    return false;
+                }
+            }
+
+            // the edges are sorted by their 'from' job (counting sort)
+            small::jobsimpl::jobs_scratch_vector<std::size_t> in_degree;
+            small::jobsimpl::jobs_scratch_vector<std::size_t> offsets;
+            small::jobsimpl::jobs_scratch_vector<std::size_t> targets;
+            small::jobsimpl::jobs_scratch_vector<std::size_t> positions;
+            in_degree->assign(count, 0);
+            offsets->assign(count + 1, 0);
+            for (auto& [from, to] : edges) {
+                if (from >= count || to >= count || from == to) {
+                    return false;
+                }
+                ++(*in_degree)[to];
+                ++(*offsets)[from + 1];
+            }
+            for (std::size_t i = 0; i < count; ++i) {
+                (*offsets)[i + 1] += (*offsets)[i];
+            }
+            positions->assign(offsets->begin(), offsets->end() - 1);
+            targets->resize(edges.size());
+            for (auto& [from, to] : edges) {
+                (*targets)[(*positions)[from]++] = to;
+            }
+
+            // visit the jobs without dependencies and then the ones whose dependencies were visited
+            auto& ready = *positions;
+            ready.clear();
+            for (std::size_t i = 0; i < count; ++i) {
+                if ((*in_degree)[i] == 0) {
+                    ready.push_back(i);
+                }
+            }
+            std::size_t visited = 0;
+            while (!ready.empty()) {
+                const auto from = ready.back();
+                ready.pop_back();
+                ++visited;
+                for (auto e = (*offsets)[from]; e < (*offsets)[from + 1]; ++e) {
+                    const auto to = (*targets)[e];
+                    if (--(*in_degree)[to] == 0) {
+                        ready.push_back(to);
+                    }
+                }
+            }
+            return visited == count;
+        }
+
         //
         // callbacks for jobs_queue
         // inner function for extra processing after addding the jobs into queue (called from queue)
         //
         friend JobsQueue;
 
-        inline void jobs_add(std::shared_ptr<JobsItem> jobs_item)
+        inline void jobs_add(const std::shared_ptr<JobsItem>& jobs_item)
         {
             // called from queue for extra processing when a jobs is added
             // check if needs to be added it to the timeout queue (only if job type has config a timeout)
-            auto timeout = m_config.m_types[jobs_item->m_type].m_timeout;
-            if (timeout) {
-                m_timeout_queue.queue().push_delay_for(*timeout, jobs_item->m_id);
+            auto* type_config = get_type_config(jobs_item->m_type);
+            if (type_config && type_config->m_timeout) {
+                m_timeout_queue.queue().push_delay_for(*type_config->m_timeout, jobs_item->m_id);
+            }
+        }
+
+        inline void jobs_add(const std::vector<std::shared_ptr<JobsItem>>& jobs_items)
+        {
+            // called from queue when many jobs are added, the timeouts are pushed at once for each type
+            JobsScratchIDs jobs_ids;
+            for (auto& [type, type_config] : m_types_table) {
+                if (!type_config->m_timeout) {
+                    continue;
+                }
+                for (auto& jobs_item : jobs_items) {
+                    if (jobs_item->m_type == type) {
+                        jobs_ids->push_back(jobs_item->m_id);
+                    }
+                }
+                if (!jobs_ids->empty()) {
+                    m_timeout_queue.queue().push_delay_for(*type_config->m_timeout, *jobs_ids);
+                    jobs_ids->clear();
+                }
             }
         }
 
-        inline bool jobs_cancelled(std::shared_ptr<JobsItem> jobs_item)
+        inline bool jobs_cancelled(const std::shared_ptr<JobsItem>& jobs_item)
         {
             // called from queue for extra processing when a jobs is cancelled
             return state().jobs_state(jobs_item, small::jobsimpl::EnumJobsState::kCancelled);
         }
 
+        inline void jobs_erased(const std::shared_ptr<JobsItem>& jobs_item)
+        {
+            // called from queue when a job is erased before it was completed (the jobs waiting for it are cancelled)
+            jobs_dedup_completed(jobs_item);
+        }
+
+        //
+        // called from queue when a job is started, returns true if it does not need processing
+        // (a job with the same key is in progress and this one gets its response when it is completed, or the response is cached)
+        //
+        inline bool jobs_deduplicated(const std::shared_ptr<JobsItem>& jobs_item)
+        {
+            auto* type_dedup = m_types_dedup.empty() ? nullptr : get_type_dedup(jobs_item->m_type);
+            if (!type_dedup) {
+                return false;
+            }
+
+            const auto    key = get_type_config(jobs_item->m_type)->m_function_dedup_key(jobs_item->m_request);
+            JobsResponseT response{};
+            switch (type_dedup->add(key, jobs_item->m_id, jobs_item->m_request, response)) {
+            case small::jobsimpl::EnumJobsDedup::kNew:
+                return false;
+            case small::jobsimpl::EnumJobsDedup::kCached:
+                state().jobs_state(jobs_item, small::jobsimpl::EnumJobsState::kFinished, std::move(response));
+                return true;
+            default:
+                return true;
+            }
+        }
+
         //
         // inner function for activate the jobs from queue (called from queue)
         //
-        inline void jobs_schedule(std::shared_ptr<JobsItem> jobs_item)
+        // (jobs_count jobs of the same group were started)
+        inline void jobs_schedule(const std::shared_ptr<JobsItem>& jobs_item, const std::size_t jobs_count = 1)
         {
-            if (jobs_item) {
-                m_thread_pool.jobs_schedule(m_config.m_types[jobs_item->m_type].m_group);
+            auto* type_config = jobs_item ? get_type_config(jobs_item->m_type) : nullptr;
+            if (type_config) {
+                m_thread_pool.jobs_schedule(type_config->m_group, jobs_count);
             }
         }
 
@@ -501,6 +854,11 @@ namespace small {
         using JobsQueueTimeout = small::time_queue_thread<JobsID, ThisJobsEngine>;
         friend JobsQueueTimeout;
 
+        inline void delayed_thread_started()
+        {
+            set_thread_name("timeout");
+        }
+
         inline std::size_t push_back(std::vector<JobsID>&& jobs_ids)
         {
             // this jobs has reached the timeout
@@ -516,14 +874,24 @@ namespace small {
         //
         // when a job is completed (finished/timeout/canceled/failed)
         //
-        inline void jobs_completed(std::shared_ptr<JobsItem> jobs_item)
+        inline void jobs_completed(const std::shared_ptr<JobsItem>& jobs_item)
         {
             if (!jobs_item) {
                 return;
             }
 
             // call the custom function from config (if exists, otherwise the default will be called)
-            m_config.m_types[jobs_item->m_type].m_function_finished({jobs_item});
+            auto* type_config = get_type_config(jobs_item->m_type);
+            if (type_config) {
+                JobsScratchItems jobs_items;
+                jobs_items->push_back(jobs_item);
+                type_config->m_function_finished(*jobs_items);
+            }
+
+            // the jobs with the same key that waited for it are completed with its response
+            if (!m_types_dedup.empty()) {
+                jobs_dedup_completed(jobs_item);
+            }
 
             // if it has parents call jobs_on_child_finished (or custom function) for each parent
             if (jobs_item->has_parents()) {
@@ -532,14 +900,25 @@ namespace small {
                 // the completed callback will not be called again because the state will not change
                 state().jobs_progress(jobs_item, 100, false /*not recursive*/);
 
-                std::vector<std::shared_ptr<JobsItem>> jobs_parents;
-                {
-                    std::unique_lock l(*this);
-                    jobs_parents = jobs_get(jobs_item->m_parentIDs);
-                }
-                for (auto& jobs_parent : jobs_parents) {
-                    m_config.m_types[jobs_parent->m_type].m_function_children_finished(jobs_parent, jobs_item /*child*/);
+                // the child is added to the aggregates of the parents (completed, failed, progress)
+                JobsScratchItems jobs_parents;
+                state().jobs_update_parents(jobs_item, *jobs_parents);
+
+                JobsScratchItems                          jobs_ready;
+                small::jobsimpl::jobs_scratch_vector<int> jobs_ready_priorities;
+                for (auto& jobs_parent : *jobs_parents) {
+                    // the jobs with dependencies are started by the engine
+                    if (jobs_parent->is_start_after_children()) {
+                        jobs_on_dependency_finished(jobs_parent, *jobs_ready, *jobs_ready_priorities);
+                        continue;
+                    }
+
+                    auto* parent_type_config = get_type_config(jobs_parent->m_type);
+                    if (parent_type_config) {
+                        parent_type_config->m_function_children_finished(jobs_parent, jobs_item /*child*/);
+                    }
                 }
+                jobs_start_ready(*jobs_ready, *jobs_ready_priorities);
             } else {
                 // delete only if there are no parents (+delete all children)
                 m_queue.jobs_erase(jobs_item->m_id);
@@ -553,6 +932,74 @@ namespace small {
             }
         }
 
+        //
+        // called from queue when a job is started, returns true if the job is over the rate limit of its type
+        // (the token is reserved and the job is started again when it is its turn, without keeping a thread waiting)
+        // started is 1 if the job waits for its turn, or 0 if it could not wait (on exit) and then it is cancelled
+        //
+        inline bool jobs_rate_limited(const JobsPrioT& priority, const std::shared_ptr<JobsItem>& jobs_item, std::size_t& started)
+        {
+            auto* type_rate = m_types_rate.empty() ? nullptr : get_type_rate(jobs_item->m_type);
+            if (!type_rate || jobs_item->take_rate_admitted()) {
+                return false;
+            }
+
+            const auto wait = type_rate->reserve();
+            if (wait.count() <= 0) {
+                return false;
+            }
+            jobs_item->set_rate_admitted();
+            started = m_queue.jobs_start_delay_for(wait, priority, jobs_item->m_id);
+            if (!started) {
+                // the token is given back for the other jobs
+                jobs_item->take_rate_admitted();
+                type_rate->give_back(1);
+                jobs_cancelled(jobs_item);
+            }
+            return true;
+        }
+
+        //
+        // complete the duplicates of a job with its state and response (and keep the response if it finished)
+        //
+        inline void jobs_dedup_completed(const std::shared_ptr<JobsItem>& jobs_item)
+        {
+            auto* type_dedup = get_type_dedup(jobs_item->m_type);
+            if (!type_dedup) {
+                return;
+            }
+
+            const auto     key = get_type_config(jobs_item->m_type)->m_function_dedup_key(jobs_item->m_request);
+            JobsScratchIDs duplicates_ids;
+            if (!type_dedup->completed(key, jobs_item->m_id, *duplicates_ids)) {
+                return;
+            }
+
+            auto jobs_state = jobs_item->get_state();
+            if (!JobsItem::is_state_complete(jobs_state)) {
+                jobs_state = small::jobsimpl::EnumJobsState::kCancelled;
+            }
+            const bool cache = jobs_state == small::jobsimpl::EnumJobsState::kFinished && type_dedup->has_cache();
+            if (!cache && duplicates_ids->empty()) {
+                return;
+            }
+
+            JobsResponseT response{};
+            {
+                std::unique_lock l(jobs_item->m_lock);
+                response = jobs_item->m_response;
+            }
+            if (cache) {
+                type_dedup->cache(key, jobs_item->m_request, response);
+            }
+
+            JobsScratchItems duplicates;
+            jobs_get_items(*duplicates_ids, *duplicates);
+            for (auto& duplicate : *duplicates) {
+                state().jobs_state(duplicate, jobs_state, response);
+            }
+        }
+
         //
         // when is finished
         //
@@ -582,9 +1029,12 @@ namespace small {
             if (JobsItem::is_state_complete(jobs_state)) {
                 // call the processing function for parent if not already (only if children finished with success)
                 if (jobs_state == small::jobsimpl::EnumJobsState::kFinished) {
-                    if (jobs_parent->set_state_inprogress()) {
-                        typename JobsConfig::ConfigProcessing type_config{};
-                        m_config.m_types[jobs_parent->m_type].m_function_processing({jobs_parent}, type_config);
+                    auto* type_config = get_type_config(jobs_parent->m_type);
+                    if (type_config && jobs_parent->set_state_inprogress()) {
+                        JobsScratchItems jobs_items;
+                        jobs_items->push_back(jobs_parent);
+                        typename JobsConfig::ConfigProcessing processing_config{};
+                        type_config->m_function_processing(*jobs_items, processing_config);
                     }
                 }
                 // then advance to finish
@@ -594,14 +1044,97 @@ namespace small {
             }
         }
 
+        //
+        // after a child of a job with dependencies is finished
+        // the job is ready when all its children are finished (only the last one takes the priority)
+        //
+        inline void jobs_on_dependency_finished(const std::shared_ptr<JobsItem>& jobs_item, std::vector<std::shared_ptr<JobsItem>>& jobs_ready, std::vector<int>& jobs_ready_priorities)
+        {
+            const bool failed = jobs_item->m_children_failed.load() > 0;
+            if (!failed && jobs_item->m_children_completed.load() < jobs_item->m_children_count.load()) {
+                return;
+            }
+
+            const int priority_index = jobs_item->take_start_priority();
+            if (priority_index < 0) {
+                // already started or failed (by another child finished at the same time)
+                return;
+            }
+
+            if (failed) {
+                jobs_dependency_failed(jobs_item);
+                return;
+            }
+
+            jobs_ready.push_back(jobs_item);
+            jobs_ready_priorities.push_back(priority_index);
+        }
+
+        //
+        // start the ready jobs (at once for each priority)
+        // (the index of the priority of each job is in the priorities of its group)
+        //
+        inline void jobs_start_ready(std::vector<std::shared_ptr<JobsItem>>& jobs_ready, std::vector<int>& jobs_ready_priorities)
+        {
+            small::jobsimpl::jobs_scratch_vector<JobsPrioT> priorities;
+            for (std::size_t i = 0; i < jobs_ready.size(); ++i) {
+                priorities->push_back(get_type_priorities(jobs_ready[i]->m_type)[static_cast<std::size_t>(jobs_ready_priorities[i])].first);
+            }
+
+            JobsScratchItems jobs_items;
+            for (std::size_t i = 0; i < jobs_ready.size(); ++i) {
+                if (jobs_ready_priorities[i] < 0) {
+                    continue;
+                }
+
+                const auto priority = (*priorities)[i];
+                for (std::size_t j = i; j < jobs_ready.size(); ++j) {
+                    if (jobs_ready_priorities[j] >= 0 && (*priorities)[j] == priority) {
+                        jobs_items->push_back(std::move(jobs_ready[j]));
+                        jobs_ready_priorities[j] = -1;
+                    }
+                }
+                m_queue.jobs_start(priority, *jobs_items);
+                jobs_items->clear();
+            }
+        }
+
+        //
+        // a job with dependencies fails when one of them failed
+        // (the jobs that fail because of it are completed in a loop on this thread and not recursively, the graph can be very deep)
+        //
+        inline void jobs_dependency_failed(const std::shared_ptr<JobsItem>& jobs_item)
+        {
+            static thread_local std::pair<ThisJobsEngine*, std::vector<std::shared_ptr<JobsItem>>*> failing{};
+            if (failing.first == this) {
+                failing.second->push_back(jobs_item);
+                return;
+            }
+
+            JobsScratchItems jobs_items;
+            jobs_items->push_back(jobs_item);
+
+            auto previous = std::exchange(failing, {this, &*jobs_items});
+            while (!jobs_items->empty()) {
+                auto failed_jobs_item = std::move(jobs_items->back());
+                jobs_items->pop_back();
+                state().jobs_state(failed_jobs_item, small::jobsimpl::EnumJobsState::kFailed);
+            }
+            failing = previous;
+        }
+
     private:
         //
         // members
         //
-        JobsConfig                                                    m_config;
-        JobsQueue                                                     m_queue{*this};
-        JobsState                                                     m_state{*this};
-        JobsQueueTimeout                                              m_timeout_queue{*this}; // for timeout elements
-        small::jobsimpl::jobs_thread_pool<JobsGroupT, ThisJobsEngine> m_thread_pool{*this};   // for processing items (by group) using a pool of threads
+        JobsConfig                                                           m_config;
+        std::vector<std::pair<JobsTypeT, ConfigJobsType*>>                   m_types_table;                                            // flat table of the config by type (points in m_config)
+        std::vector<std::pair<JobsTypeT, std::unique_ptr<JobsDedup>>>        m_types_dedup;                                            // deduplication for the types with a dedup key
+        std::vector<std::pair<JobsTypeT, std::unique_ptr<JobsTokenBucket>>>  m_types_rate;                                             // rate limits of the types
+        std::vector<std::pair<JobsGroupT, std::unique_ptr<JobsTokenBucket>>> m_groups_rate;                                            // rate limits of the groups
+        JobsQueue                                                            m_queue{*this};
+        JobsState                                                            m_state{*this};
+        JobsQueueTimeout                                                     m_timeout_queue{*this};                                   // for timeout elements
+        small::jobsimpl::jobs_thread_pool<JobsGroupT, ThisJobsEngine>        m_thread_pool{*this, m_config.m_engine.m_config_threads}; // for processing items (by group) using a pool of threads
     };
 } // namespace small
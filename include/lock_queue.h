@@ -57,6 +57,7 @@ namespace small {
             std::scoped_lock l(m_wait, o.m_wait);
             m_config = o.m_config;
             m_queue  = o.m_queue;
+            update_size_approx();
             return *this;
         }
         inline lock_queue& operator=(lock_queue&& o) noexcept
@@ -64,6 +65,8 @@ namespace small {
             std::scoped_lock l(m_wait, o.m_wait);
             m_config = o.m_config;
             m_queue  = std::move(o.m_queue);
+            update_size_approx();
+            o.update_size_approx();
             return *this;
         }
 
@@ -78,6 +81,9 @@ namespace small {
 
         inline bool empty() { return size() == 0; }
 
+        // size without the lock (approximate when used from other threads, to check for items before taking the lock)
+        inline std::size_t size_approx() const { return m_size_approx.load(std::memory_order_relaxed); }
+
         //
         // clear only removes elements from queue but does not reset the event
         //
@@ -85,6 +91,7 @@ namespace small {
         {
             std::unique_lock l(m_wait);
             m_queue.clear();
+            update_size_approx();
         }
 
         // clang-format off
@@ -108,6 +115,7 @@ namespace small {
                 return 0; // queue at max capacity
             }
             m_queue.push_back(elem);
+            update_size_approx();
             m_wait.notify_one();
             return 1;
         }
@@ -129,6 +137,7 @@ namespace small {
                 ++count;
             }
             if (count > 0) {
+                update_size_approx();
                 m_wait.notify_all();
             }
             return count;
@@ -146,6 +155,7 @@ namespace small {
                 return 0; // queue at max capacity
             }
             m_queue.push_back(std::forward<T>(elem));
+            update_size_approx();
             m_wait.notify_one();
             return 1;
         }
@@ -167,6 +177,7 @@ namespace small {
                 ++count;
             }
             if (count > 0) {
+                update_size_approx();
                 m_wait.notify_all();
             }
             return count;
@@ -185,6 +196,7 @@ namespace small {
                 return 0; // queue at max capacity
             }
             m_queue.emplace_back(std::forward<_Args>(__args)...);
+            update_size_approx();
             m_wait.notify_one();
             return 1;
         }
@@ -289,18 +301,23 @@ namespace small {
                 *elem = std::move(m_queue.front());
             }
             m_queue.pop_front();
+            update_size_approx();
 
             *is_empty_after_get = m_queue.empty();
 
             return small::WaitFlags::kElement;
         }
 
+        // called with the lock held after the queue is changed
+        inline void update_size_approx() { m_size_approx.store(m_queue.size(), std::memory_order_relaxed); }
+
     private:
         //
         // members
         //
-        lock_queue_config     m_config{};    // queue configuration (limits, etc)
-        mutable BaseQueueWait m_wait{*this}; // implements locks & wait
-        std::deque<T>         m_queue;       // queue
+        lock_queue_config        m_config{};      // queue configuration (limits, etc)
+        mutable BaseQueueWait    m_wait{*this};   // implements locks & wait
+        std::deque<T>            m_queue;         // queue
+        std::atomic<std::size_t> m_size_approx{}; // size of the queue that can be read without the lock
     };
 } // namespace small
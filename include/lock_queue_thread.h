@@ -1,16 +1,25 @@
 #pragma once
 
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <deque>
-#include <future>
+#include <iterator>
+#include <mutex>
 #include <queue>
+#include <thread>
 
+#include "base_threads.h"
 #include "lock_queue.h"
+#include "util_time.h"
 
 namespace small {
 
     //
-    // add threads to process items from queue (parent caller must implement 'config' and 'process_items')
+    // add threads to process items from queue (parent caller must implement 'config', 'thread_started' and 'process_items')
+    // - if config threads_max is more than the started threads, threads are activated when the items accumulate
+    //   and parked again when they are idle (the parked threads are not stopped)
+    // - if config bulk_count_max is more than bulk_count, the bulk is adjusted to keep the processing time of a batch under target_batch_time
     //
     template <typename T, typename ParentCallerT>
     class lock_queue_thread
@@ -35,29 +44,49 @@ namespace small {
         }
 
         //
-        // start threads
+        // current settings (they can change when adaptive)
+        //
+        inline int threads_active() const { return m_threads_active.load(); }
+        inline int bulk_count() const { return m_bulk_count.load(); }
+
+        //
+        // start threads (when adaptive up to threads_max are started and the ones over threads_count are parked)
         //
         inline void start_threads(const int threads_count /* = 1 */)
         {
             std::unique_lock l(m_lock_queue);
 
-            m_threads_futures.resize(static_cast<std::size_t>(threads_count));
-            for (auto& tf : m_threads_futures) {
-                if (!tf.valid()) {
-                    tf = std::async(std::launch::async, &lock_queue_thread::thread_function, this);
-                }
+            const auto& config = m_parent_caller.config();
+            m_threads_min      = threads_count;
+            m_threads_max      = std::max<>(config.threads_max, threads_count);
+            m_bulk_min         = std::max<>(config.bulk_count, 1);
+            m_bulk_max         = std::max<>(config.bulk_count_max, m_bulk_min);
+            m_bulk_count       = m_bulk_min;
+            set_threads_active(threads_count);
+
+            const small::config_threads config_threads{
+                .stack_size           = config.stack_size,
+                .function_thread_init = config.function_thread_init,
+                .function_thread_exit = config.function_thread_exit,
+            };
+            while (m_threads.size() < static_cast<std::size_t>(m_threads_max)) {
+                m_threads.start(config_threads, [this](std::stop_token stop_token, const int index) { thread_function(stop_token, index); });
             }
         }
 
+        //
+        // how many exceptions were thrown from processing (the thread continues processing after an exception)
+        //
+        inline std::size_t count_exceptions() const { return m_threads.count_exceptions(); }
+
         //
         // wait
         //
         inline EnumLock wait()
         {
             m_lock_queue.signal_exit_when_done();
-            for (const auto& th : m_threads_futures) {
-                th.wait();
-            }
+            wake_parked_threads();
+            m_threads.wait();
             return small::EnumLock::kExit;
         }
 
@@ -76,38 +105,163 @@ namespace small {
         inline EnumLock wait_until(const std::chrono::time_point<_Clock, _Duration>& __atime)
         {
             m_lock_queue.signal_exit_when_done();
+            wake_parked_threads();
 
-            for (auto& th : m_threads_futures) {
-                auto ret = th.wait_until(__atime);
-                if (ret == std::future_status::timeout) {
-                    return small::EnumLock::kTimeout;
-                }
-            }
-
-            return small::EnumLock::kExit;
+            return m_threads.wait_until(__atime) ? small::EnumLock::kExit : small::EnumLock::kTimeout;
         }
 
     private:
         //
         // inner thread function
         //
-        inline void thread_function()
+        inline void thread_function(std::stop_token stop_token, const int index)
         {
+            // when the threads are destroyed without waiting
+            std::stop_callback on_stop(stop_token, [this]() {
+                m_lock_queue.signal_exit_when_done();
+                wake_parked_threads();
+            });
+
+            m_parent_caller.thread_started(index);
+
             std::vector<T> vec_elems;
-            const int      bulk_count = std::max<>(m_parent_caller.config().bulk_count, 1);
-            for (; true; small::sleep_micro(1)) {
+            const int      spin_count  = std::max<>(m_parent_caller.config().idle_spin_count, 0);
+            const int      yield_count = std::max<>(m_parent_caller.config().idle_yield_count, 0);
+            const auto     linger_time = m_parent_caller.config().max_batch_delay;
+            for (; true;) {
+                // threads over the active count are parked until they are needed
+                if (index >= m_threads_active.load() && !park(index)) {
+                    break;
+                }
+
                 // wait
-                small::EnumLock ret = m_lock_queue.wait_pop_front(vec_elems, bulk_count);
+                const int       bulk_count = m_bulk_count.load();
+                small::EnumLock ret        = wait_pop_front_idle(vec_elems, bulk_count, spin_count, yield_count);
 
                 if (ret == small::EnumLock::kExit) {
                     // force stop
                     break;
                 } else if (ret == small::EnumLock::kTimeout) {
-                    // nothing to do
+                    // idle for too long, one less thread is needed
+                    shrink_threads();
                 } else if (ret == small::EnumLock::kElement) {
+                    wait_pop_front_linger(vec_elems, bulk_count, linger_time);
+                    grow_threads(bulk_count);
+
+                    auto       time_start = small::high_time_now();
+                    const auto count      = vec_elems.size();
                     m_parent_caller.process_items(std::move(vec_elems));
+                    adapt_bulk_count(bulk_count, count, small::high_time_diff_micro(time_start));
+                }
+            }
+        }
+
+        //
+        // when the bulk is not full wait for more items, but no more than the max batch delay (from the first item)
+        //
+        inline void wait_pop_front_linger(std::vector<T>& vec_elems, const int bulk_count, const std::chrono::microseconds linger_time)
+        {
+            if (linger_time.count() <= 0) {
+                return;
+            }
+
+            const auto     time_until = std::chrono::system_clock::now() + linger_time;
+            std::vector<T> vec_more;
+            while (static_cast<int>(vec_elems.size()) < bulk_count) {
+                auto ret = m_lock_queue.wait_pop_front_until(time_until, vec_more, bulk_count - static_cast<int>(vec_elems.size()));
+                if (ret != small::EnumLock::kElement) {
+                    break;
+                }
+                std::move(vec_more.begin(), vec_more.end(), std::back_inserter(vec_elems));
+            }
+        }
+
+        //
+        // when the queue is empty try again without waiting (first spin, then yield) and only after that block on the queue
+        // (while spinning only the size is checked, the lock is taken when there are items or on exit, so the producers are not slowed down)
+        //
+        inline small::EnumLock wait_pop_front_idle(std::vector<T>& vec_elems, const int bulk_count, const int spin_count, const int yield_count)
+        {
+            for (int i = 0; i < spin_count + yield_count; ++i) {
+                if (m_lock_queue.size_approx() > 0 || m_lock_queue.is_exit()) {
+                    auto ret = m_lock_queue.wait_pop_front_for(std::chrono::nanoseconds(0), vec_elems, bulk_count);
+                    if (ret != small::EnumLock::kTimeout) {
+                        return ret;
+                    }
+                }
+                if (i >= spin_count) {
+                    std::this_thread::yield();
                 }
             }
+            if (m_threads_max > m_threads_min) {
+                // wake up from time to time to see if the thread is still needed
+                return m_lock_queue.wait_pop_front_for(m_parent_caller.config().park_idle_time, vec_elems, bulk_count);
+            }
+            return m_lock_queue.wait_pop_front(vec_elems, bulk_count);
+        }
+
+        //
+        // more threads are needed when the items accumulate in queue
+        //
+        inline void grow_threads(const int bulk_count)
+        {
+            auto active = m_threads_active.load();
+            if (active >= m_threads_max || m_lock_queue.size() <= static_cast<std::size_t>(active * bulk_count)) {
+                return;
+            }
+            if (m_threads_active.compare_exchange_strong(active, active + 1)) {
+                wake_parked_threads();
+            }
+        }
+
+        //
+        // one less thread is needed (the thread with the highest index will be parked)
+        //
+        inline void shrink_threads()
+        {
+            auto active = m_threads_active.load();
+            if (active > m_threads_min) {
+                m_threads_active.compare_exchange_strong(active, active - 1);
+            }
+        }
+
+        inline void set_threads_active(const int threads_active)
+        {
+            m_threads_active = threads_active;
+            wake_parked_threads();
+        }
+
+        //
+        // park the thread until it is needed again (returns false if it must exit)
+        //
+        inline bool park(const int index)
+        {
+            std::unique_lock l(m_park_lock);
+            m_park_condition.wait(l, [&]() { return index < m_threads_active.load() || m_lock_queue.is_exit_force() || m_lock_queue.is_exit_when_done(); });
+            return index < m_threads_active.load() && !m_lock_queue.is_exit_force();
+        }
+
+        inline void wake_parked_threads()
+        {
+            std::unique_lock l(m_park_lock);
+            m_park_condition.notify_all();
+        }
+
+        //
+        // halve the bulk when the batch took longer than the target time and double it when it was full and took less than half
+        //
+        inline void adapt_bulk_count(int bulk_count, const std::size_t count, const long long time_micro)
+        {
+            if (m_bulk_max <= m_bulk_min) {
+                return;
+            }
+
+            const auto target = m_parent_caller.config().target_batch_time.count();
+            if (time_micro > target && bulk_count > m_bulk_min) {
+                m_bulk_count.compare_exchange_strong(bulk_count, std::max<>(bulk_count / 2, m_bulk_min));
+            } else if (time_micro * 2 < target && count >= static_cast<std::size_t>(bulk_count) && bulk_count < m_bulk_max) {
+                m_bulk_count.compare_exchange_strong(bulk_count, std::min<>(bulk_count * 2, m_bulk_max));
+            }
         }
 
     private:
@@ -121,8 +275,16 @@ namespace small {
         //
         // members
         //
-        small::lock_queue<T>           m_lock_queue;      // a time priority queue for delayed items
-        std::vector<std::future<void>> m_threads_futures; // threads futures (needed to wait for)
-        ParentCallerT&                 m_parent_caller;   // active queue where to push
+        small::lock_queue<T>           m_lock_queue;        // a time priority queue for delayed items
+        std::atomic<int>               m_threads_active{0}; // how many threads are processing (the others are parked)
+        int                            m_threads_min{0};    // min active threads
+        int                            m_threads_max{0};    // max active threads (all are started)
+        std::atomic<int>               m_bulk_count{1};     // current bulk count
+        int                            m_bulk_min{1};       // min bulk count
+        int                            m_bulk_max{1};       // max bulk count
+        std::mutex                     m_park_lock;         // for parked threads
+        std::condition_variable        m_park_condition;    // to wake up parked threads
+        small::base_threads            m_threads;           // threads (they are destroyed first)
+        ParentCallerT&                 m_parent_caller;     // active queue where to push
     };
 } // namespace small
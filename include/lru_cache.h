@@ -1,7 +1,9 @@
 #pragma once
 
+#include <chrono>
 #include <list>
 #include <mutex>
+#include <optional>
 #include <unordered_map>
 
 namespace small {
@@ -11,7 +13,8 @@ namespace small {
     //
     struct lru_cache_config
     {
-        std::size_t capacity{static_cast<std::size_t>(-1)};
+        std::size_t               capacity{static_cast<std::size_t>(-1)};
+        std::chrono::milliseconds ttl{0}; // how long an element is valid after it was set (0 means forever)
     };
 
     //
@@ -34,7 +37,7 @@ namespace small {
             m_list   = o.m_list;
             m_cache.clear();
             for (auto it = m_list.begin(); it != m_list.end(); ++it) {
-                m_cache[it->first] = it;
+                m_cache[it->m_key] = it;
             }
             return *this;
         }
@@ -68,20 +71,23 @@ namespace small {
                 return;
             }
 
+            const auto expire = expire_time();
+
             auto it = m_cache.find(key);
             if (it == m_cache.end()) {
                 // add the key to the front of the list
-                m_list.push_front({key, value});
+                m_list.push_front({key, value, expire});
                 m_cache[key] = m_list.begin();
             } else {
                 // overwrite the value and move it to the front of the list
-                it->second->second = value;
+                it->second->m_value  = value;
+                it->second->m_expire = expire;
                 m_list.splice(m_list.begin(), m_list, it->second);
             }
 
             // remove last element
             if (m_cache.size() > m_config.capacity) {
-                m_cache.erase(m_list.back().first); // erase the key
+                m_cache.erase(m_list.back().m_key); // erase the key
                 m_list.pop_back();
             }
         }
@@ -93,9 +99,16 @@ namespace small {
                 return nullptr;
             }
 
+            // expired elements are removed when they are accessed
+            if (m_config.ttl.count() > 0 && it->second->m_expire <= std::chrono::steady_clock::now()) {
+                m_list.erase(it->second);
+                m_cache.erase(it);
+                return nullptr;
+            }
+
             // due to access, move it to the front of the list
             m_list.splice(m_list.begin(), m_list, it->second);
-            return &(it->second->second);
+            return &(it->second->m_value);
         }
 
         inline void erase(const Key& key)
@@ -120,6 +133,12 @@ namespace small {
             return get(std::move(key));
         }
 
+    private:
+        inline std::chrono::steady_clock::time_point expire_time() const
+        {
+            return m_config.ttl.count() > 0 ? std::chrono::steady_clock::now() + m_config.ttl : std::chrono::steady_clock::time_point{};
+        }
+
     private:
         //
         // members
@@ -127,7 +146,12 @@ namespace small {
         lru_cache_config m_config{};
 
         // simulate an ordered map
-        using Node = std::pair<Key, Value>;
+        struct Node
+        {
+            Key                                   m_key;      // key
+            Value                                 m_value;    // value
+            std::chrono::steady_clock::time_point m_expire{}; // when it is no longer valid (if there is a ttl)
+        };
         std::list<Node>                                             m_list;
         std::unordered_map<Key, typename std::list<Node>::iterator> m_cache;
     };
@@ -204,6 +228,14 @@ namespace small {
             return m_impl.get(key);
         }
 
+        // get a copy of the value (the pointer from get can be changed by other threads after the lock is released)
+        inline std::optional<Value> get_copy(const Key& key)
+        {
+            std::unique_lock lock(m_mutex);
+            auto*            value = m_impl.get(key);
+            return value ? std::optional<Value>(*value) : std::nullopt;
+        }
+
         inline void erase(const Key& key)
         {
             std::unique_lock lock(m_mutex);
@@ -0,0 +1,218 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "base_threads.h"
+
+#include "impl/pipeline_channel_impl.h"
+
+// a pipeline of stages where each stage has its own threads and the items are handed
+// to the next stage in batches through bounded channels (when a stage is slow the previous ones wait, backpressure)
+//
+// small::pipeline<int> p;
+// p.add_stage({.threads_count = 2, .bulk_count = 16}, [](std::vector<int>& items) { ... /*items can be changed, removed or added*/ })
+//  .add_stage({.threads_count = 1, .bulk_count = 16}, [](std::vector<int>& items) { ... })
+//  .add_stage({.fuse_with_previous = true}, [](std::vector<int>& items) { ... /*runs on the threads of previous stage*/ });
+// p.start_threads();
+// ...
+// p.push_back(1); // blocks while the first stage is full
+// ...
+// p.wait(); // signal exit when done (it is propagated from stage to stage) and wait for all stages to finish
+//
+
+namespace small {
+
+    //
+    // config for a pipeline stage
+    //
+    struct config_pipeline_stage
+    {
+        int         threads_count{1};          // how many threads for processing
+        int         bulk_count{1};             // how many items are processed at once (and handed to the next stage as a batch)
+        std::size_t channel_size{1024};        // max items waiting for this stage (push blocks when full)
+        bool        fuse_with_previous{false}; // run on the threads of the previous stage (the threads_count, bulk_count, channel_size are ignored)
+    };
+
+    //
+    // pipeline of stages
+    //
+    template <typename T>
+    class pipeline
+    {
+    public:
+        using FunctionStage = std::function<void(std::vector<T>& /*items*/)>;
+
+        //
+        // pipeline
+        //
+        pipeline() = default;
+
+        ~pipeline()
+        {
+            wait();
+        }
+
+        //
+        // add a stage (before start_threads)
+        //
+        inline pipeline& add_stage(const config_pipeline_stage& config, FunctionStage function)
+        {
+            if (m_segments.empty() || !config.fuse_with_previous) {
+                m_segments.push_back(std::make_unique<Segment>(config));
+            }
+            m_segments.back()->m_functions.push_back(std::move(function));
+            ++m_stages_count;
+            return *this;
+        }
+
+        // clang-format off
+        // how many stages
+        inline std::size_t  stages_count    () const { return m_stages_count; }
+        // how many stages have their own threads (the fused stages run on the threads of the previous stage)
+        inline std::size_t  segments_count  () const { return m_segments.size(); }
+        // items waiting in all stages
+        inline std::size_t  size            () { std::size_t size = 0; for (auto& segment : m_segments) { size += segment->m_channel.size(); } return size; }
+        // empty
+        inline bool         empty           () { return size() == 0; }
+        // clang-format on
+
+        //
+        // start threads for all stages
+        //
+        inline void start_threads()
+        {
+            for (std::size_t index = 0; index < m_segments.size(); ++index) {
+                auto&      segment       = *m_segments[index];
+                const auto threads_count = static_cast<std::size_t>(std::max<>(segment.m_config.threads_count, 1));
+                while (segment.m_threads.size() < threads_count) {
+                    ++segment.m_running;
+                    segment.m_threads.start({}, [this, index](std::stop_token stop_token, const int /* thread index */) { thread_function(stop_token, index); });
+                }
+            }
+        }
+
+        //
+        // push to the first stage (blocks while it is full), returns 0 after exit was signaled
+        //
+        inline std::size_t push_back(const T& elem)
+        {
+            return push_back(T(elem));
+        }
+
+        inline std::size_t push_back(T&& elem)
+        {
+            return m_segments.empty() ? 0 : m_segments.front()->m_channel.push_back(std::forward<T>(elem));
+        }
+
+        inline std::size_t push_back(std::vector<T>&& elems)
+        {
+            return m_segments.empty() ? 0 : m_segments.front()->m_channel.push_back(std::forward<std::vector<T>>(elems));
+        }
+
+        // clang-format off
+        //
+        // signal exit
+        //
+        inline void signal_exit_force       ()  { for (auto& segment : m_segments) { segment->m_channel.signal_exit_force(); } }
+        // the next stages are signaled when the previous stage has finished
+        inline void signal_exit_when_done   ()  { if (!m_segments.empty()) { m_segments.front()->m_channel.signal_exit_when_done(); } }
+        // clang-format on
+
+        //
+        // wait for all stages to finish processing
+        //
+        inline EnumLock wait()
+        {
+            signal_exit_when_done();
+            for (auto& segment : m_segments) {
+                segment->m_threads.wait();
+            }
+            return EnumLock::kExit;
+        }
+
+        template <typename _Rep, typename _Period>
+        inline EnumLock wait_for(const std::chrono::duration<_Rep, _Period>& __rtime)
+        {
+            using __dur    = typename std::chrono::system_clock::duration;
+            auto __reltime = std::chrono::duration_cast<__dur>(__rtime);
+            if (__reltime < __rtime) {
+                ++__reltime;
+            }
+            return wait_until(std::chrono::system_clock::now() + __reltime);
+        }
+
+        template <typename _Clock, typename _Duration>
+        inline EnumLock wait_until(const std::chrono::time_point<_Clock, _Duration>& __atime)
+        {
+            signal_exit_when_done();
+            for (auto& segment : m_segments) {
+                if (!segment->m_threads.wait_until(__atime)) {
+                    return EnumLock::kTimeout;
+                }
+            }
+            return EnumLock::kExit;
+        }
+
+    private:
+        //
+        // inner thread function, process the items with all the fused stages and hand them to the next stage as a batch
+        //
+        inline void thread_function(std::stop_token stop_token, const std::size_t index)
+        {
+            auto& segment = *m_segments[index];
+            auto* next    = index + 1 < m_segments.size() ? m_segments[index + 1].get() : nullptr;
+
+            // when the threads are destroyed without waiting
+            std::stop_callback on_stop(stop_token, [&segment]() { segment.m_channel.signal_exit_when_done(); });
+
+            const int      bulk_count = std::max<>(segment.m_config.bulk_count, 1);
+            std::vector<T> items;
+            while (segment.m_channel.wait_pop_front(items, bulk_count) == EnumLock::kElement) {
+                for (auto& function : segment.m_functions) {
+                    function(items);
+                }
+                if (next && !items.empty()) {
+                    next->m_channel.push_back(std::move(items));
+                }
+            }
+
+            // the last thread of this stage signals the next stage
+            if (--segment.m_running == 0 && next) {
+                next->m_channel.signal_exit_when_done();
+            }
+        }
+
+    private:
+        // some prevention
+        pipeline(const pipeline&)            = delete;
+        pipeline(pipeline&&)                 = delete;
+        pipeline& operator=(const pipeline&) = delete;
+        pipeline& operator=(pipeline&& __t)  = delete;
+
+    private:
+        // stages that run on the same threads
+        struct Segment
+        {
+            explicit Segment(const config_pipeline_stage& config)
+                : m_config(config),
+                  m_channel(config.channel_size)
+            {
+            }
+
+            config_pipeline_stage                    m_config;     // config of the first stage
+            std::vector<FunctionStage>               m_functions;  // the fused stages
+            small::pipelineimpl::pipeline_channel<T> m_channel;    // input channel
+            std::atomic<int>                         m_running{0}; // how many threads are still running
+            small::base_threads                      m_threads;    // threads (they are destroyed first)
+        };
+
+        //
+        // members
+        //
+        std::vector<std::unique_ptr<Segment>> m_segments;        // stages grouped by threads
+        std::size_t                           m_stages_count{0}; // how many stages
+    };
+} // namespace small
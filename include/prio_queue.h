@@ -1,10 +1,17 @@
 #pragma once
 
+#include <algorithm>
 #include <atomic>
+#include <bit>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
 #include <deque>
-#include <optional>
+#include <stdexcept>
+#include <type_traits>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include "base_queue_wait.h"
 
@@ -50,12 +57,41 @@ namespace small {
         kNoPriority = 0,
     };
 
+    //
+    // how the next element is chosen between priorities
+    //
+    enum class EnumPrioScheduling : unsigned int
+    {
+        kRatio = 0, // use the ratio between priorities (ex: 3:1)
+        kAging,     // use the ratio, but elements waiting longer than aging_time are promoted and served first (oldest first, from any flow)
+        kDeadline,  // earliest deadline first, from any flow (deadline is set at push, or by default now + deadline_time * (priority rank + 1))
+    };
+
+    //
+    // what to do when a limit (total or per priority) is reached
+    //
+    enum class EnumPrioOverflow : unsigned int
+    {
+        kReject = 0,       // the new element is not added (push returns 0)
+        kDropOldestLowest, // the oldest element (first pushed, in any flow) of the lowest non empty priority (not higher than the new one) is dropped
+                           // (for kDeadline the element with the latest deadline of that priority is dropped, the least urgent one)
+        kBlock,            // the producer waits until there is room (or exit is signaled)
+                           // (a producer that holds the queue lock can not wait, the lock is not released, so the new element is rejected)
+    };
+
     template <typename PrioT = EnumPriorities>
     struct config_prio_queue
     {
-        std::vector<std::pair<PrioT, unsigned int /*ratio*/>> priorities; // list of used priorities ordered from high to low
-                                                                          // ex: { { kHigh, 3 }, { kNormal, 3 }, { kLow, 0 } }
-                                                                          // ratio 3:1, means after 3 High priorities execute 1 Normal, after 3 Normal execute 1 Low, etc
+        std::vector<std::pair<PrioT, unsigned int /*ratio*/>>                 priorities;                                    // list of used priorities ordered from high to low
+                                                                                                                             // ex: { { kHigh, 3 }, { kNormal, 3 }, { kLow, 0 } }
+                                                                                                                             // ratio 3:1, means after 3 High priorities execute 1 Normal, after 3 Normal execute 1 Low, etc
+        EnumPrioScheduling                                                    scheduling{EnumPrioScheduling::kRatio};        // how the next element is chosen
+        std::chrono::milliseconds                                             aging_time{std::chrono::milliseconds(1000)};   // for kAging, elements waiting longer are promoted
+        std::chrono::milliseconds                                             deadline_time{std::chrono::milliseconds(100)}; // for kDeadline, default deadline step for each priority rank
+        std::size_t                                                           max_size{static_cast<std::size_t>(-1)};        // total limit, unlimited by default
+        std::vector<std::pair<PrioT, std::size_t /*max_size*/>>               max_size_priorities{};                         // limit by priority, ex: { { kLow, 1000 } }
+        EnumPrioOverflow                                                      overflow{EnumPrioOverflow::kReject};           // what to do when a limit is reached
+        std::vector<std::pair<std::size_t /*flow*/, unsigned int /*weight*/>> flow_weights{};                                // weights for flows (default 1), ex: { { hash("tenant"), 4 } }
     };
 
     // setup default for EnumPriorities
@@ -68,6 +104,13 @@ namespace small {
             {small::EnumPriorities::kNormal, 3},
             {small::EnumPriorities::kLow, 3},
             {small::EnumPriorities::kLowest, 1}};
+        EnumPrioScheduling                                                    scheduling{EnumPrioScheduling::kRatio};        // how the next element is chosen
+        std::chrono::milliseconds                                             aging_time{std::chrono::milliseconds(1000)};   // for kAging, elements waiting longer are promoted
+        std::chrono::milliseconds                                             deadline_time{std::chrono::milliseconds(100)}; // for kDeadline, default deadline step for each priority rank
+        std::size_t                                                           max_size{static_cast<std::size_t>(-1)};        // total limit, unlimited by default
+        std::vector<std::pair<EnumPriorities, std::size_t /*max_size*/>>      max_size_priorities{};                         // limit by priority, ex: { { kLow, 1000 } }
+        EnumPrioOverflow                                                      overflow{EnumPrioOverflow::kReject};           // what to do when a limit is reached
+        std::vector<std::pair<std::size_t /*flow*/, unsigned int /*weight*/>> flow_weights{};                                // weights for flows (default 1), ex: { { hash("tenant"), 4 } }
     };
 
     // setup default for EnumPriorities
@@ -76,15 +119,32 @@ namespace small {
     {
         std::vector<std::pair<EnumIgnorePriorities, unsigned int /*ratio*/>> priorities{
             {small::EnumIgnorePriorities::kNoPriority, 1}};
+        EnumPrioScheduling                                                     scheduling{EnumPrioScheduling::kRatio};        // how the next element is chosen
+        std::chrono::milliseconds                                              aging_time{std::chrono::milliseconds(1000)};   // for kAging, elements waiting longer are promoted
+        std::chrono::milliseconds                                              deadline_time{std::chrono::milliseconds(100)}; // for kDeadline, default deadline step for each priority rank
+        std::size_t                                                            max_size{static_cast<std::size_t>(-1)};        // total limit, unlimited by default
+        std::vector<std::pair<EnumIgnorePriorities, std::size_t /*max_size*/>> max_size_priorities{};                         // limit by priority
+        EnumPrioOverflow                                                       overflow{EnumPrioOverflow::kReject};           // what to do when a limit is reached
+        std::vector<std::pair<std::size_t /*flow*/, unsigned int /*weight*/>>  flow_weights{};                                // weights for flows (default 1)
     };
 
     //
     // queue for priorities
+    // (queues and credits are kept in a flat array indexed by the rank of the priority in config,
+    //  non empty queues and priorities with credits are kept as bit masks so selection is O(1),
+    //  max 64 priorities, the constructor throws std::length_error for more,
+    //  inside a priority the non empty flows are linked in the round robin order and kept in heaps by their earliest front
+    //  for kAging, kDeadline and the drops, so a pop is O(1) or O(log flows), and the empty flows are recycled)
     //
     template <typename T, typename PrioT = EnumPriorities>
     class prio_queue
     {
     public:
+        using BaseQueueWait = small::base_queue_wait<T, small::prio_queue<T, PrioT>>;
+        using TimeClock     = typename BaseQueueWait::TimeClock;
+        using TimeDuration  = typename BaseQueueWait::TimeDuration;
+        using TimePoint     = typename BaseQueueWait::TimePoint;
+
         //
         // prio_queue
         //
@@ -92,9 +152,7 @@ namespace small {
             : m_config(config)
         {
             // create queues
-            for (auto& [prio, ratio] : m_config.priorities) {
-                m_prio_queues[prio];
-            }
+            create_prio_queues();
         }
 
         prio_queue(const prio_queue& o) : prio_queue() { operator=(o); };
@@ -103,15 +161,35 @@ namespace small {
         prio_queue& operator=(const prio_queue& o)
         {
             std::scoped_lock l(m_wait, o.m_wait);
-            m_config      = o.m_config;
-            m_prio_queues = o.m_prio_queues;
+            m_config         = o.m_config;
+            m_prio_index     = o.m_prio_index;
+            m_prio_queues    = o.m_prio_queues;
+            m_flow_weights   = o.m_flow_weights;
+            m_size           = o.m_size;
+            m_all_mask       = o.m_all_mask;
+            m_ratio_mask     = o.m_ratio_mask;
+            m_credit_mask    = o.m_credit_mask;
+            m_counted_mask   = o.m_counted_mask;
+            m_non_empty_mask = o.m_non_empty_mask;
+            m_push_seq       = o.m_push_seq;
+            m_size_approx.store(m_size, std::memory_order_relaxed);
             return *this;
         }
         prio_queue& operator=(prio_queue&& o) noexcept
         {
             std::scoped_lock l(m_wait, o.m_wait);
-            m_config      = std::move(o.m_config);
-            m_prio_queues = std::move(o.m_prio_queues);
+            m_config         = std::move(o.m_config);
+            m_prio_index     = std::move(o.m_prio_index);
+            m_prio_queues    = std::move(o.m_prio_queues);
+            m_flow_weights   = std::move(o.m_flow_weights);
+            m_size           = o.m_size;
+            m_all_mask       = o.m_all_mask;
+            m_ratio_mask     = o.m_ratio_mask;
+            m_credit_mask    = o.m_credit_mask;
+            m_counted_mask   = o.m_counted_mask;
+            m_non_empty_mask = o.m_non_empty_mask;
+            m_push_seq       = o.m_push_seq;
+            m_size_approx.store(m_size, std::memory_order_relaxed);
             return *this;
         }
 
@@ -121,22 +199,20 @@ namespace small {
         inline size_t size()
         {
             std::unique_lock l(m_wait);
-
-            std::size_t total = 0;
-            for (auto& [prio, q] : m_prio_queues) {
-                total += q.size();
-            }
-            return total;
+            return m_size;
         }
 
         inline bool empty() { return size() == 0; }
 
+        // size without the lock (approximate when used from other threads, to check for items before taking the lock)
+        inline std::size_t size_approx() const { return m_size_approx.load(std::memory_order_relaxed); }
+
         inline size_t size(const PrioT priority)
         {
             std::unique_lock l(m_wait);
 
-            auto it = m_prio_queues.find(priority);
-            return it != m_prio_queues.end() ? it->second.size() : 0;
+            auto index = get_prio_index(priority);
+            return index != kNoPrioIndex ? m_prio_queues[index].m_size : 0;
         }
 
         inline bool empty(const PrioT priority) { return size(priority) == 0; }
@@ -147,26 +223,32 @@ namespace small {
         inline void clear()
         {
             std::unique_lock l(m_wait);
-            for (auto& [prio, q] : m_prio_queues) {
-                q.clear();
+            for (auto& prio_queue : m_prio_queues) {
+                clear_prio_queue(prio_queue);
             }
+            m_size           = 0;
+            m_non_empty_mask = 0;
+            m_size_approx.store(0, std::memory_order_relaxed);
+            m_space_condition.notify_all();
         }
 
         inline void clear(const PrioT priority)
         {
             std::unique_lock l(m_wait);
 
-            auto it = m_prio_queues.find(priority);
-            if (it != m_prio_queues.end()) {
-                it->second.clear();
+            auto index = get_prio_index(priority);
+            if (index != kNoPrioIndex) {
+                clear_prio_queue(m_prio_queues[index]);
+                m_non_empty_mask &= ~prio_bit(index);
+                m_space_condition.notify_all();
             }
         }
 
         // clang-format off
-        // use it as locker 
-        inline void lock        () { m_wait.lock(); }
-        inline void unlock      () { m_wait.unlock(); }
-        inline bool try_lock    () { return m_wait.try_lock(); }
+        // use it as locker (the depth is kept because a push with kBlock can not wait while the caller holds the lock)
+        inline void lock        () { m_wait.lock(); ++m_user_lock_depth; }
+        inline void unlock      () { --m_user_lock_depth; m_wait.unlock(); }
+        inline bool try_lock    () { if (!m_wait.try_lock()) { return false; } ++m_user_lock_depth; return true; }
         // clang-format on
 
         //
@@ -180,17 +262,51 @@ namespace small {
 
             std::unique_lock l(m_wait);
 
-            auto it = m_prio_queues.find(priority);
-            if (it == m_prio_queues.end()) {
+            auto index = get_prio_index(priority);
+            if (index == kNoPrioIndex || !make_room(l, index)) {
                 return 0;
             }
 
-            it->second.push_back(elem);
+            emplace_prio_elem(index, kDefaultFlowIndex, get_push_time(index), elem);
             m_wait.notify_one();
             return 1;
         }
 
         inline std::size_t push_back(const std::pair<PrioT, T>& pair_elem)
+        {
+            return push_back(pair_elem.first, pair_elem.second);
+        }
+
+        inline std::size_t push_back(const PrioT priority, const std::vector<T>& elems)
+        {
+            if (is_exit()) {
+                return 0;
+            }
+
+            std::unique_lock l(m_wait);
+
+            auto index = get_prio_index(priority);
+            if (index == kNoPrioIndex) {
+                return 0;
+            }
+
+            auto        time  = get_push_time(index);
+            std::size_t count = 0;
+            for (auto& elem : elems) {
+                if (!make_room(l, index)) {
+                    break;
+                }
+                emplace_prio_elem(index, kDefaultFlowIndex, time, elem);
+                ++count;
+            }
+            if (count > 0) {
+                m_wait.notify_all();
+            }
+            return count;
+        }
+
+        // push_back move semantics
+        inline std::size_t push_back(const PrioT priority, T&& elem)
         {
             if (is_exit()) {
                 return 0;
@@ -198,17 +314,22 @@ namespace small {
 
             std::unique_lock l(m_wait);
 
-            auto it = m_prio_queues.find(pair_elem.first);
-            if (it == m_prio_queues.end()) {
+            auto index = get_prio_index(priority);
+            if (index == kNoPrioIndex || !make_room(l, index)) {
                 return 0;
             }
 
-            it->second.push_back(pair_elem.second);
+            emplace_prio_elem(index, kDefaultFlowIndex, get_push_time(index), std::forward<T>(elem));
             m_wait.notify_one();
             return 1;
         }
 
-        inline std::size_t push_back(const PrioT priority, const std::vector<T>& elems)
+        inline std::size_t push_back(std::pair<PrioT, T>&& pair_elem)
+        {
+            return push_back(pair_elem.first, std::forward<T>(pair_elem.second));
+        }
+
+        inline std::size_t push_back(const PrioT priority, std::vector<T>&& elems)
         {
             if (is_exit()) {
                 return 0;
@@ -216,22 +337,29 @@ namespace small {
 
             std::unique_lock l(m_wait);
 
-            auto it = m_prio_queues.find(priority);
-            if (it == m_prio_queues.end()) {
+            auto index = get_prio_index(priority);
+            if (index == kNoPrioIndex) {
                 return 0;
             }
 
+            auto        time  = get_push_time(index);
             std::size_t count = 0;
             for (auto& elem : elems) {
-                it->second.push_back(elem);
+                if (!make_room(l, index)) {
+                    break;
+                }
+                emplace_prio_elem(index, kDefaultFlowIndex, time, std::move(elem));
                 ++count;
             }
-            m_wait.notify_all();
+            if (count > 0) {
+                m_wait.notify_all();
+            }
             return count;
         }
 
-        // push_back move semantics
-        inline std::size_t push_back(const PrioT priority, T&& elem)
+        // emplace_back
+        template <typename... _Args>
+        inline std::size_t emplace_back(const PrioT priority, _Args&&... __args)
         {
             if (is_exit()) {
                 return 0;
@@ -239,17 +367,32 @@ namespace small {
 
             std::unique_lock l(m_wait);
 
-            auto it = m_prio_queues.find(priority);
-            if (it == m_prio_queues.end()) {
+            auto index = get_prio_index(priority);
+            if (index == kNoPrioIndex || !make_room(l, index)) {
                 return 0;
             }
 
-            it->second.push_back(std::forward<T>(elem));
+            emplace_prio_elem(index, kDefaultFlowIndex, get_push_time(index), std::forward<_Args>(__args)...);
             m_wait.notify_one();
             return 1;
         }
 
-        inline std::size_t push_back(std::pair<PrioT, T>&& pair_elem)
+        //
+        // push_back with deadline (used for EnumPrioScheduling::kDeadline, otherwise is like a normal push_back)
+        //
+        template <typename _Rep, typename _Period>
+        inline std::size_t push_back_deadline_for(const std::chrono::duration<_Rep, _Period>& __rtime, const PrioT priority, const T& elem)
+        {
+            using __dur    = TimeDuration;
+            auto __reltime = std::chrono::duration_cast<__dur>(__rtime);
+            if (__reltime < __rtime) {
+                ++__reltime;
+            }
+            return push_back_deadline_until(TimeClock::now() + __reltime, priority, elem);
+        }
+
+        // avoid time_casting from one clock to another // template <typename _Clock, typename _Duration> //
+        inline std::size_t push_back_deadline_until(const std::chrono::time_point<TimeClock, TimeDuration>& __atime, const PrioT priority, const T& elem)
         {
             if (is_exit()) {
                 return 0;
@@ -257,17 +400,30 @@ namespace small {
 
             std::unique_lock l(m_wait);
 
-            auto it = m_prio_queues.find(pair_elem.first);
-            if (it == m_prio_queues.end()) {
+            auto index = get_prio_index(priority);
+            if (index == kNoPrioIndex || !make_room(l, index)) {
                 return 0;
             }
 
-            it->second.push_back(std::forward<T>(pair_elem.second));
+            emplace_prio_elem(index, kDefaultFlowIndex, get_deadline_time(index, __atime), elem);
             m_wait.notify_one();
             return 1;
         }
 
-        inline std::size_t push_back(const PrioT priority, std::vector<T>&& elems)
+        // push_back with deadline move semantics
+        template <typename _Rep, typename _Period>
+        inline std::size_t push_back_deadline_for(const std::chrono::duration<_Rep, _Period>& __rtime, const PrioT priority, T&& elem)
+        {
+            using __dur    = TimeDuration;
+            auto __reltime = std::chrono::duration_cast<__dur>(__rtime);
+            if (__reltime < __rtime) {
+                ++__reltime;
+            }
+            return push_back_deadline_until(TimeClock::now() + __reltime, priority, std::forward<T>(elem));
+        }
+
+        // avoid time_casting from one clock to another // template <typename _Clock, typename _Duration> //
+        inline std::size_t push_back_deadline_until(const std::chrono::time_point<TimeClock, TimeDuration>& __atime, const PrioT priority, T&& elem)
         {
             if (is_exit()) {
                 return 0;
@@ -275,23 +431,68 @@ namespace small {
 
             std::unique_lock l(m_wait);
 
-            auto it = m_prio_queues.find(priority);
-            if (it == m_prio_queues.end()) {
+            auto index = get_prio_index(priority);
+            if (index == kNoPrioIndex || !make_room(l, index)) {
                 return 0;
             }
 
+            emplace_prio_elem(index, kDefaultFlowIndex, get_deadline_time(index, __atime), std::forward<T>(elem));
+            m_wait.notify_one();
+            return 1;
+        }
+
+        //
+        // push_back for a flow (ex: a tenant), inside the same priority the flows are served round robin by weight
+        //
+        inline std::size_t push_back_flow(const PrioT priority, const std::size_t flow, const T& elem)
+        {
+            if (is_exit()) {
+                return 0;
+            }
+
+            std::unique_lock l(m_wait);
+
+            auto index = get_prio_index(priority);
+            if (index == kNoPrioIndex || !make_room(l, index)) {
+                return 0;
+            }
+
+            emplace_prio_elem(index, get_flow_index(index, flow), get_push_time(index), elem);
+            m_wait.notify_one();
+            return 1;
+        }
+
+        inline std::size_t push_back_flow(const PrioT priority, const std::size_t flow, const std::vector<T>& elems)
+        {
+            if (is_exit()) {
+                return 0;
+            }
+
+            std::unique_lock l(m_wait);
+
+            auto index = get_prio_index(priority);
+            if (index == kNoPrioIndex) {
+                return 0;
+            }
+
+            // (the flow is taken after making room, the flow is recycled if it becomes empty meanwhile)
+            auto        time  = get_push_time(index);
             std::size_t count = 0;
             for (auto& elem : elems) {
-                it->second.push_back(std::forward<T>(elem));
+                if (!make_room(l, index)) {
+                    break;
+                }
+                emplace_prio_elem(index, get_flow_index(index, flow), time, elem);
                 ++count;
             }
-            m_wait.notify_all();
+            if (count > 0) {
+                m_wait.notify_all();
+            }
             return count;
         }
 
-        // emplace_back
-        template <typename... _Args>
-        inline std::size_t emplace_back(const PrioT priority, _Args&&... __args)
+        // push_back for a flow move semantics
+        inline std::size_t push_back_flow(const PrioT priority, const std::size_t flow, T&& elem)
         {
             if (is_exit()) {
                 return 0;
@@ -299,24 +500,104 @@ namespace small {
 
             std::unique_lock l(m_wait);
 
-            auto it = m_prio_queues.find(priority);
-            if (it == m_prio_queues.end()) {
+            auto index = get_prio_index(priority);
+            if (index == kNoPrioIndex || !make_room(l, index)) {
                 return 0;
             }
 
-            it->second.emplace_back(std::forward<_Args>(__args)...);
+            emplace_prio_elem(index, get_flow_index(index, flow), get_push_time(index), std::forward<T>(elem));
             m_wait.notify_one();
             return 1;
         }
 
+        //
+        // push_back for a flow with deadline (used for EnumPrioScheduling::kDeadline, otherwise is like a normal push_back_flow)
+        //
+        // avoid time_casting from one clock to another // template <typename _Clock, typename _Duration> //
+        inline std::size_t push_back_flow_deadline_until(const std::chrono::time_point<TimeClock, TimeDuration>& __atime, const PrioT priority, const std::size_t flow, const T& elem)
+        {
+            if (is_exit()) {
+                return 0;
+            }
+
+            std::unique_lock l(m_wait);
+
+            auto index = get_prio_index(priority);
+            if (index == kNoPrioIndex || !make_room(l, index)) {
+                return 0;
+            }
+
+            emplace_prio_elem(index, get_flow_index(index, flow), get_deadline_time(index, __atime), elem);
+            m_wait.notify_one();
+            return 1;
+        }
+
+        // push_back for a flow with deadline move semantics
+        inline std::size_t push_back_flow_deadline_until(const std::chrono::time_point<TimeClock, TimeDuration>& __atime, const PrioT priority, const std::size_t flow, T&& elem)
+        {
+            if (is_exit()) {
+                return 0;
+            }
+
+            std::unique_lock l(m_wait);
+
+            auto index = get_prio_index(priority);
+            if (index == kNoPrioIndex || !make_room(l, index)) {
+                return 0;
+            }
+
+            emplace_prio_elem(index, get_flow_index(index, flow), get_deadline_time(index, __atime), std::forward<T>(elem));
+            m_wait.notify_one();
+            return 1;
+        }
+
+        //
+        // load shedding stats (elements not added or dropped because of limits)
+        //
+        inline std::size_t count_rejected()
+        {
+            std::unique_lock l(m_wait);
+            std::size_t      count = 0;
+            for (auto& prio_queue : m_prio_queues) {
+                count += prio_queue.m_count_rejected;
+            }
+            return count;
+        }
+
+        inline std::size_t count_rejected(const PrioT priority)
+        {
+            std::unique_lock l(m_wait);
+
+            auto index = get_prio_index(priority);
+            return index != kNoPrioIndex ? m_prio_queues[index].m_count_rejected : 0;
+        }
+
+        inline std::size_t count_dropped()
+        {
+            std::unique_lock l(m_wait);
+            std::size_t      count = 0;
+            for (auto& prio_queue : m_prio_queues) {
+                count += prio_queue.m_count_dropped;
+            }
+            return count;
+        }
+
+        inline std::size_t count_dropped(const PrioT priority)
+        {
+            std::unique_lock l(m_wait);
+
+            auto index = get_prio_index(priority);
+            return index != kNoPrioIndex ? m_prio_queues[index].m_count_dropped : 0;
+        }
+
         // clang-format off
         //
         // exit
         //
-        inline void signal_exit_force   ()  { m_wait.signal_exit_force(); }
+        inline void signal_exit_force   ()  { m_wait.signal_exit_force(); notify_space(); }
         inline bool is_exit_force       ()  { return m_wait.is_exit_force(); }
 
-        inline void signal_exit_when_done() { m_wait.signal_exit_when_done(); }
+        inline void signal_exit_when_done() { m_wait.signal_exit_when_done(); notify_space(); }
         inline bool is_exit_when_done   ()  { return m_wait.is_exit_when_done(); }
         
         inline bool is_exit             ()  { return is_exit_force() || is_exit_when_done(); }
@@ -386,127 +667,697 @@ namespace small {
         }
 
     private:
-        using BaseQueueWait = small::base_queue_wait<T, small::prio_queue<T, PrioT>>;
         friend BaseQueueWait;
 
-        struct Stats
+        static constexpr std::size_t kMaxPriorities      = 64;                           // limited by the bit masks
+        static constexpr std::size_t kMaxDirectPrioIndex = 256;                          // enum/integral priorities up to this value are mapped with a table
+        static constexpr std::size_t kNoPrioIndex        = static_cast<std::size_t>(-1); // priority is not configured
+        static constexpr std::size_t kDefaultFlowIndex   = 0;                            // flow for elements pushed without flow
+        static constexpr std::size_t kNoFlowIndex        = static_cast<std::size_t>(-1); // the flow that is next in the round robin
+
+        struct PrioElem
         {
-            unsigned int m_count_executed{}; // how many times was executed
+            template <typename... _Args>
+            explicit PrioElem(const TimePoint& time, const std::uint64_t seq, _Args&&... __args)
+                : m_time(time), m_seq(seq), m_elem(std::forward<_Args>(__args)...) {}
+
+            TimePoint     m_time{}; // push time (for kAging) or deadline (for kDeadline)
+            std::uint64_t m_seq{};  // push order (to find the oldest elem between flows)
+            T             m_elem{}; // element
         };
 
-        // reset higher priority credits
-        inline void reset_higher_stats(const PrioT priority)
+        struct PrioFlow
         {
+            std::deque<PrioElem> m_queue;                   // queue for this flow
+            std::size_t          m_flow{};                  // flow key (an empty flow is recycled for another key)
+            unsigned int         m_weight{1};               // how many elements are taken in a round
+            unsigned int         m_deficit{};               // how many elements can still be taken in the current round
+            bool                 m_active{};                // is in the round robin list
+            std::size_t          m_prev{kNoFlowIndex};      // previous flow in the round robin list
+            std::size_t          m_next{kNoFlowIndex};      // next flow in the round robin list
+            std::size_t          m_front_pos{kNoFlowIndex}; // position in the heap of the fronts
+            std::size_t          m_back_pos{kNoFlowIndex};  // position in the heap of the backs
+        };
+
+        struct PrioQueue
+        {
+            PrioT                                        m_priority{};                             // priority
+            unsigned int                                 m_ratio{};                                // how many executions before giving a credit to a lower priority
+            unsigned int                                 m_count_executed{};                       // how many times was executed
+            std::size_t                                  m_max_size{static_cast<std::size_t>(-1)}; // limit for this priority
+            std::size_t                                  m_count_rejected{};                       // how many new elements were rejected (limit reached)
+            std::size_t                                  m_count_dropped{};                        // how many old elements were dropped (to make room for new ones)
+            std::size_t                                  m_size{};                                 // number of elements for this priority (in all flows)
+            std::vector<PrioFlow>                        m_flows{};                                // flows (first one is for elements pushed without flow)
+            std::unordered_map<std::size_t, std::size_t> m_flow_index{};                           // index of the non empty flows in m_flows (by flow key)
+            std::vector<std::size_t>                     m_free_flows{};                           // empty flows that are reused for new flow keys
+            std::size_t                                  m_active_head{kNoFlowIndex};              // non empty flows in round robin order (linked through the flows)
+            std::size_t                                  m_active_tail{kNoFlowIndex};              // last flow in the round robin order
+            std::size_t                                  m_active_count{};                         // how many flows are in the round robin
+            std::vector<std::size_t>                     m_front_heap{};                           // non empty flows by the earliest front (for kAging, kDeadline and kDropOldestLowest)
+            std::vector<std::size_t>                     m_back_heap{};                            // non empty flows by the latest back (for kDeadline with kDropOldestLowest)
+        };
+
+        //
+        // create the flat array of queues (ordered from high to low) and the mapping from priority to its index
+        //
+        inline void create_prio_queues()
+        {
+            m_prio_queues.clear();
+            m_prio_index.clear();
             for (auto& [prio, ratio] : m_config.priorities) {
-                if (prio == priority) {
-                    break;
+                if (get_prio_index(prio) != kNoPrioIndex) {
+                    continue;
+                }
+                if (m_prio_queues.size() >= kMaxPriorities) {
+                    // a config error, otherwise the elements pushed with the extra priorities would be lost
+                    throw std::length_error("prio_queue supports at most 64 priorities");
+                }
+
+                if constexpr (std::is_enum_v<PrioT> || std::is_integral_v<PrioT>) {
+                    auto value = static_cast<std::size_t>(prio);
+                    if (value < kMaxDirectPrioIndex) {
+                        if (value >= m_prio_index.size()) {
+                            m_prio_index.resize(value + 1, kNoPrioIndex);
+                        }
+                        m_prio_index[value] = m_prio_queues.size();
+                    }
+                }
+
+                m_prio_queues.push_back({.m_priority = prio, .m_ratio = ratio});
+                m_prio_queues.back().m_flows.emplace_back(); // default flow
+            }
+
+            m_flow_weights.clear();
+            for (auto& [flow, weight] : m_config.flow_weights) {
+                m_flow_weights.emplace(flow, std::max(weight, 1u));
+            }
+
+            for (auto& [prio, max_size] : m_config.max_size_priorities) {
+                auto index = get_prio_index(prio);
+                if (index != kNoPrioIndex) {
+                    m_prio_queues[index].m_max_size = max_size;
+                }
+            }
+
+            m_size           = 0;
+            m_all_mask       = low_mask(m_prio_queues.size());
+            m_ratio_mask     = 0;
+            m_counted_mask   = 0;
+            m_non_empty_mask = 0;
+            for (std::size_t index = 0; index < m_prio_queues.size(); ++index) {
+                if (m_prio_queues[index].m_ratio > 0) {
+                    m_ratio_mask |= prio_bit(index);
+                }
+            }
+            m_credit_mask = m_ratio_mask;
+        }
+
+        //
+        // get index of priority
+        //
+        inline std::size_t get_prio_index(const PrioT priority) const
+        {
+            if constexpr (std::is_enum_v<PrioT> || std::is_integral_v<PrioT>) {
+                auto value = static_cast<std::size_t>(priority);
+                if (value < m_prio_index.size()) {
+                    return m_prio_index[value];
+                }
+            }
+
+            for (std::size_t index = 0; index < m_prio_queues.size(); ++index) {
+                if (m_prio_queues[index].m_priority == priority) {
+                    return index;
                 }
-                auto& stats            = m_prio_stats[prio];
-                stats.m_count_executed = 0;
             }
+            return kNoPrioIndex;
         }
 
-        inline void reset_all_stats()
+        // clang-format off
+        // bit helpers
+        static inline std::uint64_t prio_bit    (const std::size_t index) { return std::uint64_t{1} << index; }
+        static inline std::uint64_t low_mask    (const std::size_t count) { return count >= kMaxPriorities ? ~std::uint64_t{0} : prio_bit(count) - 1; }
+        static inline std::size_t   first_index (const std::uint64_t mask) { return static_cast<std::size_t>(std::countr_zero(mask)); }
+        static inline std::size_t   last_index  (const std::uint64_t mask) { return mask ? kMaxPriorities - 1 - static_cast<std::size_t>(std::countl_zero(mask)) : kNoPrioIndex; }
+        // clang-format on
+
+        //
+        // time saved for the elem (only for the modes that need it)
+        //
+        inline TimePoint get_push_time(const std::size_t index) const
         {
-            for (auto& [prio, ratio] : m_config.priorities) {
-                auto& stats            = m_prio_stats[prio];
-                stats.m_count_executed = 0;
+            switch (m_config.scheduling) {
+            case EnumPrioScheduling::kAging:
+                return TimeClock::now();
+            case EnumPrioScheduling::kDeadline:
+                return TimeClock::now() + std::chrono::duration_cast<TimeDuration>(m_config.deadline_time) * static_cast<int>(index + 1);
+            default:
+                return {};
             }
         }
 
-        inline small::WaitFlags pop_front(std::deque<T>& queue, T* elem)
+        //
+        // add elem to the queue of the priority
+        // (for kDeadline the queue of the flow is kept ordered by deadline, usually the deadline is the latest so it is added at the end)
+        //
+        template <typename... _Args>
+        inline void emplace_prio_elem(const std::size_t index, const std::size_t flow_index, const TimePoint& time, _Args&&... __args)
         {
-            // get elem
-            if (elem) {
-                *elem = std::move(queue.front());
+            auto& queue = m_prio_queues[index].m_flows[flow_index].m_queue;
+            if (m_config.scheduling != EnumPrioScheduling::kDeadline || queue.empty() || !(time < queue.back().m_time)) {
+                queue.emplace_back(time, m_push_seq++, std::forward<_Args>(__args)...);
+            } else {
+                auto it = std::upper_bound(queue.begin(), queue.end(), time, [](const TimePoint& t, const PrioElem& e) { return t < e.m_time; });
+                queue.emplace(it, time, m_push_seq++, std::forward<_Args>(__args)...);
             }
-            queue.pop_front();
+            added_prio_elem(index, flow_index);
+        }
 
-            return small::WaitFlags::kElement;
+        // the given deadline is used only for kDeadline
+        inline TimePoint get_deadline_time(const std::size_t index, const TimePoint& deadline) const
+        {
+            return m_config.scheduling == EnumPrioScheduling::kDeadline ? deadline : get_push_time(index);
         }
 
-        // extract from queue
-        inline small::WaitFlags test_and_get(T* elem, typename BaseQueueWait::TimePoint* /* time_wait_until */, bool* is_empty_after_get)
+        inline void added_prio_elem(const std::size_t index, const std::size_t flow_index)
         {
-            *is_empty_after_get = true;
+            auto& prio_queue = m_prio_queues[index];
+            if (prio_queue.m_flows.size() > 1) {
+                if (!prio_queue.m_flows[flow_index].m_active) {
+                    activate_flow(prio_queue, flow_index);
+                }
+                update_flow_heaps(prio_queue, flow_index);
+            }
 
-            if (is_exit_force()) {
-                return small::WaitFlags::kExit_Force;
+            ++prio_queue.m_size;
+            ++m_size;
+            m_size_approx.store(m_size, std::memory_order_relaxed);
+            m_non_empty_mask |= prio_bit(index);
+        }
+
+        //
+        // flows (allocated on first use and recycled when they are empty, so only the non empty flows are kept)
+        //
+        inline std::size_t get_flow_index(const std::size_t index, const std::size_t flow)
+        {
+            auto& prio_queue = m_prio_queues[index];
+
+            auto it_f = prio_queue.m_flow_index.find(flow);
+            if (it_f != prio_queue.m_flow_index.end()) {
+                return it_f->second;
+            }
+
+            std::size_t flow_index = kNoFlowIndex;
+            if (!prio_queue.m_free_flows.empty()) {
+                flow_index = prio_queue.m_free_flows.back();
+                prio_queue.m_free_flows.pop_back();
+            } else {
+                flow_index = prio_queue.m_flows.size();
+                prio_queue.m_flows.emplace_back();
+
+                // until the first flow is created the round robin is not used
+                auto& default_flow = prio_queue.m_flows[kDefaultFlowIndex];
+                if (flow_index == 1 && !default_flow.m_queue.empty()) {
+                    activate_flow(prio_queue, kDefaultFlowIndex);
+                    update_flow_heaps(prio_queue, kDefaultFlowIndex);
+                }
             }
 
-            std::optional<PrioT> prio_with_non_empty_queue;
+            auto  it_w                    = m_flow_weights.find(flow);
+            auto& prio_flow               = prio_queue.m_flows[flow_index];
+            prio_flow.m_flow              = flow;
+            prio_flow.m_weight            = it_w != m_flow_weights.end() ? it_w->second : 1u;
+            prio_queue.m_flow_index[flow] = flow_index;
+            return flow_index;
+        }
 
-            // iterate priorities from high to low
-            for (auto& [prio, ratio] : m_config.priorities) {
-                auto* queue = &m_prio_queues[prio];
-                auto& stats = m_prio_stats[prio];
+        // the flow joins the round robin
+        static inline void activate_flow(PrioQueue& prio_queue, const std::size_t flow_index)
+        {
+            auto& flow     = prio_queue.m_flows[flow_index];
+            flow.m_active  = true;
+            flow.m_deficit = flow.m_weight;
+            link_flow(prio_queue, flow_index);
+        }
 
-                // save the first priority for which the queue is not empty
-                if (!queue->empty() && !prio_with_non_empty_queue) {
-                    prio_with_non_empty_queue = prio;
+        // the empty flow leaves the round robin and the heaps and it is recycled (the default flow is kept)
+        inline void release_flow(PrioQueue& prio_queue, const std::size_t flow_index)
+        {
+            auto& flow    = prio_queue.m_flows[flow_index];
+            flow.m_active = false;
+            unlink_flow(prio_queue, flow_index);
+            update_flow_heaps(prio_queue, flow_index);
+            if (flow_index != kDefaultFlowIndex) {
+                prio_queue.m_flow_index.erase(flow.m_flow);
+                prio_queue.m_free_flows.push_back(flow_index);
+            }
+        }
+
+        //
+        // round robin list of the non empty flows (linked through the flows, so a flow leaves it from any place in O(1))
+        //
+        static inline void link_flow(PrioQueue& prio_queue, const std::size_t flow_index)
+        {
+            auto& flow  = prio_queue.m_flows[flow_index];
+            flow.m_prev = prio_queue.m_active_tail;
+            flow.m_next = kNoFlowIndex;
+            if (prio_queue.m_active_tail != kNoFlowIndex) {
+                prio_queue.m_flows[prio_queue.m_active_tail].m_next = flow_index;
+            } else {
+                prio_queue.m_active_head = flow_index;
+            }
+            prio_queue.m_active_tail = flow_index;
+            ++prio_queue.m_active_count;
+        }
+
+        static inline void unlink_flow(PrioQueue& prio_queue, const std::size_t flow_index)
+        {
+            auto& flow = prio_queue.m_flows[flow_index];
+            if (flow.m_prev != kNoFlowIndex) {
+                prio_queue.m_flows[flow.m_prev].m_next = flow.m_next;
+            } else {
+                prio_queue.m_active_head = flow.m_next;
+            }
+            if (flow.m_next != kNoFlowIndex) {
+                prio_queue.m_flows[flow.m_next].m_prev = flow.m_prev;
+            } else {
+                prio_queue.m_active_tail = flow.m_prev;
+            }
+            flow.m_prev = flow.m_next = kNoFlowIndex;
+            --prio_queue.m_active_count;
+        }
+
+        //
+        // heaps of the non empty flows by the earliest front (the next elem for kAging and kDeadline, the oldest one to drop)
+        // and by the latest back (the least urgent elem to drop for kDeadline), each flow keeps its position in the heaps
+        //
+        // clang-format off
+        inline bool is_front_heap   () const { return m_config.scheduling != EnumPrioScheduling::kRatio || m_config.overflow == EnumPrioOverflow::kDropOldestLowest; }
+        inline bool is_back_heap    () const { return m_config.scheduling == EnumPrioScheduling::kDeadline && m_config.overflow == EnumPrioOverflow::kDropOldestLowest; }
+        static inline bool is_before(const PrioElem& a, const PrioElem& b) { return a.m_time < b.m_time || (a.m_time == b.m_time && a.m_seq < b.m_seq); }
+        // clang-format on
+
+        // the front or the back of the flow was changed
+        inline void update_flow_heaps(PrioQueue& prio_queue, const std::size_t flow_index)
+        {
+            if (is_front_heap()) {
+                heap_update<false>(prio_queue, flow_index);
+            }
+            if (is_back_heap()) {
+                heap_update<true>(prio_queue, flow_index);
+            }
+        }
+
+        template <bool Back>
+        static inline std::vector<std::size_t>& get_heap(PrioQueue& prio_queue)
+        {
+            if constexpr (Back) {
+                return prio_queue.m_back_heap;
+            } else {
+                return prio_queue.m_front_heap;
+            }
+        }
+
+        template <bool Back>
+        static inline std::size_t& get_heap_pos(PrioFlow& flow)
+        {
+            if constexpr (Back) {
+                return flow.m_back_pos;
+            } else {
+                return flow.m_front_pos;
+            }
+        }
+
+        // the flow a is before the flow b in the heap
+        template <bool Back>
+        static inline bool is_heap_before(const PrioQueue& prio_queue, const std::size_t a, const std::size_t b)
+        {
+            auto& queue_a = prio_queue.m_flows[a].m_queue;
+            auto& queue_b = prio_queue.m_flows[b].m_queue;
+            if constexpr (Back) {
+                return is_before(queue_b.back(), queue_a.back());
+            } else {
+                return is_before(queue_a.front(), queue_b.front());
+            }
+        }
+
+        // add the flow, move it to its place or remove it when it is empty
+        template <bool Back>
+        static inline void heap_update(PrioQueue& prio_queue, const std::size_t flow_index)
+        {
+            auto& heap = get_heap<Back>(prio_queue);
+            auto& pos  = get_heap_pos<Back>(prio_queue.m_flows[flow_index]);
+            if (!prio_queue.m_flows[flow_index].m_queue.empty()) {
+                if (pos == kNoFlowIndex) {
+                    pos = heap.size();
+                    heap.push_back(flow_index);
                 }
+                heap_sift<Back>(prio_queue, pos);
+                return;
+            }
 
-                // check if it has credits
-                if (stats.m_count_executed >= ratio) {
-                    // no more credit here, go to next priority
+            if (pos == kNoFlowIndex) {
+                return;
+            }
+            auto hole = pos;
+            pos       = kNoFlowIndex;
+            if (hole + 1 < heap.size()) {
+                heap[hole] = heap.back();
+                heap.pop_back();
+                heap_sift<Back>(prio_queue, hole);
+            } else {
+                heap.pop_back();
+            }
+        }
+
+        // move the flow from this position up or down until the heap is ordered
+        template <bool Back>
+        static inline void heap_sift(PrioQueue& prio_queue, std::size_t pos)
+        {
+            auto&      heap       = get_heap<Back>(prio_queue);
+            const auto flow_index = heap[pos];
+            while (pos > 0 && is_heap_before<Back>(prio_queue, flow_index, heap[(pos - 1) / 2])) {
+                heap_set<Back>(prio_queue, pos, heap[(pos - 1) / 2]);
+                pos = (pos - 1) / 2;
+            }
+            for (auto child = 2 * pos + 1; child < heap.size(); child = 2 * pos + 1) {
+                if (child + 1 < heap.size() && is_heap_before<Back>(prio_queue, heap[child + 1], heap[child])) {
+                    ++child;
+                }
+                if (!is_heap_before<Back>(prio_queue, heap[child], flow_index)) {
+                    break;
+                }
+                heap_set<Back>(prio_queue, pos, heap[child]);
+                pos = child;
+            }
+            heap_set<Back>(prio_queue, pos, flow_index);
+        }
+
+        template <bool Back>
+        static inline void heap_set(PrioQueue& prio_queue, const std::size_t pos, const std::size_t flow_index)
+        {
+            get_heap<Back>(prio_queue)[pos]                    = flow_index;
+            get_heap_pos<Back>(prio_queue.m_flows[flow_index]) = pos;
+        }
+
+        // the flow with the earliest time in front between the non empty flows of this priority
+        // (the oldest elem for kAging or the earliest deadline for kDeadline, the front of each flow is the earliest for that flow)
+        inline std::size_t get_earliest_flow_index(const std::size_t index) const
+        {
+            auto& prio_queue = m_prio_queues[index];
+            return prio_queue.m_flows.size() == 1 ? kDefaultFlowIndex : prio_queue.m_front_heap.front();
+        }
+
+        inline void clear_prio_queue(PrioQueue& prio_queue)
+        {
+            // only the default flow is kept
+            prio_queue.m_flows.resize(1);
+            prio_queue.m_flows[kDefaultFlowIndex] = {};
+            prio_queue.m_flow_index.clear();
+            prio_queue.m_free_flows.clear();
+            prio_queue.m_active_head  = kNoFlowIndex;
+            prio_queue.m_active_tail  = kNoFlowIndex;
+            prio_queue.m_active_count = 0;
+            prio_queue.m_front_heap.clear();
+            prio_queue.m_back_heap.clear();
+            m_size -= prio_queue.m_size;
+            prio_queue.m_size = 0;
+            m_size_approx.store(m_size, std::memory_order_relaxed);
+        }
+
+        //
+        // check the limits and apply the overflow policy, returns false if the new elem must not be added
+        //
+        inline bool make_room(std::unique_lock<BaseQueueWait>& l, const std::size_t index)
+        {
+            for (;;) {
+                auto& prio_queue = m_prio_queues[index];
+                bool  prio_full  = prio_queue.m_size >= prio_queue.m_max_size;
+                if (!prio_full && m_size < m_config.max_size) {
+                    return true;
+                }
+
+                if (m_config.overflow == EnumPrioOverflow::kBlock && m_user_lock_depth == 0) {
+                    if (is_exit()) {
+                        return false;
+                    }
+                    // wake up the consumers for what was already added (the lock is released while waiting)
+                    m_wait.notify_all();
+                    m_space_condition.wait(l);
+                    continue;
+                }
+
+                // drop from the same priority or from the lowest non empty priority (never from a higher one)
+                auto victim = prio_full ? index : last_index(m_non_empty_mask);
+                if (m_config.overflow == EnumPrioOverflow::kDropOldestLowest && victim != kNoPrioIndex && victim >= index && m_prio_queues[victim].m_size > 0) {
+                    drop_prio_elem(victim);
+                    ++m_prio_queues[victim].m_count_dropped;
                     continue;
                 }
 
-                // increase counter for current prio (see above that all previous (with higher priorities) are reseted)
+                ++prio_queue.m_count_rejected;
+                return false;
+            }
+        }
+
+        //
+        // drop the oldest elem of the priority (the front of each flow is the oldest of that flow)
+        // or for kDeadline the elem with the latest deadline (the back of each flow, the least urgent one)
+        //
+        inline void drop_prio_elem(const std::size_t index)
+        {
+            auto&      prio_queue = m_prio_queues[index];
+            const bool deadline   = m_config.scheduling == EnumPrioScheduling::kDeadline;
+
+            auto flow_index = kDefaultFlowIndex;
+            if (prio_queue.m_flows.size() > 1) {
+                flow_index = deadline ? prio_queue.m_back_heap.front() : prio_queue.m_front_heap.front();
+            }
+
+            auto& flow = prio_queue.m_flows[flow_index];
+            if (deadline) {
+                flow.m_queue.pop_back();
+            } else {
+                flow.m_queue.pop_front();
+            }
+
+            // the flow leaves the round robin (its place in the round is kept if it still has elements)
+            if (prio_queue.m_flows.size() == 1) {
+                // no flows
+            } else if (flow.m_queue.empty()) {
+                release_flow(prio_queue, flow_index);
+            } else {
+                update_flow_heaps(prio_queue, flow_index);
+            }
+
+            --m_size;
+            m_size_approx.store(m_size, std::memory_order_relaxed);
+            if (--prio_queue.m_size == 0) {
+                m_non_empty_mask &= ~prio_bit(index);
+            }
+        }
+
+        inline void notify_space()
+        {
+            std::unique_lock l(m_wait);
+            m_space_condition.notify_all();
+        }
+
+        //
+        // credits
+        //
+        inline void set_count_executed(const std::size_t index, const unsigned int count_executed)
+        {
+            auto& prio_queue            = m_prio_queues[index];
+            prio_queue.m_count_executed = count_executed;
+
+            auto bit       = prio_bit(index);
+            m_counted_mask = count_executed ? (m_counted_mask | bit) : (m_counted_mask & ~bit);
+            m_credit_mask  = count_executed < prio_queue.m_ratio ? (m_credit_mask | bit) : (m_credit_mask & ~bit);
+        }
+
+        // reset credits (only the priorities that were executed are visited)
+        inline void reset_stats(const std::uint64_t mask)
+        {
+            for (auto reset_mask = m_counted_mask & mask; reset_mask; reset_mask &= reset_mask - 1) {
+                m_prio_queues[first_index(reset_mask)].m_count_executed = 0;
+            }
+            m_counted_mask &= ~mask;
+            m_credit_mask = (m_credit_mask & ~mask) | (m_ratio_mask & mask);
+        }
+
+        // pop from the flow (kNoFlowIndex for the flow that is next in the round robin)
+        inline small::WaitFlags pop_front(const std::size_t index, const std::size_t chosen_flow_index, T* elem)
+        {
+            auto& prio_queue = m_prio_queues[index];
+            auto  flow_index = prio_queue.m_flows.size() == 1 ? kDefaultFlowIndex : (chosen_flow_index != kNoFlowIndex ? chosen_flow_index : prio_queue.m_active_head);
+            auto& flow       = prio_queue.m_flows[flow_index];
+
+            // get elem
+            if (elem) {
+                *elem = std::move(flow.m_queue.front().m_elem);
+            }
+            flow.m_queue.pop_front();
+
+            // deficit round robin between flows (each elem costs 1)
+            if (prio_queue.m_flows.size() == 1) {
+                // no flows
+            } else if (flow.m_queue.empty()) {
+                release_flow(prio_queue, flow_index);
+            } else {
+                // an aged elem or an earlier deadline taken out of the round robin order does not change the round
+                if (flow_index == prio_queue.m_active_head && prio_queue.m_active_count > 1 && --flow.m_deficit == 0) {
+                    flow.m_deficit = flow.m_weight;
+                    unlink_flow(prio_queue, flow_index);
+                    link_flow(prio_queue, flow_index);
+                }
+                update_flow_heaps(prio_queue, flow_index);
+            }
+
+            --m_size;
+            m_size_approx.store(m_size, std::memory_order_relaxed);
+            if (--prio_queue.m_size == 0) {
+                m_non_empty_mask &= ~prio_bit(index);
+            }
+
+            return small::WaitFlags::kElement;
+        }
+
+        //
+        // choose using the ratio between priorities
+        //
+        inline std::size_t get_ratio_prio_index()
+        {
+            // the first priority for which the queue is not empty
+            auto prio_with_non_empty_queue = first_index(m_non_empty_mask);
+
+            // the first priority with credits (higher priorities without elements are just passing the credits to lower ones)
+            auto prio_with_credits = m_credit_mask & ~low_mask(prio_with_non_empty_queue);
+
+            auto index = prio_with_non_empty_queue;
+            if (prio_with_credits) {
+                auto prio = first_index(prio_with_credits);
+
+                // increase counter for current prio and reset all higher priorities
                 // do this even if nothing is in the queue (to avoid the kLowest to be executed too quickly with kVeryHigh)
-                ++stats.m_count_executed;
-                reset_higher_stats(prio);
+                reset_stats(low_mask(prio));
+                set_count_executed(prio, m_prio_queues[prio].m_count_executed + 1);
 
-                if (queue->empty()) {
+                if (m_non_empty_mask & prio_bit(prio)) {
+                    index = prio;
+                } else {
                     // choose one from previous
-                    if (prio_with_non_empty_queue) {
-                        queue            = &m_prio_queues[prio_with_non_empty_queue.value()];
-                        auto& prev_stats = m_prio_stats[prio_with_non_empty_queue.value()];
-                        ++prev_stats.m_count_executed;
-                    }
+                    set_count_executed(index, m_prio_queues[index].m_count_executed + 1);
+                }
+            } else {
+                // no more credits, reset all stats
+                reset_stats(m_all_mask);
+                set_count_executed(index, 1);
+            }
+            return index;
+        }
 
-                    // all queues are empty so far so go to a lower prio
-                    if (queue->empty()) {
-                        continue;
-                    }
+        //
+        // choose the oldest elem that waited more than aging time (the oldest of each priority is the front of one of its flows)
+        //
+        inline std::size_t get_aged_prio_index(std::size_t& flow_index) const
+        {
+            auto aged_time = TimeClock::now() - std::chrono::duration_cast<TimeDuration>(m_config.aging_time);
+            auto index     = kNoPrioIndex;
+            for (auto mask = m_non_empty_mask; mask; mask &= mask - 1) {
+                auto  prio      = first_index(mask);
+                auto  prio_flow = get_earliest_flow_index(prio);
+                auto& time      = m_prio_queues[prio].m_flows[prio_flow].m_queue.front().m_time;
+                if (time < aged_time) {
+                    aged_time  = time;
+                    index      = prio;
+                    flow_index = prio_flow;
                 }
+            }
+            return index;
+        }
 
-                // get elem
-                auto ret            = pop_front(*queue, elem);
-                *is_empty_after_get = empty();
-                return ret;
+        //
+        // choose the earliest deadline (the earliest of each priority is the front of one of its flows)
+        //
+        inline std::size_t get_earliest_deadline_prio_index(std::size_t& flow_index) const
+        {
+            auto      index = kNoPrioIndex;
+            TimePoint deadline{};
+            for (auto mask = m_non_empty_mask; mask; mask &= mask - 1) {
+                auto  prio      = first_index(mask);
+                auto  prio_flow = get_earliest_flow_index(prio);
+                auto& time      = m_prio_queues[prio].m_flows[prio_flow].m_queue.front().m_time;
+                if (index == kNoPrioIndex || time < deadline) {
+                    deadline   = time;
+                    index      = prio;
+                    flow_index = prio_flow;
+                }
             }
+            return index;
+        }
 
-            // reset all stats
-            reset_all_stats();
+        // extract from queue
+        inline small::WaitFlags test_and_get(T* elem, typename BaseQueueWait::TimePoint* /* time_wait_until */, bool* is_empty_after_get)
+        {
+            *is_empty_after_get = true;
+
+            if (is_exit_force()) {
+                return small::WaitFlags::kExit_Force;
+            }
 
-            if (prio_with_non_empty_queue) {
-                auto& queue      = m_prio_queues[prio_with_non_empty_queue.value()];
-                auto& prev_stats = m_prio_stats[prio_with_non_empty_queue.value()];
-                ++prev_stats.m_count_executed;
+            if (!m_non_empty_mask) {
+                // all queues are empty (and all credits are reset like all priorities were visited)
+                reset_stats(m_all_mask);
 
-                // get elem
-                auto ret            = pop_front(queue, elem);
-                *is_empty_after_get = empty();
-                return ret;
+                if (is_exit_when_done()) {
+                    // exit
+                    return small::WaitFlags::kExit_When_Done;
+                }
+
+                return small::WaitFlags::kWait;
             }
 
-            // here all queues are empty
-            if (is_exit_when_done()) {
-                // exit
-                return small::WaitFlags::kExit_When_Done;
+            // choose the queue (and the flow for an aged elem or the earliest deadline)
+            auto index      = kNoPrioIndex;
+            auto flow_index = kNoFlowIndex;
+            if (m_config.scheduling == EnumPrioScheduling::kAging) {
+                index = get_aged_prio_index(flow_index);
+            } else if (m_config.scheduling == EnumPrioScheduling::kDeadline) {
+                index = get_earliest_deadline_prio_index(flow_index);
+            }
+            if (index == kNoPrioIndex) {
+                index = get_ratio_prio_index();
             }
 
-            return small::WaitFlags::kWait;
+            // get elem
+            auto ret            = pop_front(index, flow_index, elem);
+            *is_empty_after_get = m_size == 0;
+
+            if (m_config.overflow == EnumPrioOverflow::kBlock) {
+                m_space_condition.notify_all();
+            }
+            return ret;
         }
 
     private:
         //
         // members
         //
-        mutable BaseQueueWait                    m_wait{*this}; // implements locks & wait
-        config_prio_queue<PrioT>                 m_config;      // config for priorities and ratio of executions
-        std::unordered_map<PrioT, Stats>         m_prio_stats;  // keep credits per priority to implement the ratio (ex: 3:1)
-        std::unordered_map<PrioT, std::deque<T>> m_prio_queues; // map of queues based on priorities
+        mutable BaseQueueWait                         m_wait{*this};       // implements locks & wait
+        config_prio_queue<PrioT>                      m_config;            // config for priorities and ratio of executions
+        std::vector<std::size_t>                      m_prio_index;        // index of the priority in m_prio_queues (for enum/integral priorities)
+        std::vector<PrioQueue>                        m_prio_queues;       // queues and credits by priority (ordered from high to low)
+        std::unordered_map<std::size_t, unsigned int> m_flow_weights;      // weights of the flows from config
+        std::size_t                                   m_size{};            // total number of elements
+        std::uint64_t                                 m_all_mask{};        // bits for all priorities
+        std::uint64_t                                 m_ratio_mask{};      // priorities with ratio > 0
+        std::uint64_t                                 m_credit_mask{};     // priorities with credits (count executed < ratio)
+        std::uint64_t                                 m_counted_mask{};    // priorities with count executed > 0
+        std::uint64_t                                 m_non_empty_mask{};  // priorities with non empty queues
+        std::uint64_t                                 m_push_seq{};        // push order of the next elem
+        std::condition_variable_any                   m_space_condition;   // producers waiting for room (for EnumPrioOverflow::kBlock)
+        unsigned int                                  m_user_lock_depth{}; // how many times the queue is locked with lock() (by the thread that holds the lock)
+        std::atomic<std::size_t>                      m_size_approx{};     // total number of elements that can be read without the lock
     };
 } // namespace small
@@ -4,9 +4,11 @@
 #include "event.h"
 #include "spinlock.h"
 
+#include "future.h"
 #include "lock_queue.h"
 #include "prio_queue.h"
 #include "time_queue.h"
+#include "work_steal_deque.h"
 
 #include "lru_cache.h"
 
@@ -18,4 +20,5 @@
 #include "util.h"
 
 #include "jobs_engine.h"
+#include "pipeline.h"
 #include "worker_thread.h"
@@ -398,7 +398,8 @@ namespace small {
 
             // get elem
             if (elem) {
-                *elem = std::move(m_queue.top().second);
+                // top is const but the element is popped right after so it can be moved (and T can be move only)
+                *elem = std::move(const_cast<PriorityQueueElemT&>(m_queue.top()).second);
             }
             m_queue.pop();
 
@@ -2,9 +2,9 @@
 
 #include <atomic>
 #include <deque>
-#include <future>
 #include <queue>
 
+#include "base_threads.h"
 #include "time_queue.h"
 #include "util_time.h"
 
@@ -12,7 +12,7 @@ namespace small {
 
     //
     // on separate thread when items from time queue become accessible
-    // they are pushed to active queue (parent caller must implement 'push_back')
+    // they are pushed to active queue (parent caller must implement 'delayed_thread_started' and 'push_back')
     //
     template <typename T, typename ParentCallerT>
     class time_queue_thread
@@ -42,12 +42,9 @@ namespace small {
         {
             std::unique_lock l(m_time_queue);
 
-            const int threads_count = 1;
-            m_threads_futures.resize(threads_count);
-            for (auto& tf : m_threads_futures) {
-                if (!tf.valid()) {
-                    tf = std::async(std::launch::async, &time_queue_thread::thread_function, this);
-                }
+            const std::size_t threads_count = 1;
+            while (m_threads.size() < threads_count) {
+                m_threads.start({}, [this](std::stop_token stop_token, const int /* index */) { thread_function(stop_token); });
             }
         }
 
@@ -57,9 +54,7 @@ namespace small {
         inline EnumLock wait()
         {
             m_time_queue.signal_exit_when_done();
-            for (const auto& th : m_threads_futures) {
-                th.wait();
-            }
+            m_threads.wait();
             return small::EnumLock::kExit;
         }
 
@@ -79,25 +74,23 @@ namespace small {
         {
             m_time_queue.signal_exit_when_done();
 
-            for (auto& th : m_threads_futures) {
-                auto ret = th.wait_until(__atime);
-                if (ret == std::future_status::timeout) {
-                    return small::EnumLock::kTimeout;
-                }
-            }
-
-            return small::EnumLock::kExit;
+            return m_threads.wait_until(__atime) ? small::EnumLock::kExit : small::EnumLock::kTimeout;
         }
 
     private:
         //
         // inner thread function for delayed items
         //
-        inline void thread_function()
+        inline void thread_function(std::stop_token stop_token)
         {
+            // when the threads are destroyed without waiting
+            std::stop_callback on_stop(stop_token, [this]() { m_time_queue.signal_exit_when_done(); });
+
+            m_parent_caller.delayed_thread_started();
+
             std::vector<T> vec_elems;
             const int      bulk_count = 1;
-            for (; true; small::sleep_micro(1)) {
+            for (; true;) {
                 // wait
                 small::EnumLock ret = m_time_queue.wait_pop(vec_elems, bulk_count);
 
@@ -124,8 +117,8 @@ namespace small {
         //
         // members
         //
-        small::time_queue<T>           m_time_queue;      // a time priority queue for delayed items
-        std::vector<std::future<void>> m_threads_futures; // threads futures (needed to wait for)
-        ParentCallerT&                 m_parent_caller;   // active queue where to push
+        small::time_queue<T> m_time_queue;    // a time priority queue for delayed items
+        ParentCallerT&       m_parent_caller; // active queue where to push
+        small::base_threads  m_threads;       // threads (they are destroyed first)
     };
 } // namespace small
@@ -2,6 +2,7 @@
 
 #include "util_rand.h"
 #include "util_str.h"
+#include "util_thread.h"
 #include "util_time.h"
 #include "util_timeout.h"
 #include "util_uuid.h"
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <algorithm>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#if defined(__linux__) || defined(__APPLE__)
+#include <pthread.h>
+#endif
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
+namespace small {
+    //
+    // set the name of the current thread (to be seen in debuggers and profilers, on linux only first 15 chars are used)
+    //
+    inline void set_thread_name(const std::string& name)
+    {
+#if defined(__linux__)
+        pthread_setname_np(pthread_self(), name.substr(0, 15).c_str());
+#elif defined(__APPLE__)
+        pthread_setname_np(name.substr(0, 63).c_str());
+#else
+        std::ignore = name;
+#endif
+    }
+
+    //
+    // pin the current thread to the cpus (returns false if not supported)
+    //
+    inline bool set_thread_affinity(const std::vector<int>& cpus)
+    {
+#if defined(__linux__)
+        if (cpus.empty()) {
+            return false;
+        }
+
+        cpu_set_t cpu_set;
+        CPU_ZERO(&cpu_set);
+        for (auto cpu : cpus) {
+            if (cpu >= 0 && cpu < CPU_SETSIZE) {
+                CPU_SET(cpu, &cpu_set);
+            }
+        }
+        return pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set) == 0;
+#else
+        std::ignore = cpus;
+        return false;
+#endif
+    }
+
+    //
+    // the cpus the current thread can run on, sorted (empty if not supported)
+    //
+    inline std::vector<int> get_thread_affinity()
+    {
+        std::vector<int> cpus;
+#if defined(__linux__)
+        cpu_set_t cpu_set;
+        CPU_ZERO(&cpu_set);
+        if (pthread_getaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set) != 0) {
+            return cpus;
+        }
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+            if (CPU_ISSET(cpu, &cpu_set)) {
+                cpus.push_back(cpu);
+            }
+        }
+#endif
+        return cpus;
+    }
+
+    //
+    // all cpus
+    //
+    inline std::vector<int> all_cpus()
+    {
+        std::vector<int> cpus(std::max<>(std::thread::hardware_concurrency(), 1u));
+        for (std::size_t i = 0; i < cpus.size(); ++i) {
+            cpus[i] = static_cast<int>(i);
+        }
+        return cpus;
+    }
+
+    //
+    // cpus of a numa node (empty if not available), on linux from /sys/devices/system/node/node<N>/cpulist like "0-3,8-11"
+    //
+    inline std::vector<int> numa_node_cpus(const int numa_node)
+    {
+        std::vector<int> cpus;
+#if defined(__linux__)
+        std::ifstream file("/sys/devices/system/node/node" + std::to_string(numa_node) + "/cpulist");
+        std::string   cpu_list;
+        std::getline(file, cpu_list);
+
+        std::size_t pos = 0;
+        while (pos < cpu_list.size()) {
+            auto end = cpu_list.find(',', pos);
+            if (end == std::string::npos) {
+                end = cpu_list.size();
+            }
+
+            auto range = cpu_list.substr(pos, end - pos);
+            auto dash  = range.find('-');
+            try {
+                int first = std::stoi(range.substr(0, dash));
+                int last  = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+                for (int cpu = first; cpu <= last; ++cpu) {
+                    cpus.push_back(cpu);
+                }
+            } catch (...) {
+                return {};
+            }
+
+            pos = end + 1;
+        }
+#else
+        std::ignore = numa_node;
+#endif
+        return cpus;
+    }
+
+    //
+    // the cpus where a thread should run, the explicit cpus or the cpus of the numa node (if numa_node >= 0)
+    //
+    inline std::vector<int> thread_cpus(const std::vector<int>& cpus, const int numa_node)
+    {
+        if (!cpus.empty() || numa_node < 0) {
+            return cpus;
+        }
+        return numa_node_cpus(numa_node);
+    }
+
+} // namespace small
@@ -0,0 +1,167 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// a lock free deque (Chase-Lev) where only the owner thread can push and pop (lifo)
+// and any other thread can steal from the other end (fifo)
+//
+// small::work_steal_deque<int> d;
+// ...
+// // on owner thread
+// d.push( new int( 1 ) );
+// int* e = d.pop();
+// ...
+// // on other threads
+// int* s = d.steal();
+// ...
+// // items are owned by the deque while they are inside, the ones left are deleted in destructor
+//
+namespace small {
+
+    template <typename T>
+    class work_steal_deque
+    {
+    public:
+        //
+        // work_steal_deque
+        //
+        explicit work_steal_deque(const std::size_t capacity = 256)
+        {
+            std::size_t size = 1;
+            while (size < capacity) {
+                size <<= 1;
+            }
+            m_buffers.push_back(std::make_unique<Buffer>(size));
+            m_buffer.store(m_buffers.back().get(), std::memory_order_relaxed);
+        }
+
+        ~work_steal_deque()
+        {
+            while (T* item = pop()) {
+                delete item;
+            }
+        }
+
+        //
+        // size (approximate when used from other threads)
+        //
+        inline std::size_t size() const
+        {
+            auto b = m_bottom.load(std::memory_order_relaxed);
+            auto t = m_top.load(std::memory_order_relaxed);
+            return b > t ? static_cast<std::size_t>(b - t) : 0;
+        }
+
+        inline bool empty() const { return size() == 0; }
+
+        //
+        // push (only owner thread)
+        //
+        inline void push(T* item)
+        {
+            auto    b      = m_bottom.load(std::memory_order_relaxed);
+            auto    t      = m_top.load(std::memory_order_acquire);
+            Buffer* buffer = m_buffer.load(std::memory_order_relaxed);
+            if (b - t > static_cast<std::int64_t>(buffer->m_mask)) {
+                buffer = grow(buffer, b, t);
+            }
+            buffer->put(b, item);
+            std::atomic_thread_fence(std::memory_order_release);
+            m_bottom.store(b + 1, std::memory_order_relaxed);
+        }
+
+        //
+        // pop the last pushed (only owner thread)
+        //
+        inline T* pop()
+        {
+            auto    b      = m_bottom.load(std::memory_order_relaxed) - 1;
+            Buffer* buffer = m_buffer.load(std::memory_order_relaxed);
+            m_bottom.store(b, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            auto t = m_top.load(std::memory_order_relaxed);
+
+            if (t > b) {
+                // empty
+                m_bottom.store(b + 1, std::memory_order_relaxed);
+                return nullptr;
+            }
+
+            T* item = buffer->get(b);
+            if (t == b) {
+                // last item, race with steal
+                if (!m_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                    item = nullptr;
+                }
+                m_bottom.store(b + 1, std::memory_order_relaxed);
+            }
+            return item;
+        }
+
+        //
+        // steal the first pushed (any thread), returns nullptr if empty or lost the race
+        //
+        inline T* steal()
+        {
+            auto t = m_top.load(std::memory_order_acquire);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            auto b = m_bottom.load(std::memory_order_acquire);
+
+            if (t >= b) {
+                return nullptr;
+            }
+
+            Buffer* buffer = m_buffer.load(std::memory_order_acquire);
+            T*      item   = buffer->get(t);
+            if (!m_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                return nullptr;
+            }
+            return item;
+        }
+
+    private:
+        // some prevention
+        work_steal_deque(const work_steal_deque&)            = delete;
+        work_steal_deque(work_steal_deque&&)                 = delete;
+        work_steal_deque& operator=(const work_steal_deque&) = delete;
+        work_steal_deque& operator=(work_steal_deque&& __t)  = delete;
+
+    private:
+        // circular buffer
+        struct Buffer
+        {
+            explicit Buffer(const std::size_t size)
+                : m_mask(size - 1), m_items(std::make_unique<std::atomic<T*>[]>(size)) {}
+
+            inline T*   get(const std::int64_t index) const { return m_items[static_cast<std::size_t>(index) & m_mask].load(std::memory_order_relaxed); }
+            inline void put(const std::int64_t index, T* item) { m_items[static_cast<std::size_t>(index) & m_mask].store(item, std::memory_order_relaxed); }
+
+            std::size_t                        m_mask{};  // size - 1 (size is power of 2)
+            std::unique_ptr<std::atomic<T*>[]> m_items{}; // items
+        };
+
+        // double the buffer (the old ones are kept because a thief may still read from them)
+        inline Buffer* grow(Buffer* buffer, const std::int64_t b, const std::int64_t t)
+        {
+            auto new_buffer = std::make_unique<Buffer>((buffer->m_mask + 1) * 2);
+            for (auto i = t; i < b; ++i) {
+                new_buffer->put(i, buffer->get(i));
+            }
+            m_buffers.push_back(std::move(new_buffer));
+            m_buffer.store(m_buffers.back().get(), std::memory_order_release);
+            return m_buffers.back().get();
+        }
+
+    private:
+        //
+        // members
+        //
+        alignas(64) std::atomic<std::int64_t> m_top{0};    // steal end
+        alignas(64) std::atomic<std::int64_t> m_bottom{0}; // owner end
+        std::atomic<Buffer*>                  m_buffer{};  // current buffer
+        std::vector<std::unique_ptr<Buffer>>  m_buffers;   // all buffers (changed only by owner)
+    };
+} // namespace small
@@ -0,0 +1,387 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <random>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "base_threads.h"
+#include "lock_queue.h"
+#include "work_steal_deque.h"
+
+namespace small {
+
+    //
+    // add threads that process items from a shared (injection) queue and from their own deques,
+    // an idle thread steals from the deques of the other threads (parent caller must implement 'config', 'thread_started' and 'process_items')
+    // - items pushed from outside go to the shared queue and are taken in batches
+    // - items pushed from a processing thread go to its own deque (lifo)
+    // - the items in the deques are kept in nodes that are reused (a stolen node is given back to the deque it came from)
+    // - an idle thread parks on the shared queue, and a thread that pushes in its deque while others are parked
+    //   moves one item to the shared queue to wake one of them (which then steals the rest)
+    //
+    template <typename T, typename ParentCallerT>
+    class work_steal_thread
+    {
+    public:
+        //
+        // work_steal_thread
+        //
+        explicit work_steal_thread(ParentCallerT& parent_caller, small::lock_queue<T>& lock_queue)
+            : m_lock_queue(lock_queue),
+              m_parent_caller(parent_caller)
+        {
+            // threads must be manually started
+        }
+
+        //
+        // queue
+        //
+        inline small::lock_queue<T>& queue()
+        {
+            return m_lock_queue;
+        }
+
+        //
+        // size of items in the threads deques (approximate)
+        //
+        inline std::size_t size_local()
+        {
+            std::unique_lock l(m_lock_queue);
+
+            std::size_t size = 0;
+            for (auto& local : m_deques) {
+                size += local->m_deque.size();
+            }
+            return size;
+        }
+
+        //
+        // push in the deque of the current thread (only if called from a processing thread and not after a forced exit)
+        // (on exit when done the thread processes its deque before exiting, when it returns false the item is pushed in the shared queue)
+        //
+        inline bool push_back_local(const T& t)
+        {
+            auto [owner, index] = current_thread();
+            if (owner != this || m_lock_queue.is_exit_force()) {
+                return false;
+            }
+            push_local(*m_deques[index], t);
+            wake_parked(*m_deques[index]);
+            return true;
+        }
+
+        inline bool push_back_local(T&& t)
+        {
+            auto [owner, index] = current_thread();
+            if (owner != this || m_lock_queue.is_exit_force()) {
+                return false;
+            }
+            push_local(*m_deques[index], std::forward<T>(t));
+            wake_parked(*m_deques[index]);
+            return true;
+        }
+
+        //
+        // start threads (the number of deques is set at first start)
+        //
+        inline void start_threads(const int threads_count /* = 1 */)
+        {
+            std::unique_lock l(m_lock_queue);
+
+            if (m_deques.empty()) {
+                for (int i = 0; i < threads_count; ++i) {
+                    m_deques.push_back(std::make_unique<LocalDeque>());
+                }
+            }
+
+            const auto&                 config = m_parent_caller.config();
+            const small::config_threads config_threads{
+                .stack_size           = config.stack_size,
+                .function_thread_init = config.function_thread_init,
+                .function_thread_exit = config.function_thread_exit,
+            };
+            while (m_threads.size() < m_deques.size()) {
+                m_threads.start(config_threads, [this](std::stop_token stop_token, const int index) { thread_function(stop_token, static_cast<std::size_t>(index)); });
+            }
+        }
+
+        //
+        // how many exceptions were thrown from processing (the thread continues processing after an exception)
+        //
+        inline std::size_t count_exceptions() const { return m_threads.count_exceptions(); }
+
+        //
+        // wait
+        //
+        inline EnumLock wait()
+        {
+            m_lock_queue.signal_exit_when_done();
+            m_threads.wait();
+            return small::EnumLock::kExit;
+        }
+
+        template <typename _Rep, typename _Period>
+        inline EnumLock wait_for(const std::chrono::duration<_Rep, _Period>& __rtime)
+        {
+            using __dur    = typename std::chrono::system_clock::duration;
+            auto __reltime = std::chrono::duration_cast<__dur>(__rtime);
+            if (__reltime < __rtime) {
+                ++__reltime;
+            }
+            return wait_until(std::chrono::system_clock::now() + __reltime);
+        }
+
+        template <typename _Clock, typename _Duration>
+        inline EnumLock wait_until(const std::chrono::time_point<_Clock, _Duration>& __atime)
+        {
+            m_lock_queue.signal_exit_when_done();
+
+            return m_threads.wait_until(__atime) ? small::EnumLock::kExit : small::EnumLock::kTimeout;
+        }
+
+    private:
+        static constexpr int kInjectionBatch = 4; // how many bulks are taken at once from the shared queue
+
+        // an item in a deque (the nodes are reused, so pushing does not allocate once the threads are warm)
+        struct LocalNode
+        {
+            T          m_elem;   // item
+            LocalNode* m_next{}; // next free node
+        };
+
+        // the deque of a thread and its free nodes
+        struct LocalDeque
+        {
+            LocalDeque() = default;
+            ~LocalDeque()
+            {
+                for (auto* node : {m_free, m_free_stolen.load()}) {
+                    while (node) {
+                        delete std::exchange(node, node->m_next);
+                    }
+                }
+            }
+
+            small::work_steal_deque<LocalNode>  m_deque;         // items (the ones left are deleted by the deque)
+            LocalNode*                          m_free{};        // free nodes (used only by the owner thread)
+            alignas(64) std::atomic<LocalNode*> m_free_stolen{}; // nodes of the stolen items given back by the other threads
+
+            LocalDeque(const LocalDeque&)            = delete;
+            LocalDeque& operator=(const LocalDeque&) = delete;
+        };
+
+        // the processing thread that is running on the current thread
+        static inline std::pair<const work_steal_thread*, std::size_t>& current_thread()
+        {
+            static thread_local std::pair<const work_steal_thread*, std::size_t> current{nullptr, 0};
+            return current;
+        }
+
+        //
+        // inner thread function
+        //
+        inline void thread_function(std::stop_token stop_token, const std::size_t index)
+        {
+            // when the threads are destroyed without waiting
+            std::stop_callback on_stop(stop_token, [this]() { m_lock_queue.signal_exit_when_done(); });
+
+            current_thread() = {this, index};
+            m_parent_caller.thread_started(static_cast<int>(index));
+
+            auto&            local       = *m_deques[index];
+            const int        bulk_count  = std::max<>(m_parent_caller.config().bulk_count, 1);
+            const int        spin_count  = std::max<>(m_parent_caller.config().idle_spin_count, 0);
+            const int        yield_count = std::max<>(m_parent_caller.config().idle_yield_count, 0);
+            int              idle_count  = 0;
+            std::vector<T>   vec_elems;
+            std::minstd_rand rand_engine{static_cast<std::minstd_rand::result_type>(index + 1)};
+
+            for (;;) {
+                // a forced exit does not process the items left in the deques
+                if (m_lock_queue.is_exit_force()) {
+                    break;
+                }
+
+                // own deque first (lifo, the most recent items are still in cache)
+                if (pop_local(local, vec_elems, bulk_count)) {
+                    idle_count = 0;
+                    m_parent_caller.process_items(std::move(vec_elems));
+                    continue;
+                }
+
+                // then from the shared queue, take more than a bulk and keep the rest in own deque (so other threads can steal them)
+                // (the lock is taken only when there are items or on exit, so the idle threads do not slow down the producers)
+                auto ret = small::EnumLock::kTimeout;
+                if (m_lock_queue.size_approx() > 0 || m_lock_queue.is_exit()) {
+                    ret = m_lock_queue.wait_pop_front_for(std::chrono::nanoseconds(0), vec_elems, bulk_count * kInjectionBatch);
+                }
+                if (ret == small::EnumLock::kExit) {
+                    break;
+                } else if (ret == small::EnumLock::kElement) {
+                    idle_count = 0;
+                    keep_local(local, vec_elems, bulk_count);
+                    m_parent_caller.process_items(std::move(vec_elems));
+                    continue;
+                }
+
+                // then steal from other threads
+                if (steal(index, rand_engine, vec_elems, bulk_count)) {
+                    idle_count = 0;
+                    m_parent_caller.process_items(std::move(vec_elems));
+                    continue;
+                }
+
+                // nothing to do, try again for a while (spin then yield)
+                if (idle_count < spin_count + yield_count) {
+                    if (idle_count++ >= spin_count) {
+                        std::this_thread::yield();
+                    }
+                    continue;
+                }
+
+                // and then park on the shared queue until it has items (or exit)
+                // (counted as parked before the last steal, so a thread that pushes in its deque after that sees it and wakes it)
+                m_count_parked.fetch_add(1);
+                if (steal(index, rand_engine, vec_elems, bulk_count)) {
+                    m_count_parked.fetch_sub(1);
+                    idle_count = 0;
+                    m_parent_caller.process_items(std::move(vec_elems));
+                    continue;
+                }
+                ret = m_lock_queue.wait_pop_front(vec_elems, bulk_count * kInjectionBatch);
+                m_count_parked.fetch_sub(1);
+                if (ret == small::EnumLock::kExit) {
+                    break;
+                } else if (ret == small::EnumLock::kElement) {
+                    idle_count = 0;
+                    keep_local(local, vec_elems, bulk_count);
+                    m_parent_caller.process_items(std::move(vec_elems));
+                }
+            }
+
+            current_thread() = {nullptr, 0};
+        }
+
+        //
+        // deque items (the owner thread takes the free nodes, the nodes of the stolen items come back through a lock free list)
+        //
+        template <typename U>
+        static inline void push_local(LocalDeque& local, U&& t)
+        {
+            if (!local.m_free) {
+                local.m_free = local.m_free_stolen.exchange(nullptr, std::memory_order_acquire);
+            }
+
+            auto* node = local.m_free;
+            if (node) {
+                local.m_free = node->m_next;
+                node->m_elem = std::forward<U>(t);
+            } else {
+                node = new LocalNode{std::forward<U>(t)};
+            }
+            local.m_deque.push(node);
+        }
+
+        static inline bool pop_local(LocalDeque& local, std::vector<T>& vec_elems, const int bulk_count)
+        {
+            vec_elems.clear();
+            while (static_cast<int>(vec_elems.size()) < bulk_count) {
+                auto* node = local.m_deque.pop();
+                if (!node) {
+                    break;
+                }
+                vec_elems.push_back(std::move(node->m_elem));
+                node->m_next = local.m_free;
+                local.m_free = node;
+            }
+            return !vec_elems.empty();
+        }
+
+        static inline bool steal_local(LocalDeque& victim, std::vector<T>& vec_elems)
+        {
+            auto* node = victim.m_deque.steal();
+            if (!node) {
+                return false;
+            }
+            vec_elems.push_back(std::move(node->m_elem));
+
+            // give the node back to its owner
+            node->m_next = victim.m_free_stolen.load(std::memory_order_relaxed);
+            while (!victim.m_free_stolen.compare_exchange_weak(node->m_next, node, std::memory_order_release, std::memory_order_relaxed)) {
+            }
+            return true;
+        }
+
+        // the items over the bulk count are moved in own deque (in reverse order so they are popped in the original order)
+        inline void keep_local(LocalDeque& local, std::vector<T>& vec_elems, const int bulk_count)
+        {
+            if (static_cast<int>(vec_elems.size()) <= bulk_count) {
+                return;
+            }
+            while (static_cast<int>(vec_elems.size()) > bulk_count) {
+                push_local(local, std::move(vec_elems.back()));
+                vec_elems.pop_back();
+            }
+            wake_parked(local);
+        }
+
+        // after a push in own deque, if other threads are parked one item is moved to the shared queue to wake one of them
+        // (the push in the deque is visible before the parked count is read, see the park in thread_function)
+        inline void wake_parked(LocalDeque& local)
+        {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (m_count_parked.load(std::memory_order_relaxed) == 0) {
+                return;
+            }
+
+            auto* node = local.m_deque.pop();
+            if (!node) {
+                return;
+            }
+            // (the item is not moved if the shared queue rejects it on exit, then it is kept in own deque)
+            if (!m_lock_queue.push_back(std::move(node->m_elem))) {
+                local.m_deque.push(node);
+                return;
+            }
+            node->m_next = local.m_free;
+            local.m_free = node;
+        }
+
+        inline bool steal(const std::size_t index, std::minstd_rand& rand_engine, std::vector<T>& vec_elems, const int bulk_count)
+        {
+            vec_elems.clear();
+
+            const auto count = m_deques.size();
+            const auto start = static_cast<std::size_t>(rand_engine()) % count;
+            for (std::size_t i = 0; i < count && vec_elems.empty(); ++i) {
+                auto victim = (start + i) % count;
+                if (victim == index) {
+                    continue;
+                }
+                while (static_cast<int>(vec_elems.size()) < bulk_count && steal_local(*m_deques[victim], vec_elems)) {
+                }
+            }
+            return !vec_elems.empty();
+        }
+
+    private:
+        // some prevention
+        work_steal_thread(const work_steal_thread&)            = delete;
+        work_steal_thread(work_steal_thread&&)                 = delete;
+        work_steal_thread& operator=(const work_steal_thread&) = delete;
+        work_steal_thread& operator=(work_steal_thread&& __t)  = delete;
+
+    private:
+        //
+        // members
+        //
+        small::lock_queue<T>&                    m_lock_queue;     // shared queue (for items pushed from outside)
+        std::vector<std::unique_ptr<LocalDeque>> m_deques;        // deque for each thread
+        std::atomic<int>                         m_count_parked{}; // how many threads are parked on the shared queue
+        ParentCallerT&                           m_parent_caller;  // where items are processed
+        small::base_threads                      m_threads;        // threads (they are destroyed first)
+    };
+} // namespace small
@@ -1,12 +1,21 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <exception>
 #include <functional>
-#include <future>
+#include <string>
 #include <thread>
+#include <type_traits>
+#include <unordered_map>
 #include <vector>
 
+#include "future.h"
 #include "lock_queue_thread.h"
 #include "time_queue_thread.h"
+#include "util_thread.h"
+#include "work_steal_thread.h"
 
 // using qc = std::pair<int, std::string>;
 // ...
@@ -49,6 +58,19 @@
 // workers.emplace_back( 3, "e" );
 // workers.push_back_delay_for( std::chrono::milliseconds(300), { 4, "f" } );
 // ...
+// // keyed mode, items with same key are processed in order (one at a time) and different keys in parallel
+// workers.set_function_key( []( const qc& item ) -> std::size_t { return item.first; } );
+// ...
+// // or with the callable type known at compile time (called directly and the items can be moved)
+// auto workers4 = small::make_worker_thread<qc>( {.threads_count = 2}, []( auto& w /*this*/, std::vector<qc>&& items ) { ... } );
+// ...
+// // adaptive, between 2 and 8 threads and a bulk between 10 and 100 to keep a batch under 5ms
+// small::worker_thread<qc> workers3( {.threads_count = 2, .bulk_count = 10, .threads_max = 8, .bulk_count_max = 100, .target_batch_time = std::chrono::milliseconds(5)}, WorkerThreadFunction() );
+// std::cout << workers3.threads_active() << " " << workers3.bulk_count_active() << "\n";
+// ...
+// // light load, when a thread would be idle the item is processed directly by push_back (no enqueue and wake up)
+// small::worker_thread<qc> workers5( {.threads_count = 2, .run_inline = true}, WorkerThreadFunction() );
+// ...
 // // no more work, wait to be finished
 // auto ret = workers.wait_for( std::chrono::seconds(30) ); // auto ret = workers.wait();
 // if  ( ret ==  small::EnumLock:: kTimeout ) {
@@ -57,17 +79,59 @@
 // }
 // //
 
+namespace small::workerimpl {
+    //
+    // how many processing functions of any worker_thread (of any type) are running on this thread
+    // (not inside the class template, where each instantiation would have its own counter)
+    //
+    inline int& processing_depth()
+    {
+        static thread_local int depth = 0;
+        return depth;
+    }
+} // namespace small::workerimpl
+
 namespace small {
+    //
+    // how the items are distributed to the threads
+    //
+    enum class EnumWorkerThreadBackend : unsigned int
+    {
+        kSharedQueue = 0, // all threads take from one shared queue
+        kWorkStealing,    // each thread has its own deque (items pushed from processing go there) and idle threads steal from the others
+    };
+
     //
     // small class for worker threads
     //
     struct config_worker_thread
     {
-        int threads_count{1}; // how many threads for processing
-        int bulk_count{1};    // how many objects are processed at once
+        int                       threads_count{1};                               // how many threads for processing
+        int                       bulk_count{1};                                  // how many objects are processed at once
+        EnumWorkerThreadBackend   backend{EnumWorkerThreadBackend::kSharedQueue}; // how the items are distributed to the threads
+        int                       idle_spin_count{0};                             // when there are no items how many times to check again (busy spin) before yielding
+        int                       idle_yield_count{0};                            // after spinning how many times to yield and check again before blocking on the queue
+        std::chrono::microseconds max_batch_delay{0};                             // if the bulk is not full wait for more items, but no more than this (0 = process what is available)
+        int                       threads_max{0};                                 // if more than threads_count, threads are activated when items accumulate and parked when idle (shared queue)
+        std::chrono::milliseconds park_idle_time{100};                            // how long a thread over threads_count can be idle before it is parked
+        int                       bulk_count_max{0};                              // if more than bulk_count, the bulk is adjusted between bulk_count and this (shared queue)
+        std::chrono::microseconds target_batch_time{10'000};                      // the bulk is halved when processing takes longer than this and doubled when it takes less than half
+        std::string               thread_name{};                                  // name of the threads (name-index), for debugging and profiling
+        std::vector<int>          cpus{};                                         // pin the threads to these cpus
+        int                       numa_node{-1};                                  // if cpus are not set, pin the threads to the cpus of this numa node
+        bool                      pin_each_thread{false};                         // pin each thread to only one of the cpus (round robin)
+        std::size_t               stack_size{0};                                  // stack size of the processing threads (0 means default, only on posix)
+        std::function<void(int)>  function_thread_init{};                         // called on each processing thread (with its index) before processing (thread local setup, tracing)
+        std::function<void(int)>  function_thread_exit{};                         // called on each processing thread (with its index) when it exits
+        bool                      run_inline{false};                              // push_back processes the item on the calling thread when fewer items than active threads are queued or processing (shared queue, not keyed)
     };
 
-    template <typename T>
+    //
+    // when FunctionT is void the processing function is stored in a std::function (with the extra parameters bound)
+    // otherwise FunctionT is the type of the callable which is called directly as function(worker_thread&, std::vector<T>&&)
+    // (see make_worker_thread)
+    //
+    template <typename T, typename FunctionT = void>
     class worker_thread
     {
     public:
@@ -75,6 +139,7 @@ namespace small {
         // worker_thread
         //
         template <typename _Callable, typename... Args>
+            requires std::is_void_v<FunctionT>
         worker_thread(const config_worker_thread& config, _Callable function, Args... extra_parameters)
             : m_config(config),
               m_function_processing(std::bind(std::forward<_Callable>(function), std::ref(*this), std::placeholders::_1 /*item*/, std::forward<Args>(extra_parameters)...))
@@ -85,18 +150,30 @@ namespace small {
             }
         }
 
+        template <typename _Callable>
+            requires(!std::is_void_v<FunctionT>)
+        worker_thread(const config_worker_thread& config, _Callable&& function)
+            : m_config(config),
+              m_function_processing(std::forward<_Callable>(function))
+        {
+            // auto start threads if count > 0 otherwise threads should be manually started
+            if (config.threads_count) {
+                start_threads(config.threads_count);
+            }
+        }
+
         ~worker_thread()
         {
             wait();
         }
 
         // clang-format off
-        // size of active items
-        inline size_t   size        () { return m_queue_items.queue().size();  }
+        // size of active items (including the ones waiting for their key)
+        inline size_t   size        () { std::unique_lock l(m_queue_items.queue()); return m_queue_items.queue().size() + m_count_keys_pending + m_work_items.size_local(); }
         // empty
         inline bool     empty       () { return size() == 0; }
         // clear
-        inline void     clear       () { m_queue_items.queue().clear(); }
+        inline void     clear       () { std::unique_lock l(m_queue_items.queue()); if (is_run_inline()) { m_count_in_flight -= static_cast<int>(m_queue_items.queue().size()); } m_queue_items.queue().clear(); m_keys_pending.clear(); m_count_keys_pending = 0; }
         
         // size of delayed items
         inline size_t   size_delayed() { return m_delayed_items.queue().size();  }
@@ -106,6 +183,27 @@ namespace small {
         inline void     clear_delayed() { m_delayed_items.queue().clear(); }
         // clang-format on
 
+        //
+        // current threads processing and bulk count (they are adjusted when threads_max or bulk_count_max are set)
+        //
+        inline int threads_active()
+        {
+            return m_config.backend == EnumWorkerThreadBackend::kWorkStealing ? m_config.threads_count : m_queue_items.threads_active();
+        }
+
+        inline int bulk_count_active()
+        {
+            return m_config.backend == EnumWorkerThreadBackend::kWorkStealing ? m_config.bulk_count : m_queue_items.bulk_count();
+        }
+
+        //
+        // how many exceptions were thrown from the processing function (the thread that caught it continues processing)
+        //
+        inline std::size_t count_exceptions() const
+        {
+            return m_queue_items.count_exceptions() + m_work_items.count_exceptions() + m_count_inline_exceptions.load();
+        }
+
         // clang-format off
         // use it as locker (std::unique_lock<small:worker_thread<T>> m...)
         inline void     lock        () { m_queue_items.queue().lock(); }
@@ -127,35 +225,97 @@ namespace small {
             }
 
             // create threads and save their future results
-            m_queue_items.start_threads(m_config.threads_count);
+            if (m_config.backend == EnumWorkerThreadBackend::kWorkStealing) {
+                m_work_items.start_threads(m_config.threads_count);
+            } else {
+                m_queue_items.start_threads(m_config.threads_count);
+            }
 
             // create thread for time queue
             m_delayed_items.start_threads();
         }
 
+        //
+        // keyed mode (must be set before pushing items)
+        // items with the same key are processed in order (one at a time) and items with different keys in parallel
+        //
+        template <typename _Callable>
+        inline void set_function_key(_Callable function_key)
+        {
+            std::unique_lock mlock(m_queue_items.queue());
+            m_function_key = function_key;
+        }
+
         //
         // add items to be processed
         // push_back
         //
         inline std::size_t push_back(const T& t)
         {
+            if (m_function_key) {
+                return push_back_keyed(t);
+            }
+            if (is_run_inline()) {
+                return push_back_inline(t);
+            }
+            if (m_config.backend == EnumWorkerThreadBackend::kWorkStealing && m_work_items.push_back_local(t)) {
+                return 1;
+            }
             return m_queue_items.queue().push_back(t);
         }
 
         inline std::size_t push_back(const std::vector<T>& items)
         {
-            return m_queue_items.queue().push_back(items);
+            if (m_function_key) {
+                std::size_t count = 0;
+                for (auto& t : items) {
+                    count += push_back_keyed(t);
+                }
+                return count;
+            }
+            return push_back_counted(items.size(), [&]() { return m_queue_items.queue().push_back(items); });
         }
 
         // push back with move semantics
         inline std::size_t push_back(T&& t)
         {
+            if (m_function_key) {
+                return push_back_keyed(std::forward<T>(t));
+            }
+            if (is_run_inline()) {
+                return push_back_inline(std::forward<T>(t));
+            }
+            if (m_config.backend == EnumWorkerThreadBackend::kWorkStealing && m_work_items.push_back_local(std::forward<T>(t))) {
+                return 1;
+            }
             return m_queue_items.queue().push_back(std::forward<T>(t));
         }
 
         inline std::size_t push_back(std::vector<T>&& items)
         {
-            return m_queue_items.queue().push_back(std::forward<std::vector<T>>(items));
+            if (m_function_key) {
+                std::size_t count = 0;
+                for (auto& t : items) {
+                    count += push_back_keyed(std::move(t));
+                }
+                return count;
+            }
+            return push_back_counted(items.size(), [&]() { return m_queue_items.queue().push_back(std::forward<std::vector<T>>(items)); });
+        }
+
+        //
+        // submit a request and get a future for its result (T must be small::submit_item<RequestT, R>
+        // and the processing function sets the result with item.m_promise.set_value(...))
+        // if the item cannot be pushed the future has a broken promise exception
+        //
+        template <typename U = T>
+            requires small::is_submit_item_v<U>
+        inline small::future<typename U::ResultType> submit(typename U::RequestType request)
+        {
+            U    item{.m_request = std::move(request), .m_promise = small::promise<typename U::ResultType>()};
+            auto future = item.m_promise.get_future();
+            push_back(std::move(item));
+            return future;
         }
 
         //
@@ -214,7 +374,10 @@ namespace small {
         template <typename... _Args>
         inline std::size_t emplace_back(_Args&&... __args)
         {
-            return m_queue_items.queue().emplace_back(std::forward<_Args>(__args)...);
+            if (m_function_key) {
+                return push_back_keyed(T(std::forward<_Args>(__args)...));
+            }
+            return push_back_counted(1, [&]() { return m_queue_items.queue().emplace_back(std::forward<_Args>(__args)...); });
         }
 
         // emplace_back
@@ -252,6 +415,7 @@ namespace small {
 
             // only now can signal exit when done for queue items (when no more delayed items can be pushed)
             m_queue_items.wait();
+            m_work_items.wait();
 
             return EnumLock::kExit;
         }
@@ -284,6 +448,10 @@ namespace small {
             if (status == small::EnumLock::kTimeout) {
                 return small::EnumLock::kTimeout;
             }
+            status = m_work_items.wait_until(__atime);
+            if (status == small::EnumLock::kTimeout) {
+                return small::EnumLock::kTimeout;
+            }
 
             return EnumLock::kExit;
         }
@@ -299,27 +467,246 @@ namespace small {
         //
         // inner thread function for active items
         //
-        friend small::lock_queue_thread<T, small::worker_thread<T>>;
-        friend small::time_queue_thread<T, small::worker_thread<T>>;
+        friend small::lock_queue_thread<T, worker_thread>;
+        friend small::time_queue_thread<T, worker_thread>;
+        friend small::work_steal_thread<T, worker_thread>;
 
         inline config_worker_thread& config()
         {
             return m_config;
         }
 
+        // name and pin the processing threads
+        inline void thread_started(const int index)
+        {
+            if (!m_config.thread_name.empty()) {
+                small::set_thread_name(m_config.thread_name + "-" + std::to_string(index));
+            }
+
+            auto cpus = small::thread_cpus(m_config.cpus, m_config.numa_node);
+            if (cpus.empty()) {
+                return;
+            }
+            if (m_config.pin_each_thread) {
+                cpus = {cpus[static_cast<std::size_t>(index) % cpus.size()]};
+            }
+            small::set_thread_affinity(cpus);
+        }
+
+        inline void delayed_thread_started()
+        {
+            if (!m_config.thread_name.empty()) {
+                small::set_thread_name(m_config.thread_name + "-delay");
+            }
+        }
+
         // callback for queue_items
         inline void process_items(std::vector<T>&& items)
         {
-            m_function_processing(std::forward<std::vector<T>>(items)); // bind the std::placeholders::_1
+            ProcessingScope scope(*this, is_run_inline() ? static_cast<int>(items.size()) : 0);
+
+            if (!m_function_key) {
+                call_function_processing(std::forward<std::vector<T>>(items));
+                return;
+            }
+
+            // in keyed mode the same thread continues with the next items of the processed keys
+            // (the keys are taken before processing because the items can be moved by the processing function)
+            // if the processing throws, the next items of the keys are still processed (or the keys would never be released)
+            // and the first exception is thrown after that
+            std::vector<std::size_t> keys;
+            std::exception_ptr       exception;
+            for (auto vec_items = std::move(items); !vec_items.empty(); vec_items = get_next_keyed_items(keys)) {
+                keys.clear();
+                for (auto& t : vec_items) {
+                    keys.push_back(m_function_key(t));
+                }
+                try {
+                    call_function_processing(std::move(vec_items));
+                } catch (...) {
+                    if (!exception) {
+                        exception = std::current_exception();
+                    }
+                }
+            }
+            if (exception) {
+                std::rethrow_exception(exception);
+            }
+        }
+
+        inline void call_function_processing(std::vector<T>&& items)
+        {
+            if constexpr (std::is_void_v<FunctionT>) {
+                m_function_processing(items); // bind the std::placeholders::_1
+            } else {
+                m_function_processing(*this, std::forward<std::vector<T>>(items));
+            }
+        }
+
+        //
+        // run inline mode, the items queued or processing are counted and when there are fewer than the active threads
+        // (one of them would be idle) the item is processed on the pushing thread, which saves the enqueue and the wake up
+        // (the items pushed from inside a processing function are always queued, so there is no recursion)
+        //
+        inline bool is_run_inline() const
+        {
+            return m_config.run_inline && m_config.backend == EnumWorkerThreadBackend::kSharedQueue && !m_function_key;
         }
 
+        template <typename U>
+        inline std::size_t push_back_inline(U&& t)
+        {
+            if (!acquire_inline_slot()) {
+                return push_back_counted(1, [&]() { return m_queue_items.queue().push_back(std::forward<U>(t)); });
+            }
+
+            std::vector<T> items;
+            items.push_back(std::forward<U>(t));
+            try {
+                process_items(std::move(items)); // releases the slot
+            } catch (...) {
+                ++m_count_inline_exceptions;
+            }
+            return 1;
+        }
+
+        inline bool acquire_inline_slot()
+        {
+            if (processing_depth() > 0 || m_queue_items.queue().is_exit()) {
+                return false;
+            }
+
+            const int threads   = m_queue_items.threads_active();
+            int       in_flight = m_count_in_flight.load(std::memory_order_relaxed);
+            do {
+                if (in_flight >= threads) {
+                    return false;
+                }
+            } while (!m_count_in_flight.compare_exchange_weak(in_flight, in_flight + 1, std::memory_order_acq_rel));
+            return true;
+        }
+
+        // the items are counted before they are pushed so a processing thread never sees them uncounted
+        template <typename _Callable>
+        inline std::size_t push_back_counted(const std::size_t count, _Callable push)
+        {
+            if (!is_run_inline()) {
+                return push();
+            }
+
+            m_count_in_flight += static_cast<int>(count);
+            auto ret = push();
+            if (ret < count) {
+                m_count_in_flight -= static_cast<int>(count - ret);
+            }
+            return ret;
+        }
+
+        // how many processing functions are running on this thread (for any worker_thread)
+        static inline int& processing_depth()
+        {
+            return small::workerimpl::processing_depth();
+        }
+
+        // marks the thread as processing and releases the counted items at the end (even if the processing throws)
+        struct ProcessingScope
+        {
+            ProcessingScope(worker_thread& worker, const int count)
+                : m_worker(worker),
+                  m_count(count)
+            {
+                ++processing_depth();
+            }
+            ~ProcessingScope()
+            {
+                --processing_depth();
+                if (m_count) {
+                    m_worker.m_count_in_flight -= m_count;
+                }
+            }
+
+            worker_thread& m_worker;
+            int            m_count;
+        };
+
+        //
+        // keyed mode, the queue contains at most one item for each key,
+        // the other items for that key wait until the previous one is processed
+        //
+        template <typename U>
+        inline std::size_t push_back_keyed(U&& t)
+        {
+            std::unique_lock mlock(m_queue_items.queue());
+            if (m_queue_items.queue().is_exit()) {
+                return 0;
+            }
+
+            auto [it_k, inserted] = m_keys_pending.try_emplace(m_function_key(t));
+            if (!inserted) {
+                // key is already in queue or processing
+                it_k->second.push_back(std::forward<U>(t));
+                ++m_count_keys_pending;
+                return 1;
+            }
+
+            auto ret = m_queue_items.queue().push_back(std::forward<U>(t));
+            if (!ret) {
+                m_keys_pending.erase(it_k);
+            }
+            return ret;
+        }
+
+        inline std::vector<T> get_next_keyed_items(const std::vector<std::size_t>& processed_keys)
+        {
+            std::unique_lock mlock(m_queue_items.queue());
+
+            std::vector<T> next_items;
+            for (auto& key : processed_keys) {
+                auto it_k = m_keys_pending.find(key);
+                if (it_k == m_keys_pending.end()) {
+                    continue;
+                }
+                if (it_k->second.empty()) {
+                    // key is released
+                    m_keys_pending.erase(it_k);
+                    continue;
+                }
+                next_items.push_back(std::move(it_k->second.front()));
+                it_k->second.pop_front();
+                --m_count_keys_pending;
+            }
+            return next_items;
+        }
+
+    private:
+        // processing function (std::function or the callable itself)
+        using FunctionProcessing = std::conditional_t<std::is_void_v<FunctionT>, std::function<void(const std::vector<T>&)>, FunctionT>;
+
     private:
         //
         // members
         //
-        config_worker_thread                                 m_config;                // config
-        small::lock_queue_thread<T, small::worker_thread<T>> m_queue_items{*this};    // queue of items
-        small::time_queue_thread<T, small::worker_thread<T>> m_delayed_items{*this};  // queue of delayed items
-        std::function<void(const std::vector<T>&)>           m_function_processing{}; // processing Function
+        config_worker_thread                           m_config;                                   // config
+        small::lock_queue_thread<T, worker_thread>     m_queue_items{*this};                       // queue of items
+        small::time_queue_thread<T, worker_thread>     m_delayed_items{*this};                     // queue of delayed items
+        small::work_steal_thread<T, worker_thread>     m_work_items{*this, m_queue_items.queue()}; // threads for work stealing (the queue of items is the shared queue)
+        FunctionProcessing                             m_function_processing{};                    // processing Function
+        std::function<std::size_t(const T&)>           m_function_key{};                           // key for keyed mode (items with same key are processed in order)
+        std::unordered_map<std::size_t, std::deque<T>> m_keys_pending{};                           // keys in queue or processing and their items waiting
+        std::size_t                                    m_count_keys_pending{};                     // how many items are waiting for their key
+        std::atomic<int>                               m_count_in_flight{0};                       // items queued or processing (only in run inline mode)
+        std::atomic<std::size_t>                       m_count_inline_exceptions{0};               // exceptions thrown when processing inline
     };
+
+    //
+    // create a worker_thread that calls the function directly (no std::function, no bind)
+    // and passes the items as std::vector<T>&& so they can be moved
+    //
+    // auto workers = small::make_worker_thread<int>({.threads_count = 2}, [](auto& w /*this*/, std::vector<int>&& items) { ... });
+    //
+    template <typename T, typename _Callable>
+    inline worker_thread<T, std::decay_t<_Callable>> make_worker_thread(const config_worker_thread& config, _Callable&& function)
+    {
+        return worker_thread<T, std::decay_t<_Callable>>(config, std::forward<_Callable>(function));
+    }
 } // namespace small
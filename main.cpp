@@ -7,6 +7,7 @@
 #include "examples/examples_jobs_engine.h"
 #include "examples/examples_lock_queue.h"
 #include "examples/examples_lru_cache.h"
+#include "examples/examples_pipeline.h"
 #include "examples/examples_prio_queue.h"
 #include "examples/examples_spinlock.h"
 #include "examples/examples_stack_string.h"
@@ -32,13 +33,38 @@ int main()
     examples::lock_queue::Example1();
     examples::time_queue::Example1();
     examples::prio_queue::Example1();
+    examples::prio_queue::Example2_Perf();
+    examples::prio_queue::Example3_Perf();
+    examples::prio_queue::Example4_Perf();
     examples::lru_cache::Example1();
 
     examples::worker_thread::Example1();
     examples::worker_thread::Example2();
     examples::worker_thread::Example3_Perf();
+    examples::worker_thread::Example4_Perf();
+    examples::worker_thread::Example5_Perf();
+    examples::worker_thread::Example6_Perf();
+    examples::worker_thread::Example7_Perf();
+    examples::worker_thread::Example8_Perf();
+    examples::worker_thread::Example9_Perf();
+    examples::worker_thread::Example10_Perf();
+    examples::worker_thread::Example11_Perf();
+
+    examples::pipeline::Example1();
+    examples::pipeline::Example2_Perf();
 
     examples::jobs_engine::Example1();
+    examples::jobs_engine::Example2_Perf();
+    examples::jobs_engine::Example3_Perf();
+    examples::jobs_engine::Example4_Perf();
+    examples::jobs_engine::Example5_Perf();
+    examples::jobs_engine::Example6_Perf();
+    examples::jobs_engine::Example7_Perf();
+    examples::jobs_engine::Example8_Perf();
+    examples::jobs_engine::Example9_Perf();
+    examples::jobs_engine::Example10_Perf();
+    examples::jobs_engine::Example11_Perf();
+    examples::jobs_engine::Example12_Perf();
 
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,125 @@
+#include "test_common.h"
+
+#include "../include/future.h"
+#include "../include/util.h"
+
+namespace {
+    class FutureTest : public testing::Test
+    {
+    protected:
+        FutureTest() = default;
+
+        void SetUp() override
+        {
+            // setup before test
+        }
+        void TearDown() override
+        {
+            // cleanup after test
+        }
+    };
+
+    //
+    // future
+    //
+    TEST_F(FutureTest, Future_Operations)
+    {
+        small::promise<int> p;
+        auto                f = p.get_future();
+        ASSERT_TRUE(f.valid());
+        ASSERT_FALSE(f.is_ready());
+
+        // the future can be taken only once
+        auto f2 = p.get_future();
+        ASSERT_FALSE(f2.valid());
+
+        // timeout
+        ASSERT_EQ(f.wait_for(std::chrono::milliseconds(10)), std::future_status::timeout);
+
+        // set from other thread
+        auto thread = std::jthread([](small::promise<int> _p) {
+            small::sleep(50);
+            _p.set_value(5);
+        },
+                                   std::move(p));
+
+        ASSERT_EQ(f.get(), 5);
+        ASSERT_TRUE(f.is_ready());
+    }
+
+    TEST_F(FutureTest, Future_Exception)
+    {
+        small::promise<int> p;
+        auto                f = p.get_future();
+
+        p.set_exception(std::make_exception_ptr(std::runtime_error("error")));
+        ASSERT_THROW(f.get(), std::runtime_error);
+
+        // destroyed without value
+        small::future<std::string> f_broken;
+        {
+            small::promise<std::string> p_broken;
+            f_broken = p_broken.get_future();
+        }
+        ASSERT_THROW(f_broken.get(), std::future_error);
+    }
+
+    TEST_F(FutureTest, Future_Then)
+    {
+        std::vector<std::thread::id> threads_ids;
+        std::vector<int>             values;
+
+        // continuation set before the value runs on the thread that sets the value
+        small::promise<int> p;
+        p.get_future().then([&](small::future<int>& ready) {
+            values.push_back(ready.get());
+            threads_ids.push_back(std::this_thread::get_id());
+        });
+
+        auto thread    = std::jthread([](const small::promise<int>& _p) { _p.set_value(1); }, std::cref(p));
+        auto thread_id = thread.get_id();
+        thread.join();
+
+        // continuation set after the value runs on this thread
+        small::promise<int> p2;
+        auto                f2 = p2.get_future();
+        p2.set_value(2);
+        std::move(f2).then([&](small::future<int>& ready) {
+            values.push_back(ready.get());
+            threads_ids.push_back(std::this_thread::get_id());
+        });
+
+        ASSERT_EQ(values, std::vector<int>({1, 2}));
+        ASSERT_EQ(threads_ids, std::vector<std::thread::id>({thread_id, std::this_thread::get_id()}));
+    }
+
+    TEST_F(FutureTest, Future_Void)
+    {
+        small::promise<void> p;
+        auto                 f = p.get_future();
+        ASSERT_FALSE(f.is_ready());
+
+        int count_then = 0;
+
+        small::promise<void> p_then;
+        p_then.get_future().then([&count_then](small::future<void>& ready) {
+            ready.get();
+            ++count_then;
+        });
+
+        p.set_value();
+        p_then.set_value();
+        ASSERT_TRUE(f.is_ready());
+        ASSERT_NO_THROW(f.get());
+        ASSERT_EQ(count_then, 1);
+
+        // destroyed without value
+        small::future<void> f_broken;
+        {
+            small::promise<void> p_broken;
+            f_broken = p_broken.get_future();
+        }
+        ASSERT_THROW(f_broken.get(), std::future_error);
+    }
+
+} // namespace
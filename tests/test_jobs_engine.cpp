@@ -113,6 +113,157 @@ namespace {
         ASSERT_GE(elapsed, 300 - 1);
     }
 
+    //
+    // jobs added from more threads while the engine is locked (the jobs are kept in shards, the lock is only for user transactions)
+    //
+    TEST_F(JobsEngineTest, Jobs_Registry_Concurrent)
+    {
+        JobsEng::JobsConfig config = m_default_config;
+        JobsEng             jobs(config);
+
+        std::atomic<int> processing_count{0};
+
+        // setup
+        jobs.config_default_function_processing([&processing_count](auto& /*this jobs engine*/, const auto& jobs_items, auto& /* jobs_config */) {
+            processing_count += static_cast<int>(jobs_items.size());
+        });
+        jobs.start_threads(2);
+
+        {
+            std::unique_lock l(jobs);
+
+            // each thread adds parents with 2 children
+            std::vector<std::jthread> producers;
+            for (int t = 0; t < 4; ++t) {
+                producers.emplace_back([&jobs, t]() {
+                    for (int i = 0; i < 50; ++i) {
+                        // (the children are started after both are linked, otherwise the parent may finish with only one child)
+                        JobsEng::JobsID parent_jobs_id{};
+                        JobsEng::JobsID child_jobs_id1{};
+                        JobsEng::JobsID child_jobs_id2{};
+                        jobs.queue().push_back(JobsType::kJobsSettings, {JobsType::kJobsSettings, t * 100 + i, "parent"}, &parent_jobs_id);
+                        jobs.queue().push_back_child(parent_jobs_id, JobsType::kJobsApiGet, {JobsType::kJobsApiGet, i, "child"}, &child_jobs_id1);
+                        jobs.queue().push_back_child(parent_jobs_id, JobsType::kJobsDatabase, {JobsType::kJobsDatabase, i, "child"}, &child_jobs_id2);
+                        jobs.queue().jobs_start(small::EnumPriorities::kNormal, child_jobs_id1);
+                        jobs.queue().jobs_start(small::EnumPriorities::kNormal, child_jobs_id2);
+                        jobs.queue().jobs_start(small::EnumPriorities::kNormal, parent_jobs_id);
+                    }
+                });
+            }
+            producers.clear(); // join
+
+            // processed while the lock is held
+            while (processing_count.load() < 4 * 50 * 3) {
+                small::sleep(1);
+            }
+        }
+
+        // wait to finish (the parents are deleted with their children)
+        auto retw = jobs.wait();
+        ASSERT_EQ(retw, small::EnumLock::kExit);
+        ASSERT_EQ(jobs.size(), 0);
+        ASSERT_EQ(processing_count.load(), 4 * 50 * 3);
+    }
+
+    TEST_F(JobsEngineTest, Jobs_Item_Pool)
+    {
+        JobsEng::JobsConfig config = m_default_config;
+        JobsEng             jobs(config);
+
+        std::atomic<int> processing_count{0};
+
+        // setup
+        jobs.config_default_function_processing([&processing_count](auto& /*this jobs engine*/, const auto& jobs_items, auto& /* jobs_config */) {
+            processing_count += static_cast<int>(jobs_items.size());
+        });
+
+        // items from the pool
+        JobsEng::JobsID parent_jobs_id{};
+        auto            retq = jobs.queue().push_back(JobsEng::JobsQueue::jobs_item_create(JobsType::kJobsSettings, WebRequest{JobsType::kJobsSettings, 1, "parent"}), &parent_jobs_id);
+        ASSERT_EQ(retq, 1);
+
+        // more children than the inline ids
+        std::vector<JobsEng::JobsID> children_jobs_ids;
+        for (int i = 0; i < 6; ++i) {
+            JobsEng::JobsID child_jobs_id{};
+            retq = jobs.queue().push_back_child(parent_jobs_id, JobsType::kJobsApiGet, {JobsType::kJobsApiGet, 10 + i, "child"}, &child_jobs_id);
+            ASSERT_EQ(retq, 1);
+            children_jobs_ids.push_back(child_jobs_id);
+        }
+
+        auto parent = jobs.jobs_get(parent_jobs_id);
+        ASSERT_TRUE(parent);
+        auto children_ids = parent->get_children();
+        ASSERT_EQ(children_ids.size(), 6);
+        ASSERT_EQ(children_ids, children_jobs_ids);
+
+        auto children = jobs.jobs_get(children_ids);
+        ASSERT_EQ(children.size(), 6);
+        for (std::size_t i = 0; i < children.size(); ++i) {
+            ASSERT_EQ(children[i]->m_id, children_jobs_ids[i]);
+            ASSERT_EQ(children[i]->get_parents().size(), 1);
+            ASSERT_EQ(children[i]->get_parents()[0], parent_jobs_id);
+        }
+        children.clear();
+        parent.reset();
+
+        // start all
+        for (auto& child_jobs_id : children_jobs_ids) {
+            jobs.queue().jobs_start(small::EnumPriorities::kNormal, child_jobs_id);
+        }
+        jobs.queue().jobs_start(small::EnumPriorities::kNormal, parent_jobs_id);
+        jobs.start_threads(2);
+
+        // wait to finish
+        auto retw = jobs.wait();
+        ASSERT_EQ(retw, small::EnumLock::kExit);
+        ASSERT_EQ(jobs.size(), 0);
+        ASSERT_EQ(processing_count.load(), 7);
+    }
+
+    TEST_F(JobsEngineTest, Jobs_Slots_Stale_Ids)
+    {
+        JobsEng::JobsConfig config = m_default_config;
+        JobsEng             jobs(config);
+
+        // push (no threads)
+        JobsEng::JobsID jobs_id1{};
+        auto            retq = jobs.queue().push_back(JobsType::kJobsSettings, {JobsType::kJobsSettings, 1, "settings1"}, &jobs_id1);
+        ASSERT_EQ(retq, 1);
+        ASSERT_NE(jobs_id1, 0);
+        ASSERT_TRUE(jobs.jobs_get(jobs_id1));
+
+        // cancel will erase it
+        auto retc = jobs.state().jobs_cancelled(jobs_id1);
+        ASSERT_TRUE(retc);
+        ASSERT_FALSE(jobs.jobs_get(jobs_id1));
+        ASSERT_EQ(jobs.size(), 0);
+
+        // the slot is reused with a new id
+        JobsEng::JobsID jobs_id2{};
+        retq = jobs.queue().push_back(JobsType::kJobsSettings, {JobsType::kJobsSettings, 2, "settings2"}, &jobs_id2);
+        ASSERT_EQ(retq, 1);
+        ASSERT_NE(jobs_id2, jobs_id1);
+        ASSERT_EQ(jobs_id2 & 0xFFFF'FFFF, jobs_id1 & 0xFFFF'FFFF);
+
+        // the old id is stale
+        ASSERT_FALSE(jobs.jobs_get(jobs_id1));
+        ASSERT_FALSE(jobs.state().jobs_cancelled(jobs_id1));
+        auto jobs_item = jobs.jobs_get(jobs_id2);
+        ASSERT_TRUE(jobs_item);
+        ASSERT_EQ(std::get<1>(jobs_item->m_request), 2);
+
+        // unknown ids
+        ASSERT_FALSE(jobs.jobs_get(0));
+        ASSERT_FALSE(jobs.jobs_get(0xFFFF'FFFF'FFFF'FFFF));
+        ASSERT_EQ(jobs.jobs_get(std::vector<JobsEng::JobsID>{jobs_id1, jobs_id2, 12345}).size(), 1);
+
+        // cleanup (there are no threads to finish it)
+        jobs_item.reset();
+        ASSERT_TRUE(jobs.state().jobs_cancelled(jobs_id2));
+        ASSERT_EQ(jobs.size(), 0);
+    }
+
     //
     // operations with default processing function
     //
@@ -175,6 +326,429 @@ namespace {
     //
     // operations with default processing function and throtelling (sleep between requests)
     //
+    TEST_F(JobsEngineTest, Jobs_Bulk_Split_By_Type)
+    {
+        JobsEng::JobsConfig config = m_default_config;
+        config.m_groups[JobsGroupType::kJobsGroupApi].m_bulk_count = 10;
+        JobsEng jobs(config);
+
+        std::vector<std::pair<JobsType, std::vector<WebID>>> calls;
+
+        // setup
+        jobs.config_default_function_processing([&calls](auto& /*this jobs engine*/, const auto& jobs_items, auto& /* jobs_config */) {
+            std::vector<WebID> web_ids;
+            for (auto& item : jobs_items) {
+                web_ids.push_back(std::get<1>(item->m_request));
+            }
+            calls.emplace_back(jobs_items.front()->m_type, web_ids);
+        });
+
+        // push mixed types in the same group
+        jobs.queue().push_back_and_start(small::EnumPriorities::kNormal, JobsType::kJobsApiGet, {JobsType::kJobsApiGet, 1, ""});
+        jobs.queue().push_back_and_start(small::EnumPriorities::kNormal, JobsType::kJobsApiPost, {JobsType::kJobsApiPost, 2, ""});
+        jobs.queue().push_back_and_start(small::EnumPriorities::kNormal, JobsType::kJobsApiGet, {JobsType::kJobsApiGet, 3, ""});
+        jobs.queue().push_back_and_start(small::EnumPriorities::kNormal, JobsType::kJobsApiDelete, {JobsType::kJobsApiDelete, 4, ""});
+        jobs.queue().push_back_and_start(small::EnumPriorities::kNormal, JobsType::kJobsApiPost, {JobsType::kJobsApiPost, 5, ""});
+
+        jobs.start_threads(1);
+
+        // wait to finish
+        auto retw = jobs.wait();
+        ASSERT_EQ(retw, small::EnumLock::kExit);
+        ASSERT_EQ(jobs.size(), 0);
+
+        // one call for each type (in the order of the first job of each type) and the jobs keep their order
+        ASSERT_EQ(calls.size(), 3);
+        ASSERT_EQ(calls[0].first, JobsType::kJobsApiGet);
+        ASSERT_EQ(calls[0].second, std::vector<WebID>({1, 3}));
+        ASSERT_EQ(calls[1].first, JobsType::kJobsApiPost);
+        ASSERT_EQ(calls[1].second, std::vector<WebID>({2, 5}));
+        ASSERT_EQ(calls[2].first, JobsType::kJobsApiDelete);
+        ASSERT_EQ(calls[2].second, std::vector<WebID>({4}));
+    }
+
+    TEST_F(JobsEngineTest, Jobs_Bulk_Submit)
+    {
+        JobsEng::JobsConfig config = m_default_config;
+        config.m_types[JobsType::kJobsDatabase].m_timeout = std::chrono::hours(1);
+        JobsEng jobs(config);
+
+        std::vector<WebID> processed;
+
+        // setup
+        jobs.config_default_function_processing([&processed](auto& /*this jobs engine*/, const auto& jobs_items, auto& /* jobs_config */) {
+            for (auto& item : jobs_items) {
+                processed.push_back(std::get<1>(item->m_request));
+            }
+        });
+
+        // jobs of many groups (and a null item that is skipped)
+        std::vector<std::shared_ptr<JobsEng::JobsItem>> jobs_items;
+        jobs_items.push_back(JobsEng::JobsQueue::jobs_item_create(JobsType::kJobsSettings, WebRequest{JobsType::kJobsSettings, 1, ""}));
+        jobs_items.push_back(JobsEng::JobsQueue::jobs_item_create(JobsType::kJobsApiGet, WebRequest{JobsType::kJobsApiGet, 2, ""}));
+        jobs_items.push_back(nullptr);
+        jobs_items.push_back(JobsEng::JobsQueue::jobs_item_create(JobsType::kJobsDatabase, WebRequest{JobsType::kJobsDatabase, 3, ""}));
+        jobs_items.push_back(JobsEng::JobsQueue::jobs_item_create(JobsType::kJobsApiPost, WebRequest{JobsType::kJobsApiPost, 4, ""}));
+        jobs_items.push_back(JobsEng::JobsQueue::jobs_item_create(JobsType::kJobsSettings, WebRequest{JobsType::kJobsSettings, 5, ""}));
+
+        std::vector<JobsEng::JobsID> jobs_ids;
+        auto                         ret = jobs.queue().push_back_and_start(small::EnumPriorities::kNormal, jobs_items, &jobs_ids);
+        ASSERT_EQ(ret, 5);
+        ASSERT_EQ(jobs_ids.size(), 5);
+        ASSERT_EQ(jobs_ids[0], jobs_items[0]->m_id);
+        ASSERT_EQ(jobs_ids[2], jobs_items[3]->m_id);
+        ASSERT_EQ(jobs_ids[4], jobs_items[5]->m_id);
+        ASSERT_EQ(jobs.size(), 5);
+
+        // children added at once
+        JobsEng::JobsID parent_jobs_id{};
+        jobs.queue().push_back(JobsType::kJobsSettings, {JobsType::kJobsSettings, 6, ""}, &parent_jobs_id);
+
+        std::vector<std::shared_ptr<JobsEng::JobsItem>> children_jobs_items;
+        children_jobs_items.push_back(JobsEng::JobsQueue::jobs_item_create(JobsType::kJobsApiGet, WebRequest{JobsType::kJobsApiGet, 7, ""}));
+        children_jobs_items.push_back(JobsEng::JobsQueue::jobs_item_create(JobsType::kJobsDatabase, WebRequest{JobsType::kJobsDatabase, 8, ""}));
+
+        std::vector<JobsEng::JobsID> children_jobs_ids;
+        ret = jobs.queue().push_back_and_start_child(parent_jobs_id, small::EnumPriorities::kNormal, children_jobs_items, &children_jobs_ids);
+        ASSERT_EQ(ret, 2);
+        ASSERT_EQ(children_jobs_ids.size(), 2);
+        ASSERT_EQ(jobs.jobs_get(parent_jobs_id)->get_children().size(), 2);
+        ASSERT_EQ(jobs.jobs_get(children_jobs_ids[1])->get_parents()[0], parent_jobs_id);
+
+        jobs.start_threads(3);
+
+        // wait to finish (the parent is processed after its children)
+        auto retw = jobs.wait();
+        ASSERT_EQ(retw, small::EnumLock::kExit);
+        ASSERT_EQ(jobs.size(), 0);
+
+        std::sort(processed.begin(), processed.end());
+        ASSERT_EQ(processed, std::vector<WebID>({1, 2, 3, 4, 5, 6, 7, 8}));
+    }
+
+    TEST_F(JobsEngineTest, Jobs_Graph)
+    {
+        JobsEng jobs(m_default_config);
+
+        std::vector<WebID> processed;
+
+        // setup (the job 100 fails)
+        jobs.config_default_function_processing([&processed](auto& j /*this jobs engine*/, const auto& jobs_items, auto& /* jobs_config */) {
+            for (auto& item : jobs_items) {
+                processed.push_back(std::get<1>(item->m_request));
+                if (std::get<1>(item->m_request) == 100) {
+                    j.state().jobs_failed(item->m_id);
+                }
+            }
+        });
+
+        auto create = [](const WebID id) { return JobsEng::JobsQueue::jobs_item_create(JobsType::kJobsSettings, WebRequest{JobsType::kJobsSettings, id, ""}); };
+
+        // a cycle is not added
+        std::vector<std::shared_ptr<JobsEng::JobsItem>> cycle_jobs_items{create(10), create(11)};
+        auto                                            ret = jobs.push_back_and_start_graph(small::EnumPriorities::kNormal, cycle_jobs_items, {{0, 1}, {1, 0}});
+        ASSERT_EQ(ret, 0);
+        ASSERT_EQ(jobs.size(), 0);
+
+        // diamond 1 -> (2, 3) -> 4
+        std::vector<std::shared_ptr<JobsEng::JobsItem>> jobs_items{create(4), create(3), create(2), create(1)};
+        std::vector<JobsEng::JobsID>                    jobs_ids;
+        ret = jobs.push_back_and_start_graph(small::EnumPriorities::kNormal, jobs_items, {{3, 2}, {3, 1}, {2, 0}, {1, 0}}, &jobs_ids);
+        ASSERT_EQ(ret, 4);
+        ASSERT_EQ(jobs_ids.size(), 4);
+        ASSERT_EQ(jobs_items[0]->m_children_count.load(), 2);
+
+        // chain 100 -> 101 -> 102 (100 fails, so the others fail too without processing)
+        std::vector<std::shared_ptr<JobsEng::JobsItem>> failed_jobs_items{create(100), create(101), create(102)};
+        ret = jobs.push_back_and_start_graph(small::EnumPriorities::kNormal, failed_jobs_items, {{0, 1}, {1, 2}});
+        ASSERT_EQ(ret, 3);
+
+        jobs.start_threads(1);
+
+        // wait to finish
+        auto retw = jobs.wait();
+        ASSERT_EQ(retw, small::EnumLock::kExit);
+        ASSERT_EQ(jobs.size(), 0);
+
+        // each job after the jobs it depends on
+        ASSERT_EQ(processed.size(), 5);
+        auto position = [&processed](const WebID id) { return std::find(processed.begin(), processed.end(), id) - processed.begin(); };
+        ASSERT_LT(position(1), position(2));
+        ASSERT_LT(position(1), position(3));
+        ASSERT_LT(position(2), position(4));
+        ASSERT_LT(position(3), position(4));
+        ASSERT_LT(position(100), static_cast<long>(processed.size()));
+        ASSERT_TRUE(jobs_items[0]->is_state_finished());
+        ASSERT_TRUE(failed_jobs_items[1]->is_state_failed());
+        ASSERT_TRUE(failed_jobs_items[2]->is_state_failed());
+    }
+
+    TEST_F(JobsEngineTest, Jobs_Graph_Group_Priorities)
+    {
+        // the default group has its own priorities (kLowest is not one of the engine priorities)
+        JobsEng::JobsConfig config                                      = m_default_config;
+        config.m_groups[JobsGroupType::kJobsGroupDefault].m_config_prio = {.priorities = {{small::EnumPriorities::kNormal, 1}, {small::EnumPriorities::kLowest, 1}}};
+        JobsEng jobs(config);
+
+        std::vector<WebID> processed;
+        jobs.config_default_function_processing([&processed](auto& j /*this jobs engine*/, const auto& jobs_items, auto& /* jobs_config */) {
+            for (auto& item : jobs_items) {
+                processed.push_back(std::get<1>(item->m_request));
+                j.state().jobs_finished(item->m_id);
+            }
+        });
+
+        auto create = [](const WebID id) { return JobsEng::JobsQueue::jobs_item_create(JobsType::kJobsSettings, WebRequest{JobsType::kJobsSettings, id, ""}); };
+
+        // a priority that is not in the group priorities is not added
+        std::vector<std::shared_ptr<JobsEng::JobsItem>> high_jobs_items{create(10), create(11)};
+        auto                                            ret = jobs.push_back_and_start_graph(small::EnumPriorities::kHighest, high_jobs_items, {{0, 1}});
+        ASSERT_EQ(ret, 0);
+        ASSERT_EQ(jobs.size(), 0);
+
+        // chain 1 -> 2 -> 3 with a priority of the group
+        std::vector<std::shared_ptr<JobsEng::JobsItem>> jobs_items{create(1), create(2), create(3)};
+        ret = jobs.push_back_and_start_graph(small::EnumPriorities::kLowest, jobs_items, {{0, 1}, {1, 2}});
+        ASSERT_EQ(ret, 3);
+
+        jobs.start_threads(1);
+
+        auto retw = jobs.wait();
+        ASSERT_EQ(retw, small::EnumLock::kExit);
+        ASSERT_EQ(jobs.size(), 0);
+
+        ASSERT_EQ(processed, std::vector<WebID>({1, 2, 3}));
+        ASSERT_TRUE(jobs_items[2]->is_state_finished());
+    }
+
+    TEST_F(JobsEngineTest, Jobs_Dedup)
+    {
+        // the requests with the same id are processed once and the finished responses are cached
+        JobsEng::JobsConfig config                                   = m_default_config;
+        config.m_types[JobsType::kJobsApiGet].m_function_dedup_key   = [](const WebRequest& request) { return static_cast<std::size_t>(std::get<1>(request)); };
+        config.m_types[JobsType::kJobsApiGet].m_dedup_cache_capacity = 10;
+        JobsEng jobs(config);
+
+        std::mutex               lock;
+        std::vector<WebID>       processed;
+        std::vector<WebResponse> responses;
+
+        // setup
+        jobs.config_default_function_processing([&](auto& j /*this jobs engine*/, const auto& jobs_items, auto& /* jobs_config */) {
+            for (auto& item : jobs_items) {
+                {
+                    std::unique_lock l(lock);
+                    processed.push_back(std::get<1>(item->m_request));
+                }
+                j.state().jobs_finished(item->m_id, "response" + std::to_string(std::get<1>(item->m_request)));
+            }
+        });
+        jobs.config_jobs_function_finished(JobsType::kJobsApiGet, [&](auto& /*this jobs engine*/, const auto& jobs_items) {
+            for (auto& item : jobs_items) {
+                std::unique_lock l(lock);
+                responses.push_back(item->m_response);
+            }
+        });
+
+        // the duplicates wait for the first job
+        auto create = [](const WebID id) { return JobsEng::JobsQueue::jobs_item_create(JobsType::kJobsApiGet, WebRequest{JobsType::kJobsApiGet, id, ""}); };
+
+        std::vector<JobsEng::JobsID> jobs_ids;
+        auto                         retq = jobs.queue().push_back_and_start(small::EnumPriorities::kNormal, {create(1), create(1), create(2)}, &jobs_ids);
+        ASSERT_EQ(retq, 3);
+        retq = jobs.queue().push_back_and_start(small::EnumPriorities::kNormal, JobsType::kJobsApiGet, {JobsType::kJobsApiGet, 1, ""});
+        ASSERT_EQ(retq, 1);
+        ASSERT_EQ(jobs.size(), 4); // because the thread is not started
+
+        jobs.start_threads(1);
+        for (int i = 0; i < 100 && jobs.size() > 0; ++i) {
+            small::sleep(10);
+        }
+        ASSERT_EQ(jobs.size(), 0);
+
+        // the finished response is taken from the cache
+        retq = jobs.queue().push_back_and_start(small::EnumPriorities::kNormal, JobsType::kJobsApiGet, {JobsType::kJobsApiGet, 1, ""});
+        ASSERT_EQ(retq, 1);
+
+        // wait to finish
+        auto retw = jobs.wait();
+        ASSERT_EQ(retw, small::EnumLock::kExit);
+        ASSERT_EQ(jobs.size(), 0);
+
+        std::sort(processed.begin(), processed.end());
+        ASSERT_EQ(processed, (std::vector<WebID>{1, 2}));
+        std::sort(responses.begin(), responses.end());
+        ASSERT_EQ(responses, (std::vector<WebResponse>{"response1", "response1", "response1", "response1", "response2"}));
+    }
+
+    TEST_F(JobsEngineTest, Jobs_Dedup_Equal)
+    {
+        // all the requests have the same key, so they are compared (only the same request shares the response)
+        JobsEng::JobsConfig config                                   = m_default_config;
+        config.m_types[JobsType::kJobsApiGet].m_function_dedup_key   = [](const WebRequest& /* request */) { return std::size_t{0}; };
+        config.m_types[JobsType::kJobsApiGet].m_function_dedup_equal = [](const WebRequest& request, const WebRequest& other_request) { return std::get<1>(request) == std::get<1>(other_request); };
+        config.m_types[JobsType::kJobsApiGet].m_dedup_cache_capacity = 10;
+        JobsEng jobs(config);
+
+        std::mutex               lock;
+        std::vector<WebID>       processed;
+        std::vector<WebResponse> responses;
+
+        // setup
+        jobs.config_default_function_processing([&](auto& j /*this jobs engine*/, const auto& jobs_items, auto& /* jobs_config */) {
+            for (auto& item : jobs_items) {
+                {
+                    std::unique_lock l(lock);
+                    processed.push_back(std::get<1>(item->m_request));
+                }
+                j.state().jobs_finished(item->m_id, "response" + std::to_string(std::get<1>(item->m_request)));
+            }
+        });
+        jobs.config_jobs_function_finished(JobsType::kJobsApiGet, [&](auto& /*this jobs engine*/, const auto& jobs_items) {
+            for (auto& item : jobs_items) {
+                std::unique_lock l(lock);
+                responses.push_back(item->m_response);
+            }
+        });
+
+        // the duplicate waits for the first job, the other request is processed on its own
+        auto create = [](const WebID id) { return JobsEng::JobsQueue::jobs_item_create(JobsType::kJobsApiGet, WebRequest{JobsType::kJobsApiGet, id, ""}); };
+
+        auto retq = jobs.queue().push_back_and_start(small::EnumPriorities::kNormal, {create(1), create(1), create(2)});
+        ASSERT_EQ(retq, 3);
+
+        jobs.start_threads(1);
+        for (int i = 0; i < 100 && jobs.size() > 0; ++i) {
+            small::sleep(10);
+        }
+        ASSERT_EQ(jobs.size(), 0);
+
+        // the cached response is taken only by the same request
+        retq = jobs.queue().push_back_and_start(small::EnumPriorities::kNormal, {create(1), create(2)});
+        ASSERT_EQ(retq, 2);
+
+        // wait to finish
+        auto retw = jobs.wait();
+        ASSERT_EQ(retw, small::EnumLock::kExit);
+        ASSERT_EQ(jobs.size(), 0);
+
+        std::sort(processed.begin(), processed.end());
+        ASSERT_EQ(processed, (std::vector<WebID>{1, 2, 2}));
+        std::sort(responses.begin(), responses.end());
+        ASSERT_EQ(responses, (std::vector<WebResponse>{"response1", "response1", "response1", "response2", "response2"}));
+    }
+
+    TEST_F(JobsEngineTest, Jobs_Rate_Limit)
+    {
+        // 100 jobs per second for the api group (5 at once) and 50 jobs per second for the database type
+        JobsEng::JobsConfig config                                 = m_default_config;
+        config.m_groups[JobsGroupType::kJobsGroupApi].m_rate_limit = {{.m_rate = 100, .m_burst = 5}};
+        config.m_types[JobsType::kJobsDatabase].m_rate_limit       = {{.m_rate = 50, .m_burst = 1}};
+
+        for (auto jobs_type : {JobsType::kJobsApiGet, JobsType::kJobsDatabase}) {
+            JobsEng jobs(config);
+
+            std::atomic<int> processing_count{0};
+            jobs.config_default_function_processing([&processing_count](auto& /*this jobs engine*/, const auto& jobs_items, auto& /* jobs_config */) {
+                processing_count += static_cast<int>(jobs_items.size());
+            });
+
+            // the first ones (the burst) are processed at once, then the others at the rate
+            jobs.start_threads(3);
+            auto timeStart = small::time_now();
+            for (int i = 0; i < 25; ++i) {
+                auto retq = jobs.queue().push_back_and_start(small::EnumPriorities::kNormal, jobs_type, {jobs_type, i, ""});
+                ASSERT_EQ(retq, 1);
+            }
+
+            // wait to finish
+            auto retw = jobs.wait();
+            ASSERT_EQ(retw, small::EnumLock::kExit);
+            auto elapsed = small::time_diff_ms(timeStart);
+
+            ASSERT_EQ(jobs.size(), 0);
+            ASSERT_EQ(processing_count.load(), 25);
+            ASSERT_GE(elapsed, jobs_type == JobsType::kJobsApiGet ? 190 : 470); // (25 - 5) / 100 seconds or (25 - 1) / 50 seconds
+            ASSERT_LE(elapsed, 3000);
+        }
+    }
+
+    TEST_F(JobsEngineTest, Jobs_Rate_Limit_Exit)
+    {
+        // 1 job per second for the database type, the second job is over the limit when the engine is exiting
+        JobsEng::JobsConfig config                           = m_default_config;
+        config.m_types[JobsType::kJobsDatabase].m_rate_limit = {{.m_rate = 1, .m_burst = 1}};
+        JobsEng jobs(config);
+
+        // push
+        JobsEng::JobsID jobs_id1{};
+        JobsEng::JobsID jobs_id2{};
+        auto            retq = jobs.queue().push_back(JobsType::kJobsDatabase, {JobsType::kJobsDatabase, 1, ""}, &jobs_id1);
+        ASSERT_EQ(retq, 1);
+        retq = jobs.queue().push_back(JobsType::kJobsDatabase, {JobsType::kJobsDatabase, 2, ""}, &jobs_id2);
+        ASSERT_EQ(retq, 1);
+        auto jobs_item2 = jobs.jobs_get(jobs_id2);
+        ASSERT_TRUE(jobs_item2);
+
+        // the first job takes the token
+        auto rets = jobs.jobs_start(small::EnumPriorities::kNormal, jobs_id1);
+        ASSERT_EQ(rets, 1);
+
+        // the second job cannot wait for its turn in the delayed queue, so it is not started and it is cancelled
+        jobs.signal_exit_force();
+        rets = jobs.jobs_start(small::EnumPriorities::kNormal, jobs_id2);
+        ASSERT_EQ(rets, 0);
+        ASSERT_TRUE(jobs_item2->is_state_cancelled());
+        ASSERT_FALSE(jobs.jobs_get(jobs_id2));
+
+        // wait to finish
+        auto retw = jobs.wait();
+        ASSERT_EQ(retw, small::EnumLock::kExit);
+    }
+
+    TEST_F(JobsEngineTest, Jobs_Threads_Borrow)
+    {
+        // the api group has 1 thread of its own and can borrow the idle threads up to 3
+        JobsEng::JobsConfig config                                  = m_default_config;
+        config.m_groups[JobsGroupType::kJobsGroupApi].m_threads_max = 3;
+        JobsEng jobs(config);
+
+        std::atomic<int>       running{0};
+        std::atomic<int>       max_running{0};
+        std::atomic<long long> database_start{0};
+        auto                   timeStart = small::time_now();
+
+        jobs.config_default_function_processing([&](auto& /*this jobs engine*/, const auto& jobs_items, auto& /* jobs_config */) {
+            if (jobs_items.front()->m_type == JobsType::kJobsDatabase) {
+                database_start = small::time_diff_ms(timeStart);
+                return;
+            }
+            auto current = ++running;
+            for (auto max = max_running.load(); current > max && !max_running.compare_exchange_weak(max, current);) {
+            }
+            small::sleep(100);
+            --running;
+        });
+
+        jobs.start_threads(3);
+        for (int i = 0; i < 6; ++i) {
+            jobs.queue().push_back_and_start(small::EnumPriorities::kNormal, JobsType::kJobsApiGet, {JobsType::kJobsApiGet, i, ""});
+        }
+
+        // the database group takes its thread back after the current batch
+        small::sleep(50);
+        jobs.queue().push_back_and_start(small::EnumPriorities::kNormal, JobsType::kJobsDatabase, {JobsType::kJobsDatabase, 100, ""});
+
+        // wait to finish
+        auto retw = jobs.wait();
+        ASSERT_EQ(retw, small::EnumLock::kExit);
+        ASSERT_EQ(jobs.size(), 0);
+
+        ASSERT_EQ(max_running.load(), 3);
+        ASSERT_GT(database_start.load(), 0);
+        ASSERT_LT(database_start.load(), 190);
+    }
+
     TEST_F(JobsEngineTest, Jobs_Default_Processing_Sleep_Between_Requests)
     {
         auto timeStart = small::time_now();
@@ -265,6 +839,124 @@ namespace {
         ASSERT_EQ(processing_count, 2);
     }
 
+    //
+    // operations with default processing function and max batch delay (wait for a full bulk)
+    //
+    TEST_F(JobsEngineTest, Jobs_Default_Processing_Max_Batch_Delay)
+    {
+        JobsEng::JobsConfig config                                          = m_default_config;
+        config.m_groups[JobsGroupType::kJobsGroupDefault].m_bulk_count      = 10;
+        config.m_groups[JobsGroupType::kJobsGroupDefault].m_max_batch_delay = std::chrono::milliseconds(300);
+
+        JobsEng jobs(config);
+
+        std::vector<std::size_t> batches;
+
+        // setup
+        jobs.config_default_function_processing([&batches](auto& /*this jobs engine*/, const auto& jobs_items, auto& /* jobs_config */) {
+            batches.push_back(jobs_items.size());
+        });
+
+        jobs.start_threads(1); // start thread
+
+        // push one, and a little later some more (they must be processed in the same batch)
+        JobsEng::JobsID jobs_id{};
+
+        auto retq = jobs.queue().push_back_and_start(small::EnumPriorities::kNormal, JobsType::kJobsSettings, {JobsType::kJobsSettings, 1, "settings1"}, &jobs_id);
+        ASSERT_EQ(retq, 1);
+
+        small::sleep(50);
+        for (int i = 2; i <= 4; ++i) {
+            retq = jobs.queue().push_back_and_start(small::EnumPriorities::kNormal, JobsType::kJobsSettings, {JobsType::kJobsSettings, i, "settings"}, &jobs_id);
+            ASSERT_EQ(retq, 1);
+        }
+
+        // wait to finish
+        auto retw = jobs.wait();
+        ASSERT_EQ(retw, small::EnumLock::kExit);
+
+        // check size
+        ASSERT_EQ(jobs.size(), 0);
+        ASSERT_EQ(batches, std::vector<std::size_t>({4}));
+    }
+
+    //
+    // threads names and cpus by group
+    //
+    TEST_F(JobsEngineTest, Jobs_Thread_Placement)
+    {
+        JobsEng::JobsConfig config                               = m_default_config;
+        config.m_engine.m_thread_name                            = "jobs";
+        config.m_groups[JobsGroupType::kJobsGroupDefault].m_cpus = {0};
+
+        JobsEng jobs(config);
+
+        std::vector<std::string> names;
+        std::vector<int>         cpus;
+
+        // setup
+        jobs.config_default_function_processing([&](auto& /*this jobs engine*/, const auto& /* jobs_items */, auto& /* jobs_config */) {
+#if defined(__linux__)
+            char name[16]{};
+            pthread_getname_np(pthread_self(), name, sizeof(name));
+            names.push_back(name);
+            cpus.push_back(sched_getcpu());
+#endif
+        });
+
+        // push
+        JobsEng::JobsID jobs_id{};
+
+        auto retq = jobs.queue().push_back_and_start(small::EnumPriorities::kNormal, JobsType::kJobsSettings, {JobsType::kJobsSettings, 1, "settings1"}, &jobs_id);
+        ASSERT_EQ(retq, 1);
+
+        jobs.start_threads(1); // start thread
+
+        // wait to finish
+        auto retw = jobs.wait();
+        ASSERT_EQ(retw, small::EnumLock::kExit);
+
+#if defined(__linux__)
+        ASSERT_EQ(names, std::vector<std::string>({"jobs-0"}));
+        ASSERT_EQ(cpus, std::vector<int>({0}));
+#endif
+    }
+
+    TEST_F(JobsEngineTest, Jobs_Thread_Placement_Restore)
+    {
+        JobsEng::JobsConfig config                               = m_default_config;
+        config.m_groups[JobsGroupType::kJobsGroupDefault].m_cpus = {0};
+
+        JobsEng jobs(config);
+
+        std::map<JobsType, std::vector<int>> cpus;
+
+        // setup
+        jobs.config_default_function_processing([&](auto& /*this jobs engine*/, const auto& jobs_items, auto& /* jobs_config */) {
+            for (auto& item : jobs_items) {
+                cpus[item->m_type] = small::get_thread_affinity();
+            }
+        });
+
+        // push (the same thread processes a group with cpus and a group without)
+        auto retq = jobs.queue().push_back_and_start(small::EnumPriorities::kNormal, JobsType::kJobsSettings, {JobsType::kJobsSettings, 1, "settings1"});
+        ASSERT_EQ(retq, 1);
+        retq = jobs.queue().push_back_and_start(small::EnumPriorities::kNormal, JobsType::kJobsApiGet, {JobsType::kJobsApiGet, 2, "get2"});
+        ASSERT_EQ(retq, 1);
+
+        jobs.start_threads(1); // start thread
+
+        // wait to finish
+        auto retw = jobs.wait();
+        ASSERT_EQ(retw, small::EnumLock::kExit);
+
+#if defined(__linux__)
+        // a group without cpus runs on the cpus the thread had before (not on all cpus)
+        ASSERT_EQ(cpus[JobsType::kJobsSettings], std::vector<int>({0}));
+        ASSERT_EQ(cpus[JobsType::kJobsApiGet], small::get_thread_affinity());
+#endif
+    }
+
     //
     // operations with default processing function and timeout request
     //
@@ -422,6 +1114,104 @@ namespace {
         ASSERT_EQ(processed_web_ids[1], 101); // normal priority second
     }
 
+    //
+    // jobs with their own deadline in a group with earliest deadline first scheduling
+    //
+    TEST_F(JobsEngineTest, Jobs_Priority_Deadline)
+    {
+        JobsEng::JobsConfig config                                      = m_default_config;
+        config.m_groups[JobsGroupType::kJobsGroupDefault].m_config_prio = {.priorities    = {{small::EnumPriorities::kNormal, 1}},
+                                                                           .scheduling    = small::EnumPrioScheduling::kDeadline,
+                                                                           .deadline_time = std::chrono::milliseconds(100)};
+        JobsEng jobs(config);
+
+        std::vector<WebID> processed_web_ids;
+
+        // setup
+        jobs.config_jobs_function_processing(
+            JobsType::kJobsSettings,
+            [&processed_web_ids](auto& /*this jobs engine*/, const auto& jobs_items, auto& /* jobs_config */) {
+                for (auto& item : jobs_items) {
+                    auto& [jobs_type, web_id, web_data] = item->m_request;
+                    processed_web_ids.push_back(web_id);
+                }
+            });
+
+        // push (a far deadline, the default deadline and a near deadline, also in a bulk)
+        auto retq = jobs.queue().push_back_and_start_deadline_for(
+            std::chrono::seconds(10), small::EnumPriorities::kNormal, JobsType::kJobsSettings, {JobsType::kJobsSettings, 101, "settings101"});
+        ASSERT_EQ(retq, 1);
+
+        retq = jobs.queue().push_back_and_start(
+            small::EnumPriorities::kNormal, JobsType::kJobsSettings, {JobsType::kJobsSettings, 102, "settings102"});
+        ASSERT_EQ(retq, 1);
+
+        auto jobs_item = jobs.queue().jobs_item_create(JobsType::kJobsSettings, WebRequest{JobsType::kJobsSettings, 103, "settings103"});
+        jobs_item->m_deadline = small::time_now() + std::chrono::milliseconds(1);
+        retq                  = jobs.queue().push_back_and_start(small::EnumPriorities::kNormal, std::vector{jobs_item});
+        ASSERT_EQ(retq, 1);
+
+        jobs.start_threads(1); // start thread
+
+        // wait to finish
+        auto retw = jobs.wait();
+        ASSERT_EQ(retw, small::EnumLock::kExit);
+
+        // earliest deadline first
+        ASSERT_EQ(jobs.size(), 0);
+        std::vector<WebID> expected_web_ids = {103, 102, 101};
+        ASSERT_EQ(processed_web_ids, expected_web_ids);
+    }
+
+    //
+    // jobs of many tenants in the same group (the flows of a priority are served round robin)
+    //
+    TEST_F(JobsEngineTest, Jobs_Priority_Flows)
+    {
+        const std::size_t tenant_a = 1;
+        const std::size_t tenant_b = 2;
+
+        JobsEng::JobsConfig config = m_default_config;
+        JobsEng             jobs(config);
+
+        std::vector<WebID> processed_web_ids;
+
+        // setup
+        jobs.config_jobs_function_processing(
+            JobsType::kJobsSettings,
+            [&processed_web_ids](auto& /*this jobs engine*/, const auto& jobs_items, auto& /* jobs_config */) {
+                for (auto& item : jobs_items) {
+                    auto& [jobs_type, web_id, web_data] = item->m_request;
+                    processed_web_ids.push_back(web_id);
+                }
+            });
+
+        // push (the heavy tenant first, one by one and in a bulk)
+        for (int i = 101; i <= 103; ++i) {
+            auto retq = jobs.queue().push_back_and_start_flow(
+                small::EnumPriorities::kNormal, tenant_a, JobsType::kJobsSettings, {JobsType::kJobsSettings, i, "tenant a"});
+            ASSERT_EQ(retq, 1);
+        }
+
+        std::vector<std::shared_ptr<JobsEng::JobsItem>> jobs_items = {
+            jobs.queue().jobs_item_create(JobsType::kJobsSettings, WebRequest{JobsType::kJobsSettings, 201, "tenant b"}),
+            jobs.queue().jobs_item_create(JobsType::kJobsSettings, WebRequest{JobsType::kJobsSettings, 202, "tenant b"}),
+        };
+        auto retq = jobs.queue().push_back_and_start_flow(small::EnumPriorities::kNormal, tenant_b, jobs_items);
+        ASSERT_EQ(retq, 2);
+
+        jobs.start_threads(1); // start thread
+
+        // wait to finish
+        auto retw = jobs.wait();
+        ASSERT_EQ(retw, small::EnumLock::kExit);
+
+        // the tenants are served round robin
+        ASSERT_EQ(jobs.size(), 0);
+        std::vector<WebID> expected_web_ids = {101, 201, 102, 202, 103};
+        ASSERT_EQ(processed_web_ids, expected_web_ids);
+    }
+
     //
     // parent-child relationship start parent and children execute first
     //
@@ -824,4 +1614,61 @@ namespace {
         ASSERT_EQ(finished_count, 4);
     }
 
+    TEST_F(JobsEngineTest, Jobs_Children_Aggregates)
+    {
+        JobsEng::JobsConfig config = m_default_config;
+        JobsEng             jobs(config);
+
+        // push (no threads)
+        JobsEng::JobsID parent1_jobs_id{};
+        JobsEng::JobsID parent2_jobs_id{};
+        JobsEng::JobsID child1_jobs_id{};
+        JobsEng::JobsID child2_jobs_id{};
+
+        jobs.queue().push_back(JobsType::kJobsSettings, {JobsType::kJobsSettings, 101, "parent1"}, &parent1_jobs_id);
+        jobs.queue().push_back_child(parent1_jobs_id, JobsType::kJobsSettings, {JobsType::kJobsSettings, 102, "child1"}, &child1_jobs_id);
+        jobs.queue().push_back_child(parent1_jobs_id, JobsType::kJobsSettings, {JobsType::kJobsSettings, 103, "child2"}, &child2_jobs_id);
+
+        auto parent1 = jobs.jobs_get(parent1_jobs_id);
+        ASSERT_EQ(parent1->m_children_count.load(), 2);
+
+        // progress of a child is added to the parent
+        auto retp = jobs.state().jobs_progress(child1_jobs_id, 40);
+        ASSERT_TRUE(retp);
+        ASSERT_EQ(parent1->m_children_progress.load(), 40);
+        ASSERT_EQ(parent1->get_progress(), 20);
+
+        // a parent linked later gets what the child has already reported
+        jobs.queue().push_back(JobsType::kJobsSettings, {JobsType::kJobsSettings, 104, "parent2"}, &parent2_jobs_id);
+        auto retr = jobs.jobs_parent_child(parent2_jobs_id, child1_jobs_id);
+        ASSERT_EQ(retr, 1);
+
+        auto                           parent2        = jobs.jobs_get(parent2_jobs_id);
+        small::jobsimpl::EnumJobsState parent2_state  = small::jobsimpl::EnumJobsState::kNone;
+        int                            parent2_progress = 0;
+        jobs.state().get_children_states(parent2, &parent2_state, &parent2_progress);
+        ASSERT_EQ(parent2_state, small::jobsimpl::EnumJobsState::kWaitChildren);
+        ASSERT_EQ(parent2_progress, 40);
+
+        // the second child finishes
+        auto retf = jobs.state().jobs_finished(child2_jobs_id);
+        ASSERT_TRUE(retf);
+        ASSERT_EQ(parent1->m_children_completed.load(), 1);
+        ASSERT_EQ(parent1->m_children_failed.load(), 0);
+        ASSERT_EQ(parent1->get_progress(), 70);
+        ASSERT_FALSE(parent1->is_complete());
+
+        // a failed child fails both parents
+        retf = jobs.state().jobs_failed(child1_jobs_id);
+        ASSERT_TRUE(retf);
+        ASSERT_EQ(parent1->m_children_completed.load(), 2);
+        ASSERT_EQ(parent1->m_children_failed.load(), 1);
+        ASSERT_EQ(parent2->m_children_failed.load(), 1);
+        ASSERT_TRUE(parent1->is_state_failed());
+        ASSERT_TRUE(parent2->is_state_failed());
+
+        // the parents are deleted with their children
+        ASSERT_EQ(jobs.size(), 0);
+    }
+
 } // namespace
\ No newline at end of file
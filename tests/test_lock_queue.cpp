@@ -77,6 +77,7 @@ namespace {
         auto r_push = q.push_back(5);
         ASSERT_EQ(r_push, 1);
         ASSERT_EQ(q.size(), 1);
+        ASSERT_EQ(q.size_approx(), 1);
 
         // wait to be empty
         auto ret_wait = q.wait_for(std::chrono::milliseconds(100));
@@ -90,6 +91,7 @@ namespace {
 
         // check size
         ASSERT_EQ(q.size(), 0);
+        ASSERT_EQ(q.size_approx(), 0);
 
         ret_wait = q.wait();
         ASSERT_EQ(ret_wait, small::EnumLock::kExit);
@@ -208,4 +208,19 @@ namespace {
         ASSERT_EQ(cache1.size(), 0); // cache1 should be empty after move
     }
 
+    TEST_F(LRUCacheTest, ttl)
+    {
+        small::lru_cache<int, std::string> cache({.capacity = 2, .ttl = std::chrono::milliseconds(100)});
+        cache.set(1, "A");
+        ASSERT_EQ(*cache.get_copy(1), "A");
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(150));
+        cache.set(2, "B");
+
+        // expired elements are removed when accessed
+        ASSERT_EQ(cache.get_copy(1), std::nullopt);
+        ASSERT_EQ(cache.size(), 1);
+        ASSERT_EQ(*cache.get(2), "B");
+    }
+
 } // namespace
\ No newline at end of file
@@ -0,0 +1,149 @@
+#include "test_common.h"
+
+#include "../include/pipeline.h"
+#include "../include/util.h"
+
+namespace {
+    class PipelineTest : public testing::Test
+    {
+    protected:
+        PipelineTest() = default;
+
+        void SetUp() override
+        {
+            // setup before test
+        }
+        void TearDown() override
+        {
+            // cleanup after test
+        }
+    };
+
+    //
+    // pipeline
+    //
+    TEST_F(PipelineTest, Pipeline_Operations)
+    {
+        std::mutex       lock;
+        std::vector<int> results;
+
+        small::pipeline<int> p;
+        p.add_stage({.threads_count = 2, .bulk_count = 4}, [](std::vector<int>& items) {
+            for (auto& i : items) {
+                i += 1;
+            }
+        });
+        p.add_stage({.threads_count = 2, .bulk_count = 8, .channel_size = 16}, [](std::vector<int>& items) {
+            for (auto& i : items) {
+                i *= 2;
+            }
+        });
+        p.add_stage({.threads_count = 1, .bulk_count = 8}, [&](std::vector<int>& items) {
+            std::unique_lock l(lock);
+            results.insert(results.end(), items.begin(), items.end());
+        });
+        ASSERT_EQ(p.stages_count(), 3);
+        ASSERT_EQ(p.segments_count(), 3);
+
+        p.start_threads();
+
+        for (int i = 0; i < 1000; ++i) {
+            ASSERT_EQ(p.push_back(i), 1);
+        }
+
+        // wait to finish (exit is propagated from stage to stage)
+        auto ret = p.wait();
+        ASSERT_EQ(ret, small::EnumLock::kExit);
+        ASSERT_EQ(p.size(), 0);
+
+        // check
+        std::sort(results.begin(), results.end());
+        ASSERT_EQ(results.size(), 1000);
+        for (int i = 0; i < 1000; ++i) {
+            ASSERT_EQ(results[static_cast<std::size_t>(i)], (i + 1) * 2);
+        }
+
+        // push after exit will not work
+        ASSERT_EQ(p.push_back(1), 0);
+    }
+
+    TEST_F(PipelineTest, Pipeline_Fuse)
+    {
+        std::vector<std::thread::id> threads_ids;
+        std::vector<int>             results;
+
+        small::pipeline<int> p;
+        p.add_stage({.threads_count = 1, .bulk_count = 10}, [&](std::vector<int>& items) {
+            // remove the odd items
+            std::erase_if(items, [](int i) { return i % 2; });
+            threads_ids.push_back(std::this_thread::get_id());
+        });
+        p.add_stage({.fuse_with_previous = true}, [&](std::vector<int>& items) {
+            results.insert(results.end(), items.begin(), items.end());
+            threads_ids.push_back(std::this_thread::get_id());
+        });
+        ASSERT_EQ(p.stages_count(), 2);
+        ASSERT_EQ(p.segments_count(), 1);
+
+        p.push_back({1, 2, 3, 4, 5, 6});
+        p.start_threads();
+
+        auto ret = p.wait();
+        ASSERT_EQ(ret, small::EnumLock::kExit);
+
+        // same thread for both stages
+        ASSERT_EQ(results, std::vector<int>({2, 4, 6}));
+        ASSERT_EQ(threads_ids.size(), 2);
+        ASSERT_EQ(threads_ids[0], threads_ids[1]);
+    }
+
+    TEST_F(PipelineTest, Pipeline_Backpressure)
+    {
+        std::atomic<int> count{0};
+
+        small::pipeline<int> p;
+        p.add_stage({.threads_count = 1, .bulk_count = 1, .channel_size = 2}, [&](std::vector<int>& items) {
+            small::sleep(20);
+            count += static_cast<int>(items.size());
+        });
+        p.start_threads();
+
+        // the push waits while the stage is full
+        auto timeStart = small::time_now();
+        for (int i = 0; i < 10; ++i) {
+            ASSERT_LE(p.size(), 2);
+            p.push_back(i);
+        }
+        auto elapsed = small::time_diff_ms(timeStart);
+        ASSERT_GE(elapsed, 100);
+
+        auto ret = p.wait();
+        ASSERT_EQ(ret, small::EnumLock::kExit);
+        ASSERT_EQ(count.load(), 10);
+    }
+
+    TEST_F(PipelineTest, Pipeline_Force_Exit)
+    {
+        std::atomic<int> count{0};
+
+        small::pipeline<int> p;
+        p.add_stage({.threads_count = 1}, [&](std::vector<int>& items) {
+            small::sleep(100);
+            count += static_cast<int>(items.size());
+        });
+        p.add_stage({.threads_count = 1}, [&](std::vector<int>& items) {
+            count += static_cast<int>(items.size());
+        });
+        p.start_threads();
+
+        p.push_back({1, 2, 3, 4, 5});
+        small::sleep(50); // wait for the first item to be taken
+
+        p.signal_exit_force();
+
+        auto ret = p.wait();
+        ASSERT_EQ(ret, small::EnumLock::kExit);
+        ASSERT_LE(count.load(), 2);
+    }
+
+} // namespace
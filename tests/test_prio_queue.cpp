@@ -88,6 +88,7 @@ namespace {
         r_push = q.push_back({small::EnumPriorities::kNormal, 6}); // as a pair
         ASSERT_EQ(r_push, 1);
         ASSERT_EQ(q.size(), 2);
+        ASSERT_EQ(q.size_approx(), 2);
 
         // wait to be empty
         auto ret_wait = q.wait_for(std::chrono::milliseconds(100));
@@ -197,6 +198,386 @@ namespace {
         q.clear();
     }
 
+    TEST_F(PrioQueueTest, Queue_Operations_Ratio)
+    {
+        // priorities that are not enums and a priority without credits
+        small::prio_queue<int, std::string> q{
+            {.priorities{{
+                {"high", 2},
+                {"normal", 1},
+                {"low", 0},
+            }}}};
+        ASSERT_EQ(q.size(), 0);
+
+        q.push_back("low", {9, 10});
+        q.push_back("normal", {5, 6, 7});
+        q.push_back("high", {1, 2, 3, 4});
+        ASSERT_EQ(q.size(), 9);
+        ASSERT_EQ(q.size("high"), 4);
+        ASSERT_EQ(q.size("normal"), 3);
+        ASSERT_EQ(q.size("low"), 2);
+        ASSERT_EQ(q.size("none"), 0);
+
+        // pop
+        std::vector<int> values;
+        auto             ret = q.wait_pop_front(values, 9);
+        ASSERT_EQ(ret, small::EnumLock::kElement);
+        std::vector<int> expected_order = {1, 2, 5, 3, 4, 6, 7, 9, 10};
+        ASSERT_EQ(values, expected_order);
+
+        ASSERT_EQ(q.size(), 0);
+        ASSERT_TRUE(q.empty("high"));
+    }
+
+    TEST_F(PrioQueueTest, Queue_Operations_Max_Priorities)
+    {
+        small::config_prio_queue<int> config;
+        for (int prio = 0; prio < 64; ++prio) {
+            config.priorities.push_back({prio, 1});
+        }
+        small::prio_queue<int, int> q{config};
+        ASSERT_EQ(q.push_back(63, 1), 1);
+        ASSERT_EQ(q.size(), 1);
+
+        // more priorities than supported is a config error (and not elements lost at push)
+        config.priorities.push_back({64, 1});
+        ASSERT_THROW((small::prio_queue<int, int>{config}), std::length_error);
+    }
+
+    TEST_F(PrioQueueTest, Queue_Operations_Aging)
+    {
+        small::prio_queue<int> q{{.scheduling = small::EnumPrioScheduling::kAging, .aging_time = std::chrono::milliseconds(10)}};
+        ASSERT_EQ(q.size(), 0);
+
+        q.push_back(small::EnumPriorities::kLowest, 1);
+        small::sleep(20);
+        q.push_back(small::EnumPriorities::kHighest, {2, 3});
+        ASSERT_EQ(q.size(), 3);
+
+        // the lowest waited more than aging time so it is executed first
+        std::vector<int> values;
+        auto             ret = q.wait_pop_front(values, 3);
+        ASSERT_EQ(ret, small::EnumLock::kElement);
+        std::vector<int> expected_order = {1, 2, 3};
+        ASSERT_EQ(values, expected_order);
+        ASSERT_EQ(q.size(), 0);
+    }
+
+    TEST_F(PrioQueueTest, Queue_Operations_Deadline)
+    {
+        small::prio_queue<int> q{{.scheduling = small::EnumPrioScheduling::kDeadline, .deadline_time = std::chrono::milliseconds(100)}};
+        ASSERT_EQ(q.size(), 0);
+
+        q.push_back_deadline_for(std::chrono::milliseconds(1), small::EnumPriorities::kLowest, 1);
+        q.push_back(small::EnumPriorities::kHighest, 2); // default deadline
+        q.push_back_deadline_for(std::chrono::milliseconds(50), small::EnumPriorities::kNormal, 3);
+        q.push_back_deadline_for(std::chrono::milliseconds(10), small::EnumPriorities::kNormal, 4);
+        ASSERT_EQ(q.size(), 4);
+        ASSERT_EQ(q.size(small::EnumPriorities::kNormal), 2);
+
+        // earliest deadline first
+        std::vector<int> values;
+        auto             ret = q.wait_pop_front(values, 4);
+        ASSERT_EQ(ret, small::EnumLock::kElement);
+        std::vector<int> expected_order = {1, 4, 3, 2};
+        ASSERT_EQ(values, expected_order);
+        ASSERT_EQ(q.size(), 0);
+    }
+
+    TEST_F(PrioQueueTest, Queue_Operations_Deadline_Mixed)
+    {
+        const std::size_t flow_a = 1;
+
+        small::prio_queue<int> q{{.scheduling = small::EnumPrioScheduling::kDeadline, .deadline_time = std::chrono::milliseconds(100)}};
+
+        // a far explicit deadline followed by pushes with the default deadline (now + 300ms for kNormal)
+        q.push_back_deadline_for(std::chrono::seconds(10), small::EnumPriorities::kNormal, 1);
+        q.push_back(small::EnumPriorities::kNormal, 2);
+        q.push_back(small::EnumPriorities::kNormal, std::vector<int>{3, 4});
+        q.push_back_deadline_for(std::chrono::seconds(20), small::EnumPriorities::kNormal, 5);
+        small::sleep(2);
+        q.push_back_flow(small::EnumPriorities::kNormal, flow_a, 6);
+        q.push_back_deadline_for(std::chrono::milliseconds(1), small::EnumPriorities::kNormal, 7);
+        ASSERT_EQ(q.size(), 7);
+
+        // earliest deadline first
+        std::vector<int> values;
+        auto             ret = q.wait_pop_front(values, 7);
+        ASSERT_EQ(ret, small::EnumLock::kElement);
+        std::vector<int> expected_order = {7, 2, 3, 4, 6, 1, 5};
+        ASSERT_EQ(values, expected_order);
+        ASSERT_EQ(q.size(), 0);
+    }
+
+    TEST_F(PrioQueueTest, Queue_Operations_Flows)
+    {
+        const std::size_t flow_a = 1;
+        const std::size_t flow_b = 2;
+
+        small::prio_queue<int> q{{.flow_weights = {{flow_a, 2}}}};
+
+        q.push_back(small::EnumPriorities::kNormal, 100); // without flow
+        q.push_back_flow(small::EnumPriorities::kNormal, flow_a, {1, 2, 3, 4, 5, 6});
+        q.push_back_flow(small::EnumPriorities::kNormal, flow_b, {11, 12, 13});
+        ASSERT_EQ(q.size(), 10);
+        ASSERT_EQ(q.size(small::EnumPriorities::kNormal), 10);
+
+        // flow a has weight 2 so it is executed twice as often as flow b
+        std::vector<int> values;
+        auto             ret = q.wait_pop_front(values, 10);
+        ASSERT_EQ(ret, small::EnumLock::kElement);
+        std::vector<int> expected_order = {100, 1, 2, 11, 3, 4, 12, 5, 6, 13};
+        ASSERT_EQ(values, expected_order);
+        ASSERT_EQ(q.size(), 0);
+    }
+
+    TEST_F(PrioQueueTest, Queue_Operations_Flows_Recycle)
+    {
+        const std::size_t flow_a = 5;
+        const std::size_t flow_b = 7;
+
+        small::prio_queue<int> q{{.flow_weights = {{flow_a, 2}}}};
+
+        // many flows with one elem each are served in the order they joined (and recycled when empty)
+        for (int i = 0; i < 100; ++i) {
+            q.push_back_flow(small::EnumPriorities::kNormal, static_cast<std::size_t>(1000 + i), i);
+        }
+        std::vector<int> values;
+        auto             ret = q.wait_pop_front(values, 100);
+        ASSERT_EQ(ret, small::EnumLock::kElement);
+        ASSERT_EQ(values.size(), 100);
+        for (int i = 0; i < 100; ++i) {
+            ASSERT_EQ(values[static_cast<std::size_t>(i)], i);
+        }
+
+        // flow a is recycled when empty and flow b reuses it (without its weight)
+        q.push_back_flow(small::EnumPriorities::kNormal, flow_a, 0);
+        ret = q.wait_pop_front(values, 1);
+        ASSERT_EQ(ret, small::EnumLock::kElement);
+
+        q.push_back_flow(small::EnumPriorities::kNormal, flow_b, {1, 2, 3});
+        q.push_back_flow(small::EnumPriorities::kNormal, flow_a, {4, 5, 6});
+        ret = q.wait_pop_front(values, 6);
+        ASSERT_EQ(ret, small::EnumLock::kElement);
+        std::vector<int> expected_order = {1, 4, 5, 2, 6, 3};
+        ASSERT_EQ(values, expected_order);
+        ASSERT_EQ(q.size(), 0);
+    }
+
+    TEST_F(PrioQueueTest, Queue_Operations_Flows_Deadline_Many)
+    {
+        small::prio_queue<int> q{{.scheduling = small::EnumPrioScheduling::kDeadline}};
+
+        // each flow gets elems with different deadlines, the earliest deadline is taken from any flow
+        auto now = small::time_now();
+        for (int i = 0; i < 200; ++i) {
+            auto deadline = now + std::chrono::milliseconds(1000 + (i * 37) % 200);
+            q.push_back_flow_deadline_until(deadline, small::EnumPriorities::kNormal, static_cast<std::size_t>(i % 13), (i * 37) % 200);
+        }
+
+        std::vector<int> values;
+        auto             ret = q.wait_pop_front(values, 200);
+        ASSERT_EQ(ret, small::EnumLock::kElement);
+        ASSERT_EQ(values.size(), 200);
+        for (int i = 0; i < 200; ++i) {
+            ASSERT_EQ(values[static_cast<std::size_t>(i)], i);
+        }
+        ASSERT_EQ(q.size(), 0);
+    }
+
+    TEST_F(PrioQueueTest, Queue_Operations_Flows_Aging)
+    {
+        const std::size_t flow_a = 1;
+        const std::size_t flow_b = 2;
+
+        small::prio_queue<int> q{{.scheduling = small::EnumPrioScheduling::kAging, .aging_time = std::chrono::milliseconds(10)}};
+
+        q.push_back_flow(small::EnumPriorities::kLowest, flow_a, {1, 2});
+        small::sleep(2);
+        q.push_back_flow(small::EnumPriorities::kLowest, flow_b, 3);
+        small::sleep(20);
+        q.push_back_flow(small::EnumPriorities::kLowest, flow_a, 4);
+
+        // after the first elem of flow a the round robin is at flow b, but the oldest aged elem is in flow a
+        std::vector<int> values;
+        auto             ret = q.wait_pop_front(values, 4);
+        ASSERT_EQ(ret, small::EnumLock::kElement);
+        std::vector<int> expected_order = {1, 2, 3, 4};
+        ASSERT_EQ(values, expected_order);
+        ASSERT_EQ(q.size(), 0);
+    }
+
+    TEST_F(PrioQueueTest, Queue_Operations_Flows_Deadline)
+    {
+        const std::size_t flow_a = 1;
+        const std::size_t flow_b = 2;
+
+        small::prio_queue<int> q{{.scheduling = small::EnumPrioScheduling::kDeadline, .deadline_time = std::chrono::milliseconds(100)}};
+
+        q.push_back_flow(small::EnumPriorities::kNormal, flow_a, {1, 2});
+        small::sleep(5);
+        q.push_back_flow(small::EnumPriorities::kNormal, flow_b, 3);
+
+        // after the first elem of flow a the round robin is at flow b, but the earliest deadline is in flow a
+        std::vector<int> values;
+        auto             ret = q.wait_pop_front(values, 3);
+        ASSERT_EQ(ret, small::EnumLock::kElement);
+        std::vector<int> expected_order = {1, 2, 3};
+        ASSERT_EQ(values, expected_order);
+        ASSERT_EQ(q.size(), 0);
+    }
+
+    TEST_F(PrioQueueTest, Queue_Operations_Limits_Reject)
+    {
+        small::prio_queue<int> q{{.max_size            = 4,
+                                  .max_size_priorities = {{small::EnumPriorities::kLow, 2}}}};
+
+        ASSERT_EQ(q.push_back(small::EnumPriorities::kLow, {1, 2, 3}), 2);
+        ASSERT_EQ(q.push_back(small::EnumPriorities::kHigh, {4, 5, 6}), 2);
+        ASSERT_EQ(q.push_back(small::EnumPriorities::kHighest, 7), 0);
+        ASSERT_EQ(q.size(), 4);
+
+        ASSERT_EQ(q.count_rejected(), 3);
+        ASSERT_EQ(q.count_rejected(small::EnumPriorities::kLow), 1);
+        ASSERT_EQ(q.count_rejected(small::EnumPriorities::kHigh), 1);
+        ASSERT_EQ(q.count_rejected(small::EnumPriorities::kHighest), 1);
+        ASSERT_EQ(q.count_dropped(), 0);
+    }
+
+    TEST_F(PrioQueueTest, Queue_Operations_Limits_Drop)
+    {
+        small::prio_queue<int> q{{.max_size            = 4,
+                                  .max_size_priorities = {{small::EnumPriorities::kLow, 2}},
+                                  .overflow            = small::EnumPrioOverflow::kDropOldestLowest}};
+
+        // the oldest of the same priority is dropped
+        ASSERT_EQ(q.push_back(small::EnumPriorities::kLow, {1, 2, 3}), 3);
+        ASSERT_EQ(q.size(small::EnumPriorities::kLow), 2);
+        ASSERT_EQ(q.count_dropped(small::EnumPriorities::kLow), 1);
+
+        // the oldest of the lowest priority is dropped
+        ASSERT_EQ(q.push_back(small::EnumPriorities::kHigh, {4, 5, 6}), 3);
+        ASSERT_EQ(q.size(small::EnumPriorities::kLow), 1);
+        ASSERT_EQ(q.size(small::EnumPriorities::kHigh), 3);
+        ASSERT_EQ(q.count_dropped(small::EnumPriorities::kLow), 2);
+
+        // a priority lower than everything in queue is rejected (higher priorities are never dropped)
+        ASSERT_EQ(q.push_back(small::EnumPriorities::kLowest, 7), 0);
+        ASSERT_EQ(q.count_rejected(small::EnumPriorities::kLowest), 1);
+        ASSERT_EQ(q.count_dropped(), 2);
+
+        std::vector<int> values;
+        auto             ret = q.wait_pop_front(values, 4);
+        ASSERT_EQ(ret, small::EnumLock::kElement);
+        std::vector<int> expected_order = {4, 5, 6, 3};
+        ASSERT_EQ(values, expected_order);
+    }
+
+    TEST_F(PrioQueueTest, Queue_Operations_Limits_Drop_Flows)
+    {
+        const std::size_t flow_a = 1;
+        const std::size_t flow_b = 2;
+
+        small::prio_queue<int> q{{.max_size = 3, .overflow = small::EnumPrioOverflow::kDropOldestLowest}};
+
+        q.push_back_flow(small::EnumPriorities::kNormal, flow_a, {1, 2});
+        q.push_back_flow(small::EnumPriorities::kNormal, flow_b, 3);
+        int  value = 0;
+        auto ret   = q.wait_pop_front(&value); // then flow b is served next
+        ASSERT_EQ(ret, small::EnumLock::kElement);
+        ASSERT_EQ(value, 1);
+
+        // the oldest (2) is dropped even if it is not in the flow that is served next
+        q.push_back_flow(small::EnumPriorities::kNormal, flow_a, {4, 5});
+        ASSERT_EQ(q.count_dropped(), 1);
+
+        std::vector<int> values;
+        ret = q.wait_pop_front(values, 3);
+        ASSERT_EQ(ret, small::EnumLock::kElement);
+        std::vector<int> expected_order = {3, 4, 5};
+        ASSERT_EQ(values, expected_order);
+    }
+
+    TEST_F(PrioQueueTest, Queue_Operations_Limits_Drop_Deadline)
+    {
+        small::prio_queue<int> q{{.scheduling = small::EnumPrioScheduling::kDeadline, .max_size = 3, .overflow = small::EnumPrioOverflow::kDropOldestLowest}};
+
+        // the latest deadline is dropped (the least urgent), not the earliest one that is served next
+        q.push_back_deadline_for(std::chrono::milliseconds(50), small::EnumPriorities::kNormal, 1);
+        q.push_back_deadline_for(std::chrono::milliseconds(10), small::EnumPriorities::kNormal, 2);
+        q.push_back_deadline_for(std::chrono::milliseconds(100), small::EnumPriorities::kNormal, 3);
+        q.push_back_deadline_for(std::chrono::milliseconds(20), small::EnumPriorities::kNormal, 4);
+        ASSERT_EQ(q.count_dropped(), 1);
+
+        std::vector<int> values;
+        auto             ret = q.wait_pop_front(values, 3);
+        ASSERT_EQ(ret, small::EnumLock::kElement);
+        std::vector<int> expected_order = {2, 4, 1};
+        ASSERT_EQ(values, expected_order);
+    }
+
+    TEST_F(PrioQueueTest, Queue_Operations_Limits_Block)
+    {
+        small::prio_queue<int> q{{.max_size = 2, .overflow = small::EnumPrioOverflow::kBlock}};
+
+        std::latch sync_thread{1};
+        std::latch sync_main{1};
+
+        // create thread that pushes more than the limit
+        auto thread = std::jthread([](small::prio_queue<int>& _q, std::latch& _sync_thread, const std::latch& _sync_main) {
+            _q.push_back(small::EnumPriorities::kNormal, {1, 2});
+            _sync_thread.count_down(); // signal that 2 elements are in
+            _sync_main.wait();
+            _q.push_back(small::EnumPriorities::kNormal, {3, 4}); // blocks until elements are consumed
+        },
+                                   std::ref(q), std::ref(sync_thread), std::ref(sync_main));
+
+        sync_thread.wait();
+        ASSERT_EQ(q.size(), 2);
+        sync_main.count_down();
+
+        std::vector<int> values;
+        for (int i = 0; i < 4; ++i) {
+            int  value = 0;
+            auto ret   = q.wait_pop_front(&value);
+            ASSERT_EQ(ret, small::EnumLock::kElement);
+            values.push_back(value);
+        }
+        std::vector<int> expected_order = {1, 2, 3, 4};
+        ASSERT_EQ(values, expected_order);
+        ASSERT_EQ(q.count_rejected(), 0);
+    }
+
+    TEST_F(PrioQueueTest, Queue_Operations_Limits_Block_Locked)
+    {
+        small::prio_queue<int> q{{.max_size = 2, .overflow = small::EnumPrioOverflow::kBlock}};
+
+        {
+            // the producer holds the lock, so it can not wait for room (the consumers could never take the lock)
+            std::unique_lock l(q);
+            ASSERT_EQ(q.push_back(small::EnumPriorities::kNormal, {1, 2, 3}), 2);
+            ASSERT_EQ(q.push_back(small::EnumPriorities::kNormal, 4), 0);
+            ASSERT_EQ(q.count_rejected(), 2);
+        }
+
+        // without the lock it waits again
+        auto thread = std::jthread([](small::prio_queue<int>& _q) {
+            _q.push_back(small::EnumPriorities::kNormal, 5); // blocks until an element is consumed
+        },
+                                   std::ref(q));
+
+        std::vector<int> values;
+        for (int i = 0; i < 3; ++i) {
+            int  value = 0;
+            auto ret   = q.wait_pop_front(&value);
+            ASSERT_EQ(ret, small::EnumLock::kElement);
+            values.push_back(value);
+        }
+        std::vector<int> expected_order = {1, 2, 5};
+        ASSERT_EQ(values, expected_order);
+        ASSERT_EQ(q.count_rejected(), 2);
+    }
+
     TEST_F(PrioQueueTest, Queue_Operations_Clear)
     {
         small::prio_queue<int> q;
@@ -135,6 +135,512 @@ namespace {
         ASSERT_GE(elapsed, 300 - 1); // due conversion
     }
 
+    TEST_F(WorkerThreadTest, Worker_Operations_Keyed)
+    {
+        using qc = std::pair<int /*key*/, int /*seq*/>;
+
+        const int                     keys     = 8;
+        const int                     elements = 50;
+        std::vector<std::atomic<int>> keys_busy(keys);
+        std::vector<std::vector<int>> keys_processed(keys);
+        std::atomic<int>              errors{0};
+
+        // create workers
+        small::worker_thread<qc> workers({.threads_count = 0 /*no threads*/, .bulk_count = 2}, [&](auto& /*this*/, const auto& items) {
+            for (auto& [key, seq] : items) {
+                if (keys_busy[key].fetch_add(1) != 0) {
+                    ++errors; // same key processed in parallel
+                }
+                small::sleep_micro(10);
+                keys_processed[key].push_back(seq);
+                keys_busy[key].fetch_sub(1);
+            }
+        });
+        workers.set_function_key([](const qc& item) -> std::size_t { return static_cast<std::size_t>(item.first); });
+
+        // push
+        for (int seq = 0; seq < elements; ++seq) {
+            for (int key = 0; key < keys; ++key) {
+                workers.push_back({key, seq});
+            }
+        }
+        ASSERT_EQ(workers.size(), keys * elements);
+
+        workers.start_threads(4); // start threads
+
+        // wait to finish
+        auto ret = workers.wait();
+        ASSERT_EQ(ret, small::EnumLock::kExit);
+        ASSERT_EQ(workers.size(), 0);
+
+        // check order by key
+        ASSERT_EQ(errors.load(), 0);
+        std::vector<int> expected_order;
+        for (int seq = 0; seq < elements; ++seq) {
+            expected_order.push_back(seq);
+        }
+        for (int key = 0; key < keys; ++key) {
+            ASSERT_EQ(keys_processed[key], expected_order);
+        }
+    }
+
+    TEST_F(WorkerThreadTest, Worker_Operations_Keyed_Exception)
+    {
+        using qc = std::pair<int /*key*/, int /*seq*/>;
+
+        std::vector<int> processed;
+        std::atomic<int> throws{1};
+
+        // create workers (the first item throws once)
+        small::worker_thread<qc> workers({.threads_count = 0 /*no threads*/}, [&](auto& /*this*/, const auto& items) {
+            for (auto& [key, seq] : items) {
+                if (throws.fetch_sub(1) > 0) {
+                    throw std::runtime_error("processing failed");
+                }
+                processed.push_back(seq);
+            }
+        });
+        workers.set_function_key([](const qc& item) -> std::size_t { return static_cast<std::size_t>(item.first); });
+
+        // push (the items after the first one wait for the key)
+        for (int seq = 0; seq < 5; ++seq) {
+            workers.push_back({1, seq});
+        }
+
+        workers.start_threads(1); // start threads
+
+        // wait to finish
+        auto ret = workers.wait();
+        ASSERT_EQ(ret, small::EnumLock::kExit);
+        ASSERT_EQ(workers.size(), 0);
+        ASSERT_EQ(workers.count_exceptions(), 1);
+
+        // the key is not kept after the exception
+        std::vector<int> expected_order = {1, 2, 3, 4};
+        ASSERT_EQ(processed, expected_order);
+    }
+
+    TEST_F(WorkerThreadTest, Worker_Operations_Work_Stealing)
+    {
+        std::atomic<int> processing_count{0};
+
+        // create workers, each item with depth > 0 creates 2 more items (from the processing thread)
+        small::worker_thread<int> workers({.threads_count = 0 /*no threads*/, .bulk_count = 2, .backend = small::EnumWorkerThreadBackend::kWorkStealing}, [&processing_count](auto& w /*this*/, const auto& items) {
+            for (auto depth : items) {
+                ++processing_count;
+                if (depth > 0) {
+                    w.push_back(depth - 1);
+                    w.push_back(depth - 1);
+                }
+            }
+        });
+
+        // push
+        for (int i = 0; i < 10; ++i) {
+            workers.push_back(3);
+        }
+        workers.push_back_delay_for(std::chrono::milliseconds(100), 3);
+        ASSERT_EQ(workers.size(), 10);
+
+        workers.start_threads(4); // start threads
+
+        // wait to finish
+        auto ret = workers.wait();
+        ASSERT_EQ(ret, small::EnumLock::kExit);
+
+        // check size
+        ASSERT_EQ(workers.size(), 0);
+        ASSERT_EQ(processing_count.load(), 11 * 15);
+    }
+
+    TEST_F(WorkerThreadTest, Worker_Operations_Work_Stealing_Force_Exit)
+    {
+        std::atomic<int> processing_count{0};
+
+        // the first item pushes 10 more items from the processing thread (in its own deque)
+        small::worker_thread<int> workers({.threads_count = 1, .bulk_count = 1, .backend = small::EnumWorkerThreadBackend::kWorkStealing}, [&processing_count](auto& w /*this*/, const auto& items) {
+            for (auto value : items) {
+                ++processing_count;
+                if (value > 0) {
+                    for (int i = 0; i < 10; ++i) {
+                        w.push_back(0);
+                    }
+                }
+                small::sleep(50);
+            }
+        });
+
+        workers.push_back(1);
+        small::sleep(75); // the first item and one from the deque are processing
+
+        workers.signal_exit_force();
+        auto ret = workers.wait();
+        ASSERT_EQ(ret, small::EnumLock::kExit);
+
+        // the items left in the deque are not processed after a forced exit
+        ASSERT_LE(processing_count.load(), 3);
+    }
+
+    TEST_F(WorkerThreadTest, Worker_Operations_Work_Stealing_Park)
+    {
+        std::atomic<int>          processing_count{0};
+        std::mutex                lock_threads;
+        std::set<std::thread::id> threads_ids;
+
+        // the first item pushes 20 more items from the processing thread (in its own deque)
+        small::worker_thread<int> workers({.threads_count = 2, .bulk_count = 1, .backend = small::EnumWorkerThreadBackend::kWorkStealing}, [&](auto& w /*this*/, const auto& items) {
+            for (auto value : items) {
+                ++processing_count;
+                {
+                    std::unique_lock l(lock_threads);
+                    threads_ids.insert(std::this_thread::get_id());
+                }
+                if (value > 0) {
+                    for (int i = 0; i < 20; ++i) {
+                        w.push_back(0);
+                    }
+                }
+                small::sleep(5);
+            }
+        });
+
+        small::sleep(50); // both threads are parked
+
+        // the parked thread is woken by the pushes in the deque and steals from it
+        workers.push_back(1);
+        small::sleep(30); // the items are pushed from processing before wait (which rejects new items)
+
+        auto ret = workers.wait();
+        ASSERT_EQ(ret, small::EnumLock::kExit);
+
+        ASSERT_EQ(processing_count.load(), 21);
+        ASSERT_EQ(threads_ids.size(), 2);
+    }
+
+    //
+    // idle threads that spin and yield before blocking
+    //
+    TEST_F(WorkerThreadTest, Worker_Operations_Idle_Spin)
+    {
+        std::atomic<int> processing_count{0};
+
+        // create workers
+        small::worker_thread<int> workers({.threads_count = 2, .idle_spin_count = 1000, .idle_yield_count = 100}, [&processing_count](auto& /*this*/, const auto& items) {
+            processing_count += static_cast<int>(items.size());
+        });
+
+        // push with gaps so the threads become idle in between
+        for (int i = 0; i < 100; ++i) {
+            workers.push_back(i);
+            if (i % 10 == 0) {
+                small::sleep(1);
+            }
+        }
+        workers.push_back_delay_for(std::chrono::milliseconds(50), 100);
+
+        // wait to finish
+        auto ret = workers.wait();
+        ASSERT_EQ(ret, small::EnumLock::kExit);
+
+        // check size
+        ASSERT_EQ(workers.size(), 0);
+        ASSERT_EQ(processing_count, 101);
+    }
+
+    //
+    // linger until the bulk is full or max batch delay elapsed
+    //
+    TEST_F(WorkerThreadTest, Worker_Operations_Max_Batch_Delay)
+    {
+        std::vector<std::size_t> batches;
+
+        // create workers
+        small::worker_thread<int> workers({.threads_count = 1, .bulk_count = 5, .max_batch_delay = std::chrono::milliseconds(300)}, [&batches](auto& /*this*/, const auto& items) {
+            batches.push_back(items.size());
+        });
+
+        // push one, and a little later some more (they must be processed in the same batch)
+        workers.push_back(1);
+        small::sleep(50);
+        workers.push_back(2);
+        workers.push_back(3);
+
+        // after the delay the batch is processed even if not full
+        small::sleep(400);
+        ASSERT_EQ(batches, std::vector<std::size_t>({3}));
+
+        // full bulk is processed without waiting
+        auto timeStart = small::time_now();
+        workers.push_back({4, 5, 6, 7, 8});
+        small::sleep(50);
+        ASSERT_EQ(batches, std::vector<std::size_t>({3, 5}));
+
+        // wait to finish
+        auto ret = workers.wait();
+        ASSERT_EQ(ret, small::EnumLock::kExit);
+
+        auto elapsed = small::time_diff_ms(timeStart);
+        ASSERT_LT(elapsed, 300);
+        ASSERT_EQ(workers.size(), 0);
+    }
+
+    //
+    // adaptive threads and bulk count
+    //
+    TEST_F(WorkerThreadTest, Worker_Operations_Adaptive)
+    {
+        std::atomic<int>         processing_count{0};
+        std::atomic<std::size_t> max_bulk{0};
+
+        // create workers
+        small::worker_thread<int> workers({.threads_count = 1, .bulk_count = 1, .threads_max = 4, .park_idle_time = std::chrono::milliseconds(50), .bulk_count_max = 8, .target_batch_time = std::chrono::milliseconds(20)}, [&](auto& /*this*/, const auto& items) {
+            processing_count += static_cast<int>(items.size());
+            if (items.size() > max_bulk) {
+                max_bulk = items.size();
+            }
+            small::sleep(1);
+        });
+        ASSERT_EQ(workers.threads_active(), 1);
+        ASSERT_EQ(workers.bulk_count_active(), 1);
+
+        // many items accumulate, more threads are activated and the bulk grows
+        for (int i = 0; i < 500; ++i) {
+            workers.push_back(i);
+        }
+        small::sleep(20);
+        ASSERT_GT(workers.threads_active(), 1);
+
+        // after processing the threads are idle and are parked
+        small::sleep(500);
+        ASSERT_EQ(processing_count, 500);
+        ASSERT_GT(max_bulk, 1);
+        ASSERT_EQ(workers.threads_active(), 1);
+
+        // wait to finish
+        auto ret = workers.wait();
+        ASSERT_EQ(ret, small::EnumLock::kExit);
+        ASSERT_EQ(workers.size(), 0);
+    }
+
+    //
+    // callable known at compile time, items can be moved
+    //
+    TEST_F(WorkerThreadTest, Worker_Operations_Direct_Function)
+    {
+        std::vector<std::string> processed;
+
+        // create workers
+        auto workers = small::make_worker_thread<std::string>({.threads_count = 0 /*no threads*/, .bulk_count = 2}, [&processed](auto& /*this*/, std::vector<std::string>&& items) {
+            for (auto& item : items) {
+                processed.push_back(std::move(item));
+            }
+        });
+
+        // push
+        workers.push_back("a");
+        workers.push_back(std::string("b"));
+        workers.emplace_back("c");
+        workers.push_back_delay_for(std::chrono::milliseconds(50), "d");
+        ASSERT_EQ(workers.size(), 3);
+
+        workers.start_threads(1); // start thread
+
+        // wait to finish
+        auto ret = workers.wait();
+        ASSERT_EQ(ret, small::EnumLock::kExit);
+
+        // check size
+        ASSERT_EQ(workers.size(), 0);
+        ASSERT_EQ(processed, std::vector<std::string>({"a", "b", "c", "d"}));
+    }
+
+    //
+    // threads names and cpus
+    //
+    TEST_F(WorkerThreadTest, Worker_Operations_Thread_Placement)
+    {
+        std::vector<std::string> names;
+        std::vector<int>         cpus;
+
+        // create workers
+        small::worker_thread<int> workers({.threads_count = 1, .thread_name = "worker", .cpus = {0}}, [&](auto& /*this*/, const auto& /* items */) {
+#if defined(__linux__)
+            char name[16]{};
+            pthread_getname_np(pthread_self(), name, sizeof(name));
+            names.push_back(name);
+            cpus.push_back(sched_getcpu());
+#endif
+        });
+
+        workers.push_back(1);
+
+        // wait to finish
+        auto ret = workers.wait();
+        ASSERT_EQ(ret, small::EnumLock::kExit);
+
+#if defined(__linux__)
+        ASSERT_EQ(names, std::vector<std::string>({"worker-0"}));
+        ASSERT_EQ(cpus, std::vector<int>({0}));
+#endif
+    }
+
+    TEST_F(WorkerThreadTest, Worker_Operations_Thread_Hooks)
+    {
+        std::atomic<int> count_init{0};
+        std::atomic<int> count_exit{0};
+        std::atomic<int> count_processed{0};
+
+        // create workers
+        small::worker_thread<int> workers({.threads_count        = 2,
+                                           .stack_size           = 256 * 1024,
+                                           .function_thread_init = [&](int /* index */) { ++count_init; },
+                                           .function_thread_exit = [&](int /* index */) { ++count_exit; }},
+                                          [&](auto& /*this*/, const auto& items) {
+                                              for (auto i : items) {
+                                                  if (i == 2) {
+                                                      throw std::runtime_error("processing error");
+                                                  }
+                                                  ++count_processed;
+                                              }
+                                          });
+
+        workers.push_back(1);
+        workers.push_back(2);
+        workers.push_back(3);
+        workers.push_back(4);
+
+        // wait to finish (the thread that caught the exception continues processing)
+        auto ret = workers.wait();
+        ASSERT_EQ(ret, small::EnumLock::kExit);
+
+        ASSERT_EQ(count_processed.load(), 3);
+        ASSERT_EQ(workers.count_exceptions(), 1);
+        ASSERT_EQ(count_init.load(), 2);
+        ASSERT_EQ(count_exit.load(), 2);
+    }
+
+    TEST_F(WorkerThreadTest, Worker_Operations_Submit)
+    {
+        using Item = small::submit_item<int, std::string>;
+
+        std::atomic<int> count_then{0};
+
+        // create workers
+        small::worker_thread<Item> workers({.threads_count = 2, .bulk_count = 4}, [](auto& /*this*/, const auto& items) {
+            for (auto& item : items) {
+                if (item.m_request < 0) {
+                    item.m_promise.set_exception(std::make_exception_ptr(std::runtime_error("negative")));
+                    continue;
+                }
+                item.m_promise.set_value(std::to_string(item.m_request));
+            }
+        });
+
+        auto f = workers.submit(5);
+        ASSERT_EQ(f.get(), "5");
+
+        auto f_error = workers.submit(-1);
+        ASSERT_THROW(f_error.get(), std::runtime_error);
+
+        for (int i = 0; i < 100; ++i) {
+            workers.submit(i).then([&count_then](small::future<std::string>& ready) {
+                if (!ready.get().empty()) {
+                    ++count_then;
+                }
+            });
+        }
+
+        // wait to finish
+        auto ret = workers.wait();
+        ASSERT_EQ(ret, small::EnumLock::kExit);
+        ASSERT_EQ(count_then.load(), 100);
+
+        // submit after exit has a broken promise
+        auto f_exit = workers.submit(1);
+        ASSERT_THROW(f_exit.get(), std::future_error);
+    }
+
+    TEST_F(WorkerThreadTest, Worker_Operations_Run_Inline)
+    {
+        std::mutex                     lock;
+        std::map<int, std::thread::id> threads_ids;
+        const auto                     main_thread_id = std::this_thread::get_id();
+
+        // create workers
+        small::worker_thread<int> workers({.threads_count = 1, .run_inline = true}, [&](auto& w /*this*/, const auto& items) {
+            for (auto i : items) {
+                {
+                    std::unique_lock l(lock);
+                    threads_ids[i] = std::this_thread::get_id();
+                }
+                if (i == 2) {
+                    w.push_back(3); // from processing it is always queued
+                }
+                if (i == 4) {
+                    throw std::runtime_error("processing error");
+                }
+                if (i == 5) {
+                    small::sleep(200);
+                }
+            }
+        });
+
+        // the thread is idle so it is processed on this thread (done when push returns)
+        ASSERT_EQ(workers.push_back(1), 1);
+        ASSERT_EQ(threads_ids[1], main_thread_id);
+
+        // the exception is counted like for the threads
+        ASSERT_EQ(workers.push_back(4), 1);
+        ASSERT_EQ(workers.count_exceptions(), 1);
+
+        ASSERT_EQ(workers.push_back(2), 1);
+        while (workers.size() > 0) {
+            small::sleep(10); // wait for 3 to be taken by the thread
+        }
+        small::sleep(50);
+
+        // while an item is processed inline by another thread the limit is reached and the item is queued
+        std::thread t([&]() { workers.push_back(5); });
+        small::sleep(50);
+        workers.push_back(6);
+        t.join();
+
+        // wait to finish
+        auto ret = workers.wait();
+        ASSERT_EQ(ret, small::EnumLock::kExit);
+
+        ASSERT_EQ(threads_ids.size(), 6);
+        ASSERT_EQ(threads_ids[2], main_thread_id);
+        ASSERT_NE(threads_ids[3], main_thread_id);
+        ASSERT_NE(threads_ids[5], main_thread_id);
+        ASSERT_NE(threads_ids[6], main_thread_id);
+        ASSERT_NE(threads_ids[6], threads_ids[5]);
+    }
+
+    TEST_F(WorkerThreadTest, Worker_Operations_Run_Inline_Other_Type)
+    {
+        std::thread::id inline_thread_id;
+
+        // a worker of another type
+        small::worker_thread<std::string> workers_inline({.threads_count = 1, .run_inline = true}, [&](auto& /*this*/, const auto& /*items*/) {
+            inline_thread_id = std::this_thread::get_id();
+        });
+
+        // pushing from the processing of a worker_thread<int> is always queued (no processing inline on its thread)
+        std::thread::id           processing_thread_id;
+        small::worker_thread<int> workers({.threads_count = 1}, [&](auto& /*this*/, const auto& /*items*/) {
+            processing_thread_id = std::this_thread::get_id();
+            workers_inline.push_back("from processing");
+        });
+
+        workers.push_back(1);
+        workers.wait();
+        workers_inline.wait();
+
+        ASSERT_NE(inline_thread_id, std::thread::id{});
+        ASSERT_NE(inline_thread_id, processing_thread_id);
+    }
+
     TEST_F(WorkerThreadTest, Worker_Operations_Force_Exit)
     {
         auto timeStart = small::time_now();